@@ -0,0 +1,93 @@
+#ifndef HUFF_H
+#define HUFF_H
+
+#include <stddef.h>
+
+// libhuff: interfaz para comprimir y descomprimir buffers en memoria, sin rutas ni FILE*.
+// La salida de huff_compress es un archivo completo en el formato de un solo bloque (huff_format.h,
+// o huff_ans.h y huff_order1.h con params->backend), idéntico al que escribe huffman_processor -e con las mismas
+// opciones, y huff_decompress acepta cualquier versión del contenedor.
+//
+// Las funciones devuelven los bytes escritos en dst o HUFF_ERROR. Nunca escriben más de cap bytes.
+// Un contexto (HContext) conserva entre llamadas el árbol y las tablas de decodificación (se vuelven
+// a usar si el siguiente archivo tiene los mismos códigos) y los buffers auxiliares; un contexto no
+// se puede usar desde dos hilos a la vez, pero cada hilo puede tener el suyo.
+//
+//   size_t cap = huff_compress_bound(n);
+//   unsigned char* dst = malloc(cap);
+//   size_t len = huff_compress(src, n, dst, cap);
+//   if (huff_is_error(len)) ...
+
+// Valor de retorno de error.
+#define HUFF_ERROR ((size_t)-1)
+
+// Codificador de entropía de huff_compress_ctx.
+enum huff_coder {
+	HUFF_CODER_HUFFMAN, // Códigos de Huffman canónicos.
+	HUFF_CODER_ANS,     // rANS.
+	HUFF_CODER_ORDER1,  // Códigos de Huffman de orden 1 (texto).
+	HUFF_CODER_AUTO     // El que produzca el archivo más pequeño según el histograma.
+};
+
+// Parámetros de la compresión y la descompresión con contexto.
+struct huff_params {
+	int backend;      // Codificador (HUFF_CODER_*).
+	int max_code_len; // Longitud máxima de los códigos de Huffman (0 = la de siempre).
+	int threads;      // Hilos para descomprimir el formato por bloques (0 o 1 = uno).
+};
+
+// Nombre corto para los parámetros.
+typedef struct huff_params HParams;
+
+// Función para inicializar los parámetros con sus valores por defecto.
+static inline void huff_params_default(HParams* params) {
+	params->backend = HUFF_CODER_HUFFMAN;
+	params->max_code_len = 0;
+	params->threads = 1;
+}
+
+// Contexto reutilizable (opaco).
+struct huff_context;
+
+// Nombre corto para el contexto.
+typedef struct huff_context HContext;
+
+// Función que devuelve 1 si ret es un error.
+static inline int huff_is_error(size_t ret) {
+	return ret == HUFF_ERROR;
+}
+
+// Función que devuelve el tamaño de dst que alcanza para comprimir n bytes con cualquier backend
+// (sin diccionario: los códigos de un diccionario pueden ser más largos que 8 bits).
+size_t huff_compress_bound(size_t n);
+
+// Función para comprimir n bytes de src en dst (cap bytes) con las opciones por defecto.
+// Devuelve la longitud del archivo comprimido o HUFF_ERROR.
+size_t huff_compress(const void* src, size_t n, void* dst, size_t cap);
+
+// Función para descomprimir un archivo comprimido completo (n bytes) en dst (cap bytes).
+// Devuelve la longitud del original o HUFF_ERROR (dañado, truncado o cap insuficiente).
+size_t huff_decompress(const void* src, size_t n, void* dst, size_t cap);
+
+// Función que devuelve la longitud del original guardada en el encabezado, o HUFF_ERROR si no es
+// un archivo comprimido válido o es del formato por bloques (que no la guarda).
+size_t huff_decompressed_size(const void* src, size_t n);
+
+// Función para crear un contexto. Devuelve NULL si no hay memoria.
+HContext* huff_context_create(void);
+
+// Función para liberar el contexto y sus tablas.
+void huff_context_free(HContext* ctx);
+
+// Función para comprimir con un contexto. params puede ser NULL (valores por defecto); se usan
+// backend y max_code_len.
+size_t huff_compress_ctx(HContext* ctx, const void* src, size_t n, void* dst, size_t cap, const HParams* params);
+
+// Función para descomprimir con un contexto. params puede ser NULL; se usa threads. Los archivos
+// codificados con un diccionario (--dict) no se pueden descomprimir en memoria.
+size_t huff_decompress_ctx(HContext* ctx, const void* src, size_t n, void* dst, size_t cap, const HParams* params);
+
+// Función que devuelve la descripción del último error del contexto (vacía si no hubo error).
+const char* huff_context_error(const HContext* ctx);
+
+#endif // !HUFF_H
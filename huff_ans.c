@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "huff_ans.h"
+#include "huff_format.h"
+
+// Límite inferior de los estados: tras renormalizar, cada estado queda en [HUFF_ANS_L, 256 * HUFF_ANS_L).
+#define HUFF_ANS_L (1u << 23)
+
+// Datos de un símbolo para el codificador (división por la frecuencia con un recíproco).
+struct huff_ans_enc_sym {
+    uint32_t x_max;     // Estado a partir del cual hay que emitir un byte antes de codificar.
+    uint32_t rcp_freq;  // Recíproco de la frecuencia en punto fijo.
+    uint32_t bias;      // Inicio del símbolo (más una corrección si freq es 1).
+    uint16_t cmpl_freq; // HUFF_ANS_SCALE - freq.
+    uint16_t rcp_shift; // Desplazamiento del recíproco.
+};
+
+// Normaliza el histograma.
+void huff_ans_normalize(const uint64_t* counts, uint32_t* freqs) {
+    memset(freqs, 0, sizeof(uint32_t) * HUFF_MAX_SYMBOLS);
+    uint64_t total = 0;
+    int present[HUFF_MAX_SYMBOLS];
+    int n = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        total += counts[s];
+        if (counts[s] > 0) present[n++] = s;
+    }
+    if (n == 0) return;
+    if (n == 1) {
+        // Con toda la escala un símbolo no costaría nada y el payload no acotaría orig_len
+        // (huff_ans_decode_file): un vecino ficticio se queda con una ranura.
+        freqs[present[0]] = HUFF_ANS_SCALE - 1;
+        freqs[present[0] ^ 1] = 1;
+        return;
+    }
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        int s = present[i];
+        uint32_t f = (uint32_t)((double)counts[s] * HUFF_ANS_SCALE / (double)total + 0.5);
+        freqs[s] = f > 0 ? f : 1;
+        sum += freqs[s];
+    }
+    // Cada paso quita o suma 1 donde el costo (counts / freq, la derivada de counts * log2(1 / freq))
+    // es menor o la ganancia mayor. El redondeo deja como mucho unos pocos pasos por símbolo.
+    while (sum > HUFF_ANS_SCALE) {
+        int best = -1;
+        for (int i = 0; i < n; i++) {
+            int s = present[i];
+            if (freqs[s] > 1 && (best < 0 || (double)counts[s] * freqs[best] < (double)counts[best] * freqs[s])) best = s;
+        }
+        freqs[best]--;
+        sum--;
+    }
+    while (sum < HUFF_ANS_SCALE) {
+        int best = present[0];
+        for (int i = 1; i < n; i++) {
+            int s = present[i];
+            if ((double)counts[s] * freqs[best] > (double)counts[best] * freqs[s]) best = s;
+        }
+        freqs[best]++;
+        sum++;
+    }
+}
+
+// Bits del payload con estas frecuencias.
+double huff_ans_cost(const uint64_t* counts, const uint32_t* freqs) {
+    double bits = 0.0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (counts[s] > 0) bits += (double)counts[s] * log2((double)HUFF_ANS_SCALE / (double)freqs[s]);
+    }
+    return bits;
+}
+
+// Escribe el encabezado.
+size_t huff_ans_write_header(const uint32_t* freqs, uint64_t orig_len, unsigned char* dst) {
+    size_t pos = 0;
+    memcpy(dst, HUFF_MAGIC, HUFF_MAGIC_LEN);
+    pos += HUFF_MAGIC_LEN;
+    dst[pos++] = HUFF_ANS_VERSION;
+    dst[pos++] = 0;
+    huff_put_le(dst + pos, orig_len, 8);
+    pos += 8;
+    size_t count_pos = pos;
+    pos += 2;
+    int n_symbols = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (freqs[s] == 0) continue;
+        dst[pos] = (unsigned char)s;
+        huff_put_le(dst + pos + 1, freqs[s], 2);
+        pos += 3;
+        n_symbols++;
+    }
+    huff_put_le(dst + count_pos, (uint64_t)n_symbols, 2);
+    return pos;
+}
+
+// Lee el encabezado.
+long huff_ans_read_header(const unsigned char* src, size_t len, uint32_t* freqs, uint64_t* orig_len) {
+    memset(freqs, 0, sizeof(uint32_t) * HUFF_MAX_SYMBOLS);
+    size_t pos = HUFF_MAGIC_LEN + 2;
+    if (huff_container_version(src, len) != HUFF_ANS_VERSION || len < pos + 8 + 2) return -1;
+    *orig_len = huff_get_le(src + pos, 8);
+    pos += 8;
+    size_t n_symbols = (size_t)huff_get_le(src + pos, 2);
+    pos += 2;
+    if (n_symbols > HUFF_MAX_SYMBOLS || len - pos < 3 * n_symbols) return -1;
+    for (size_t i = 0; i < n_symbols; i++) {
+        freqs[src[pos]] = (uint32_t)huff_get_le(src + pos + 1, 2);
+        pos += 3;
+    }
+    return (long)pos;
+}
+
+// Prepara los datos de un símbolo para el codificador.
+static void huff_ans_enc_sym_init(struct huff_ans_enc_sym* sym, uint32_t start, uint32_t freq) {
+    sym->x_max = ((HUFF_ANS_L >> HUFF_ANS_SCALE_BITS) << 8) * freq;
+    sym->cmpl_freq = (uint16_t)(HUFF_ANS_SCALE - freq);
+    if (freq < 2) {
+        // x / 1 no cabe en el recíproco: con rcp = 2^32 - 1 el cociente da x - 1 y bias lo compensa.
+        sym->rcp_freq = ~0u;
+        sym->rcp_shift = 0;
+        sym->bias = start + HUFF_ANS_SCALE - 1;
+    } else {
+        uint32_t shift = 0;
+        while (freq > (1u << shift)) shift++;
+        sym->rcp_freq = (uint32_t)(((1ull << (shift + 31)) + freq - 1) / freq);
+        sym->rcp_shift = (uint16_t)(shift - 1);
+        sym->bias = start;
+    }
+}
+
+// Codifica un símbolo: emite los bytes bajos del estado hacia atrás hasta que cabe y lo actualiza.
+static inline void huff_ans_put(uint32_t* x, unsigned char** p, const struct huff_ans_enc_sym* sym) {
+    uint32_t v = *x;
+    while (v >= sym->x_max) {
+        *--(*p) = (unsigned char)v;
+        v >>= 8;
+    }
+    uint32_t q = (uint32_t)(((uint64_t)v * sym->rcp_freq) >> 32) >> sym->rcp_shift;
+    *x = v + sym->bias + q * sym->cmpl_freq;
+}
+
+// Escribe el estado hacia atrás para que el decodificador lo lea en little-endian.
+static inline void huff_ans_flush(uint32_t x, unsigned char** p) {
+    *p -= 4;
+    huff_put_le(*p, x, 4);
+}
+
+// Codifica un buffer. Los símbolos se codifican de atrás hacia adelante (el decodificador los lee
+// en el orden inverso) y los bytes se escriben desde el final de out; al terminar se mueven al principio.
+size_t huff_ans_encode(const unsigned char* data, size_t len, const uint32_t* freqs, unsigned char* out) {
+    struct huff_ans_enc_sym syms[HUFF_MAX_SYMBOLS];
+    uint32_t start = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (freqs[s] > 0) huff_ans_enc_sym_init(&syms[s], start, freqs[s]);
+        start += freqs[s];
+    }
+    unsigned char* end = out + HUFF_ANS_BOUND(len);
+    unsigned char* p = end;
+    uint32_t x0 = HUFF_ANS_L, x1 = HUFF_ANS_L;
+    size_t i = len;
+    if (i & 1) {
+        // El último símbolo de una longitud impar es del estado de los pares.
+        huff_ans_put(&x0, &p, &syms[data[i - 1]]);
+        i--;
+    }
+    for (; i > 0; i -= 2) {
+        huff_ans_put(&x1, &p, &syms[data[i - 1]]);
+        huff_ans_put(&x0, &p, &syms[data[i - 2]]);
+    }
+    huff_ans_flush(x1, &p);
+    huff_ans_flush(x0, &p);
+    size_t n = (size_t)(end - p);
+    memmove(out, p, n);
+    return n;
+}
+
+// Arma la tabla del decodificador.
+int huff_ans_decoder_table(HAnsDecoder* dec, const uint32_t* freqs) {
+    uint32_t start = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (freqs[s] > HUFF_ANS_SCALE - start) return -1;
+        for (uint32_t k = 0; k < freqs[s]; k++) {
+            struct huff_ans_entry* e = &dec->table[start + k];
+            e->freq = (uint16_t)freqs[s];
+            e->offset = (uint16_t)k;
+            e->symbol = (unsigned char)s;
+        }
+        start += freqs[s];
+    }
+    return start == HUFF_ANS_SCALE ? 0 : -1;
+}
+
+// Lee los estados iniciales del payload.
+int huff_ans_decoder_start(HAnsDecoder* dec, const unsigned char* payload, size_t len) {
+    if (len < 8) return -1;
+    dec->x[0] = (uint32_t)huff_get_le(payload, 4);
+    dec->x[1] = (uint32_t)huff_get_le(payload + 4, 4);
+    dec->p = payload + 8;
+    dec->end = payload + len;
+    return 0;
+}
+
+// Inicia el decodificador.
+int huff_ans_decoder_init(HAnsDecoder* dec, const uint32_t* freqs, const unsigned char* payload, size_t len) {
+    if (huff_ans_decoder_table(dec, freqs) != 0) return -1;
+    return huff_ans_decoder_start(dec, payload, len);
+}
+
+// Decodifica un símbolo del estado x (sin renormalizarlo).
+static inline unsigned char huff_ans_get(const struct huff_ans_entry* table, uint32_t* x) {
+    const struct huff_ans_entry* e = &table[*x & (HUFF_ANS_SCALE - 1)];
+    *x = (uint32_t)e->freq * (*x >> HUFF_ANS_SCALE_BITS) + e->offset;
+    return e->symbol;
+}
+
+// Lee bytes hasta que el estado vuelve a [HUFF_ANS_L, 256 * HUFF_ANS_L). Como freq >= 1 y el
+// estado era al menos HUFF_ANS_L, tras decodificar vale al menos 2^(23 - HUFF_ANS_SCALE_BITS):
+// nunca hacen falta más de dos bytes.
+// Sin saltos: el número de bytes depende de los datos y un salto se predeciría mal.
+static inline void huff_ans_renorm(uint32_t* x, const unsigned char** p) {
+    for (int k = 0; k < 2; k++) {
+        int more = *x < HUFF_ANS_L;
+        uint32_t shifted = (*x << 8) | **p;
+        *x = more ? shifted : *x;
+        *p += more;
+    }
+}
+
+// Igual que huff_ans_renorm, pero sin pasar de end. Devuelve -1 si faltan bytes.
+static inline int huff_ans_renorm_checked(uint32_t* x, const unsigned char** p, const unsigned char* end) {
+    while (*x < HUFF_ANS_L) {
+        if (*p == end) return -1;
+        *x = (*x << 8) | *(*p)++;
+    }
+    return 0;
+}
+
+// Decodifica los n símbolos siguientes. El estado y el puntero viven en variables locales: out
+// puede apuntar a cualquier cosa, y una escritura en out obligaría a releerlos de dec.
+int huff_ans_decode(HAnsDecoder* dec, unsigned char* out, size_t n) {
+    const struct huff_ans_entry* table = dec->table;
+    const unsigned char* p = dec->p;
+    const unsigned char* end = dec->end;
+    uint32_t x0 = dec->x[0], x1 = dec->x[1];
+    size_t i = 0;
+    int ret = 0;
+    // Mientras queden al menos 4 bytes las dos renormalizaciones no pueden pasarse del final.
+    for (; i + 2 <= n && end - p >= 4; i += 2) {
+        out[i] = huff_ans_get(table, &x0);
+        out[i + 1] = huff_ans_get(table, &x1);
+        huff_ans_renorm(&x0, &p);
+        huff_ans_renorm(&x1, &p);
+    }
+    for (; i + 2 <= n && ret == 0; i += 2) {
+        out[i] = huff_ans_get(table, &x0);
+        out[i + 1] = huff_ans_get(table, &x1);
+        ret = huff_ans_renorm_checked(&x0, &p, end) | huff_ans_renorm_checked(&x1, &p, end);
+    }
+    if (i < n && ret == 0) {
+        out[i] = huff_ans_get(table, &x0);
+        ret = huff_ans_renorm_checked(&x0, &p, end);
+    }
+    dec->p = p;
+    dec->x[0] = x0;
+    dec->x[1] = x1;
+    return ret;
+}
+
+// Comprueba el final del payload.
+int huff_ans_decoder_finish(const HAnsDecoder* dec) {
+    return dec->p == dec->end && dec->x[0] == HUFF_ANS_L && dec->x[1] == HUFF_ANS_L ? 0 : -1;
+}
+
+// Escribe un archivo completo.
+int huff_ans_encode_file(const unsigned char* data, size_t len, const uint32_t* freqs, FILE* f_out) {
+    unsigned char header[HUFF_ANS_HEADER_MAX_SIZE];
+    size_t header_len = huff_ans_write_header(freqs, (uint64_t)len, header);
+    unsigned char* out = (unsigned char*)malloc(HUFF_ANS_BOUND(len));
+    if (out == NULL) return -1;
+    size_t n = huff_ans_encode(data, len, freqs, out);
+    int ret = fwrite(header, 1, header_len, f_out) == header_len && fwrite(out, 1, n, f_out) == n ? 0 : -1;
+    free(out);
+    return ret;
+}
+
+// Comprueba que el payload pueda contener orig_len símbolos. Cada símbolo cuesta al menos
+// log2(HUFF_ANS_SCALE / max_freq) bits: un orig_len que el payload no puede contener es un
+// encabezado dañado, y se rechaza antes de escribir nada.
+int huff_ans_length_fits(const uint32_t* freqs, uint64_t orig_len, size_t payload_len) {
+    uint32_t max_freq = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (freqs[s] > max_freq) max_freq = freqs[s];
+    }
+    double payload_bits = 8.0 * (double)payload_len + 64.0;
+    if (max_freq == 0 || max_freq >= HUFF_ANS_SCALE ||
+        (double)orig_len * log2((double)HUFF_ANS_SCALE / (double)max_freq) > payload_bits) return -1;
+    return 0;
+}
+
+// Decodifica un rango de un archivo en memoria, en trozos de HUFF_IO_BUFFER_SIZE bytes.
+int huff_ans_decode_file(const unsigned char* in, size_t in_len, uint64_t offset, uint64_t length,
+                         FILE* f_out, HFileResult* res) {
+    uint32_t freqs[HUFF_MAX_SYMBOLS];
+    uint64_t orig_len = 0;
+    long header_len = huff_ans_read_header(in, in_len, freqs, &orig_len);
+    if (header_len < 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid header");
+        return -1;
+    }
+    if (offset > orig_len) {
+        snprintf(res->msg, sizeof(res->msg), "offset beyond end of file");
+        return -1;
+    }
+    uint64_t end = orig_len - offset < length ? orig_len : offset + length;
+    if (orig_len == 0) return 0;
+    if (huff_ans_length_fits(freqs, orig_len, in_len - (size_t)header_len) != 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid symbol frequencies or length");
+        return -1;
+    }
+    HAnsDecoder* dec = (HAnsDecoder*)malloc(sizeof(HAnsDecoder));
+    unsigned char* out = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    int ret = -1;
+    if (dec == NULL || out == NULL) {
+        snprintf(res->msg, sizeof(res->msg), "out of memory");
+    } else if (huff_ans_decoder_init(dec, freqs, in + header_len, in_len - (size_t)header_len) != 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid symbol frequencies");
+    } else {
+        // Sin puntos de control: un rango se decodifica desde el principio.
+        uint64_t done = 0;
+        ret = 0;
+        while (done < end && ret == 0) {
+            size_t n = end - done < HUFF_IO_BUFFER_SIZE ? (size_t)(end - done) : HUFF_IO_BUFFER_SIZE;
+            if (huff_ans_decode(dec, out, n) != 0) {
+                snprintf(res->msg, sizeof(res->msg), "truncated or corrupt data");
+                ret = -1;
+            } else if (done + n > offset) {
+                size_t skip = done < offset ? (size_t)(offset - done) : 0;
+                if (fwrite(out + skip, 1, n - skip, f_out) != n - skip) {
+                    snprintf(res->msg, sizeof(res->msg), "cannot write output");
+                    ret = -1;
+                } else {
+                    res->bytes_out += n - skip;
+                }
+            }
+            done += n;
+        }
+        if (ret == 0 && end == orig_len && huff_ans_decoder_finish(dec) != 0) {
+            snprintf(res->msg, sizeof(res->msg), "truncated or corrupt data");
+            ret = -1;
+        }
+    }
+    free(out);
+    free(dec);
+    return ret;
+}
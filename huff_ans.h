@@ -0,0 +1,99 @@
+#ifndef HUFF_ANS_H
+#define HUFF_ANS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_const.h"
+#include "huff_result.h"
+
+// Codificador de entropía alternativo a Huffman: rANS (asymmetric numeral systems) con tablas.
+// Las frecuencias se normalizan para sumar HUFF_ANS_SCALE, y cada símbolo cuesta
+// log2(HUFF_ANS_SCALE / freq) bits: una fracción de bit, en lugar del número entero de bits de un
+// código de Huffman, que en datos sesgados desperdicia hasta un bit por símbolo. Dos estados de
+// 32 bits se alternan (símbolos pares e impares) sobre el mismo flujo de bytes para que el
+// decodificador avance los dos en el mismo ciclo.
+//
+// Formato del archivo (versión HUFF_ANS_VERSION del contenedor de huff_format.h, little-endian):
+//
+//   magic        4 bytes  "HUFZ"
+//   version      1 byte   HUFF_ANS_VERSION
+//   flags        1 byte   0
+//   orig_len     8 bytes  longitud del archivo original
+//   n_symbols    2 bytes  símbolos con frecuencia distinta de cero
+//   frecuencias  n_symbols tríos (símbolo 1 byte, frecuencia 2 bytes)
+//   payload      los dos estados iniciales del decodificador (4 bytes cada uno) y los bytes que
+//                renormalizan los estados, en el orden en que se leen
+#define HUFF_ANS_SCALE (1u << HUFF_ANS_SCALE_BITS)
+
+// Tamaño máximo del encabezado.
+#define HUFF_ANS_HEADER_MAX_SIZE (4 + 1 + 1 + 8 + 2 + 3 * HUFF_MAX_SYMBOLS)
+
+// Cota del payload: un símbolo cuesta como mucho HUFF_ANS_SCALE_BITS bits, más los dos estados.
+#define HUFF_ANS_BOUND(n) ((size_t)(n) * HUFF_ANS_SCALE_BITS / 8 + 16)
+
+// Entrada de la tabla de decodificación: el símbolo de cada ranura del estado.
+struct huff_ans_entry {
+	uint16_t      freq;   // Frecuencia normalizada del símbolo.
+	uint16_t      offset; // Ranura menos el inicio del símbolo.
+	unsigned char symbol; // Símbolo.
+};
+
+// Decodificador incremental de un payload rANS.
+struct huff_ans_decoder {
+	uint32_t             x[2];                   // Estados de los símbolos pares e impares.
+	const unsigned char* p;                      // Siguiente byte del payload.
+	const unsigned char* end;                    // Fin del payload.
+	struct huff_ans_entry table[HUFF_ANS_SCALE]; // Símbolo de cada ranura.
+};
+
+// Nombre corto para el decodificador.
+typedef struct huff_ans_decoder HAnsDecoder;
+
+// Función para normalizar el histograma a frecuencias que suman HUFF_ANS_SCALE. Todo símbolo que
+// aparece recibe al menos 1; el redondeo se corrige en los símbolos donde cuesta menos.
+void huff_ans_normalize(const uint64_t* counts, uint32_t* freqs);
+
+// Función que devuelve los bits del payload que producen las frecuencias con el histograma.
+double huff_ans_cost(const uint64_t* counts, const uint32_t* freqs);
+
+// Función para escribir el encabezado en dst (HUFF_ANS_HEADER_MAX_SIZE bytes). Devuelve su longitud.
+size_t huff_ans_write_header(const uint32_t* freqs, uint64_t orig_len, unsigned char* dst);
+
+// Función para leer el encabezado. Devuelve los bytes consumidos o -1 si no es válido.
+long huff_ans_read_header(const unsigned char* src, size_t len, uint32_t* freqs, uint64_t* orig_len);
+
+// Función para codificar len bytes en out (HUFF_ANS_BOUND(len) bytes). Devuelve la longitud del payload.
+size_t huff_ans_encode(const unsigned char* data, size_t len, const uint32_t* freqs, unsigned char* out);
+
+// Función para armar la tabla del decodificador con las frecuencias. Devuelve 0, o -1 si no suman
+// HUFF_ANS_SCALE. La tabla sirve para cualquier payload con las mismas frecuencias.
+int huff_ans_decoder_table(HAnsDecoder* dec, const uint32_t* freqs);
+
+// Función para empezar a decodificar un payload con la tabla ya armada. Devuelve 0, o -1 si el
+// payload es demasiado corto.
+int huff_ans_decoder_start(HAnsDecoder* dec, const unsigned char* payload, size_t len);
+
+// Función para iniciar el decodificador sobre un payload (tabla y estados). Devuelve 0, o -1 si
+// las frecuencias no suman HUFF_ANS_SCALE o el payload es demasiado corto.
+int huff_ans_decoder_init(HAnsDecoder* dec, const uint32_t* freqs, const unsigned char* payload, size_t len);
+
+// Función para decodificar los n símbolos siguientes. n debe ser par salvo en la última llamada.
+// Devuelve 0, o -1 si el payload se terminó antes.
+int huff_ans_decode(HAnsDecoder* dec, unsigned char* out, size_t n);
+
+// Función que comprueba que se consumió todo el payload y los estados volvieron al inicial.
+int huff_ans_decoder_finish(const HAnsDecoder* dec);
+
+// Función que comprueba que un payload de payload_len bytes pueda contener orig_len símbolos con
+// las frecuencias de un encabezado. Devuelve 0, o -1 si el encabezado está dañado.
+int huff_ans_length_fits(const uint32_t* freqs, uint64_t orig_len, size_t payload_len);
+
+// Función para escribir en f_out un archivo completo (encabezado y payload). Devuelve 0 o -1.
+int huff_ans_encode_file(const unsigned char* data, size_t len, const uint32_t* freqs, FILE* f_out);
+
+// Función para decodificar los bytes [offset, offset + length) de un archivo en memoria y
+// escribirlos en f_out. Suma a res->bytes_out los bytes escritos. Devuelve 0 o -1 con res->msg.
+int huff_ans_decode_file(const unsigned char* in, size_t in_len, uint64_t offset, uint64_t length,
+                         FILE* f_out, HFileResult* res);
+
+#endif // !HUFF_ANS_H
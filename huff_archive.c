@@ -0,0 +1,320 @@
+#define _GNU_SOURCE // open_memstream
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "huff_archive.h"
+#include "huff_format.h"
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_const.h"
+
+// Bytes fijos de una entrada del índice (sin el nombre).
+#define HUFF_ARCHIVE_ENTRY_SIZE (8 + 8 + 8 + 2)
+
+// Nombre de la entrada de un archivo: la ruta sin el directorio.
+static const char* huff_archive_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+// Estado compartido por los hilos que llenan el archivo único.
+struct huff_archive_writer {
+    HBatch*         batch;
+    FILE*           out;
+    const char*     path;
+    uint64_t        pos;         // Próxima posición libre del archivo único.
+    uint64_t*       offset;      // Posición de la entrada de cada trabajo.
+    uint64_t*       comp_len;    // Longitud de la entrada de cada trabajo.
+    int             write_error; // 1 si falló una escritura en el archivo único.
+    pthread_mutex_t lock;        // Protege pos, out y write_error.
+};
+
+// Codifica el trabajo idx en memoria y lo agrega al archivo único.
+static void huff_archive_add(struct huff_archive_writer* w, size_t idx) {
+    HJob* job = &w->batch->jobs[idx];
+    HFileResult* res = &job->result;
+    HInput input;
+    if (huff_input_open(job->input_path, &input) != 0) {
+        memset(res, 0, sizeof(*res));
+        res->status = -1;
+        if (snprintf(res->msg, sizeof(res->msg), "Cannot open %s", job->input_path) >= (int)sizeof(res->msg)) {
+            snprintf(res->msg, sizeof(res->msg), "Cannot open input");
+        }
+        return;
+    }
+    char* buf = NULL;
+    size_t buf_len = 0;
+    FILE* mem = open_memstream(&buf, &buf_len);
+    if (mem == NULL) {
+        memset(res, 0, sizeof(*res));
+        res->status = -1;
+        snprintf(res->msg, sizeof(res->msg), "out of memory");
+        huff_input_close(&input);
+        return;
+    }
+    int ret = huff_encode_memory_r(input.data, input.len, job->input_path, mem, w->path, NULL, w->batch->opts, res);
+    huff_input_close(&input);
+    if (fclose(mem) != 0 && ret == 0) {
+        snprintf(res->msg, sizeof(res->msg), "out of memory");
+        ret = -1;
+    }
+    if (ret == 0) {
+        // Solo la escritura se hace con el cerrojo: los hilos codifican a la vez.
+        pthread_mutex_lock(&w->lock);
+        if (w->write_error || fwrite(buf, 1, buf_len, w->out) != buf_len) {
+            w->write_error = 1;
+            snprintf(res->msg, sizeof(res->msg), "Cannot write %s", w->path);
+            ret = -1;
+        } else {
+            w->offset[idx] = w->pos;
+            w->comp_len[idx] = buf_len;
+            w->pos += buf_len;
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    res->status = ret;
+    free(buf);
+}
+
+// Codifica el trabajo idx del pool (huff_batch_run_pool) en el archivo único.
+static void huff_archive_writer_run(HBatch* batch, size_t idx, void* arg) {
+    (void)batch;
+    huff_archive_add((struct huff_archive_writer*)arg, idx);
+}
+
+// Entrada del índice mientras se escribe: el trabajo y su nombre.
+struct huff_archive_toc_item {
+    const char* name;
+    size_t      idx;
+};
+
+// Compara dos entradas del índice por nombre.
+static int huff_archive_toc_compare(const void* a, const void* b) {
+    return strcmp(((const struct huff_archive_toc_item*)a)->name, ((const struct huff_archive_toc_item*)b)->name);
+}
+
+// Escribe el índice de los trabajos que terminaron bien. Devuelve sus bytes, o 0 si falló.
+static uint64_t huff_archive_write_toc(struct huff_archive_writer* w) {
+    HBatch* batch = w->batch;
+    struct huff_archive_toc_item* items = (struct huff_archive_toc_item*)malloc(sizeof(*items) * (batch->count ? batch->count : 1));
+    if (items == NULL) return 0;
+    size_t n = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (batch->jobs[i].result.status != 0) continue;
+        items[n].name = huff_archive_name(batch->jobs[i].input_path);
+        items[n].idx = i;
+        n++;
+    }
+    qsort(items, n, sizeof(*items), huff_archive_toc_compare);
+    unsigned char buf[HUFF_ARCHIVE_ENTRY_SIZE + HUFF_PATH_MAX];
+    huff_put_le(buf, (uint64_t)n, 4);
+    int ok = fwrite(buf, 1, 4, w->out) == 4;
+    uint64_t toc_len = 4;
+    for (size_t k = 0; k < n && ok; k++) {
+        size_t idx = items[k].idx;
+        size_t name_len = strlen(items[k].name);
+        huff_put_le(buf, (uint64_t)batch->jobs[idx].result.bytes_in, 8);
+        huff_put_le(buf + 8, w->offset[idx], 8);
+        huff_put_le(buf + 16, w->comp_len[idx], 8);
+        huff_put_le(buf + 24, (uint64_t)name_len, 2);
+        memcpy(buf + HUFF_ARCHIVE_ENTRY_SIZE, items[k].name, name_len);
+        ok = fwrite(buf, 1, HUFF_ARCHIVE_ENTRY_SIZE + name_len, w->out) == HUFF_ARCHIVE_ENTRY_SIZE + name_len;
+        toc_len += HUFF_ARCHIVE_ENTRY_SIZE + name_len;
+    }
+    free(items);
+    return ok ? toc_len : 0;
+}
+
+// Escribe el encabezado; con toc_offset 0 marca un archivo sin terminar.
+static int huff_archive_write_header(FILE* out, uint64_t toc_offset, uint64_t toc_len) {
+    unsigned char header[HUFF_ARCHIVE_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, HUFF_ARCHIVE_MAGIC, HUFF_ARCHIVE_MAGIC_LEN);
+    header[HUFF_ARCHIVE_MAGIC_LEN] = HUFF_ARCHIVE_VERSION;
+    huff_put_le(header + 8, toc_offset, 8);
+    huff_put_le(header + 16, toc_len, 8);
+    return fwrite(header, 1, sizeof(header), out) == sizeof(header) ? 0 : -1;
+}
+
+// Comprime el lote en un archivo único.
+int huff_archive_create(HBatch* batch, const char* archive_path, int n_threads) {
+    struct huff_archive_writer w;
+    memset(&w, 0, sizeof(w));
+    w.batch = batch;
+    w.path = archive_path;
+    w.pos = HUFF_ARCHIVE_HEADER_SIZE;
+    w.offset = (uint64_t*)calloc(batch->count ? batch->count : 1, sizeof(uint64_t));
+    w.comp_len = (uint64_t*)calloc(batch->count ? batch->count : 1, sizeof(uint64_t));
+    w.out = fopen(archive_path, "wb");
+    if (w.offset == NULL || w.comp_len == NULL || w.out == NULL) {
+        if (w.out != NULL) fclose(w.out);
+        free(w.offset);
+        free(w.comp_len);
+        return -1;
+    }
+    setvbuf(w.out, NULL, _IOFBF, HUFF_IO_BUFFER_SIZE); // Pocas escrituras grandes aunque las entradas sean chicas.
+    pthread_mutex_init(&w.lock, NULL);
+    if (huff_archive_write_header(w.out, 0, 0) != 0) w.write_error = 1;
+    int failed = huff_batch_run_pool(batch, n_threads, huff_archive_writer_run, &w);
+    pthread_mutex_destroy(&w.lock);
+
+    uint64_t toc_len = w.write_error ? 0 : huff_archive_write_toc(&w);
+    if (toc_len == 0 || fflush(w.out) != 0 || fseeko(w.out, 0, SEEK_SET) != 0 ||
+        huff_archive_write_header(w.out, w.pos, toc_len) != 0) {
+        w.write_error = 1;
+    }
+    if (fclose(w.out) != 0) w.write_error = 1;
+    free(w.offset);
+    free(w.comp_len);
+    return w.write_error ? -1 : failed;
+}
+
+// Abre un archivo único y lee su índice.
+int huff_archive_open(const char* path, HArchive* ar) {
+    memset(ar, 0, sizeof(*ar));
+    if (huff_input_open(path, &ar->input) != 0) return -1;
+    // Se leen el índice y algunas entradas: la lectura anticipada de todo el archivo sobra.
+    if (ar->input.mapped) madvise((void*)ar->input.data, ar->input.len, MADV_RANDOM);
+    const unsigned char* data = ar->input.data;
+    size_t len = ar->input.len;
+    if (len < HUFF_ARCHIVE_HEADER_SIZE || memcmp(data, HUFF_ARCHIVE_MAGIC, HUFF_ARCHIVE_MAGIC_LEN) != 0 ||
+        data[HUFF_ARCHIVE_MAGIC_LEN] != HUFF_ARCHIVE_VERSION) {
+        huff_archive_close(ar);
+        return -1;
+    }
+    uint64_t toc_offset = huff_get_le(data + 8, 8);
+    uint64_t toc_len = huff_get_le(data + 16, 8);
+    if (toc_offset < HUFF_ARCHIVE_HEADER_SIZE || toc_offset > len || toc_len < 4 || toc_len > len - toc_offset) {
+        huff_archive_close(ar);
+        return -1;
+    }
+    const unsigned char* p = data + toc_offset;
+    const unsigned char* end = p + toc_len;
+    uint64_t n = huff_get_le(p, 4);
+    p += 4;
+    if (n > (toc_len - 4) / HUFF_ARCHIVE_ENTRY_SIZE) {
+        huff_archive_close(ar);
+        return -1;
+    }
+    // Cada nombre ocupa en el índice lo mismo que en names, más los bytes fijos de la entrada.
+    ar->entries = (HArchiveEntry*)malloc(sizeof(HArchiveEntry) * (n ? n : 1));
+    ar->names = (char*)malloc(toc_len);
+    if (ar->entries == NULL || ar->names == NULL) {
+        huff_archive_close(ar);
+        return -1;
+    }
+    char* name = ar->names;
+    for (size_t i = 0; i < n; i++) {
+        if ((size_t)(end - p) < HUFF_ARCHIVE_ENTRY_SIZE) break;
+        HArchiveEntry* e = &ar->entries[i];
+        e->orig_len = huff_get_le(p, 8);
+        e->offset = huff_get_le(p + 8, 8);
+        e->comp_len = huff_get_le(p + 16, 8);
+        size_t name_len = (size_t)huff_get_le(p + 24, 2);
+        p += HUFF_ARCHIVE_ENTRY_SIZE;
+        // Las entradas están entre el encabezado y el índice, y los nombres ordenados y sin '\0'.
+        if ((size_t)(end - p) < name_len || name_len == 0 || memchr(p, '\0', name_len) != NULL ||
+            e->offset < HUFF_ARCHIVE_HEADER_SIZE || e->offset > toc_offset || e->comp_len > toc_offset - e->offset) {
+            break;
+        }
+        memcpy(name, p, name_len);
+        name[name_len] = '\0';
+        p += name_len;
+        e->name = name;
+        name += name_len + 1;
+        if (i > 0 && strcmp(ar->entries[i - 1].name, e->name) >= 0) break;
+        ar->n_entries++;
+    }
+    if (ar->n_entries != n || p != end) {
+        huff_archive_close(ar);
+        return -1;
+    }
+    return 0;
+}
+
+// Cierra el archivo único.
+void huff_archive_close(HArchive* ar) {
+    huff_input_close(&ar->input);
+    free(ar->entries);
+    free(ar->names);
+    memset(ar, 0, sizeof(*ar));
+}
+
+// Busca una entrada por nombre.
+const HArchiveEntry* huff_archive_find(const HArchive* ar, const char* name) {
+    size_t lo = 0, hi = ar->n_entries;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(ar->entries[mid].name, name);
+        if (cmp == 0) return &ar->entries[mid];
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// Decodifica una entrada.
+int huff_archive_extract_entry(const HArchive* ar, const HArchiveEntry* entry, FILE* f_out, const HOptions* opts, HFileResult* res) {
+    int ret = huff_decode_memory_r(ar->input.data + entry->offset, (size_t)entry->comp_len, entry->name, NULL, f_out, opts, res);
+    // En una tubería ftell no da la longitud; el decodificador ya comprobó la del encabezado.
+    if (ret == 0 && ftell(f_out) < 0) res->bytes_out = (size_t)entry->orig_len;
+    if (ret == 0 && res->bytes_out != entry->orig_len) {
+        snprintf(res->msg, sizeof(res->msg), "length mismatch (%zu of %llu bytes)", res->bytes_out,
+                 (unsigned long long)entry->orig_len);
+        res->status = -1;
+        ret = -1;
+    }
+    return ret;
+}
+
+// Extrae la entrada idx del archivo único arg en el trabajo idx del pool (huff_batch_run_pool).
+static void huff_archive_reader_run(HBatch* batch, size_t idx, void* arg) {
+    const HArchive* ar = (const HArchive*)arg;
+    HJob* job = &batch->jobs[idx];
+    const HArchiveEntry* entry = &ar->entries[idx];
+    memset(&job->result, 0, sizeof(job->result));
+    job->result.status = -1;
+    FILE* f_out = NULL;
+    if (strchr(entry->name, '/') != NULL || strcmp(entry->name, ".") == 0 || strcmp(entry->name, "..") == 0) {
+        // Un nombre así escribiría fuera del directorio de salida.
+        snprintf(job->result.msg, sizeof(job->result.msg), "unsafe entry name");
+    } else if (job->output_path[0] == '\0') {
+        snprintf(job->result.msg, sizeof(job->result.msg), "path too long");
+    } else if ((f_out = fopen(job->output_path, "wb")) == NULL) {
+        if (snprintf(job->result.msg, sizeof(job->result.msg), "Cannot open %s", job->output_path) >=
+            (int)sizeof(job->result.msg)) {
+            snprintf(job->result.msg, sizeof(job->result.msg), "Cannot open output");
+        }
+    } else {
+        int ret = huff_archive_extract_entry(ar, entry, f_out, batch->opts, &job->result);
+        if (fclose(f_out) != 0 && ret == 0) {
+            if (snprintf(job->result.msg, sizeof(job->result.msg), "Cannot write %s", job->output_path) >=
+                (int)sizeof(job->result.msg)) {
+                snprintf(job->result.msg, sizeof(job->result.msg), "Cannot write output");
+            }
+            job->result.status = -1;
+        }
+    }
+}
+
+// Extrae todas las entradas.
+int huff_archive_extract_all(HBatch* batch, const HArchive* ar, const char* output_dir, int n_threads) {
+    batch->jobs = (HJob*)calloc(ar->n_entries ? ar->n_entries : 1, sizeof(HJob));
+    if (batch->jobs == NULL) return -1;
+    batch->count = ar->n_entries;
+    batch->encode = 0;
+    for (size_t i = 0; i < ar->n_entries; i++) {
+        HJob* job = &batch->jobs[i];
+        snprintf(job->input_path, sizeof(job->input_path), "%s", ar->entries[i].name);
+        // Sin ruta de salida (no cabe en HUFF_PATH_MAX) la entrada falla con "path too long".
+        if (snprintf(job->output_path, sizeof(job->output_path), "%s/%s", output_dir, ar->entries[i].name) >=
+            (int)sizeof(job->output_path)) {
+            job->output_path[0] = '\0';
+        }
+        job->size = (long long)ar->entries[i].comp_len;
+    }
+    // El trabajo i es la entrada i.
+    return huff_batch_run_pool(batch, n_threads, huff_archive_reader_run, (void*)ar);
+}
@@ -0,0 +1,82 @@
+#ifndef HUFF_ARCHIVE_H
+#define HUFF_ARCHIVE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_batch.h"
+#include "huff_io.h"
+#include "huff_options.h"
+#include "huff_result.h"
+
+// Archivo único con todos los archivos de un directorio: en lugar de crear un archivo comprimido
+// por cada entrada (y un inodo, una entrada de directorio y sus llamadas al sistema), las entradas
+// comprimidas se escriben una detrás de otra y un índice al final guarda dónde está cada una.
+// Formato (enteros en little-endian):
+//
+//   magic       4 bytes  "HUFA"
+//   version     1 byte   HUFF_ARCHIVE_VERSION
+//   flags       1 byte   0
+//   reservado   2 bytes  0
+//   toc_offset  8 bytes  posición del índice (0 = el archivo no se terminó de escribir)
+//   toc_len     8 bytes  bytes del índice
+//   entradas    cada archivo comprimido completo (huff_format.h, cualquier versión), sin separadores
+//   índice      n_entries 4 bytes y, por entrada, ordenadas por nombre (bytes sin signo):
+//               orig_len 8 bytes, offset 8 bytes, comp_len 8 bytes, name_len 2 bytes, nombre
+//
+// El encabezado se reescribe al terminar, así que un archivo interrumpido no parece válido. Para
+// listar o extraer una entrada basta con leer el encabezado, el índice y los bytes de esa entrada.
+#define HUFF_ARCHIVE_MAGIC "HUFA"
+#define HUFF_ARCHIVE_MAGIC_LEN 4
+#define HUFF_ARCHIVE_VERSION 1
+
+// Tamaño del encabezado.
+#define HUFF_ARCHIVE_HEADER_SIZE (HUFF_ARCHIVE_MAGIC_LEN + 1 + 1 + 2 + 8 + 8)
+
+// Una entrada del índice.
+struct huff_archive_entry {
+	const char* name;     // Nombre del archivo original, sin directorio.
+	uint64_t    orig_len; // Longitud del archivo original.
+	uint64_t    offset;   // Posición del archivo comprimido dentro del archivo único.
+	uint64_t    comp_len; // Longitud del archivo comprimido.
+};
+
+// Nombre corto para una entrada.
+typedef struct huff_archive_entry HArchiveEntry;
+
+// Archivo único abierto para leer.
+struct huff_archive {
+	HInput         input;     // Contenido mapeado: solo se leen del disco las páginas que se usan.
+	HArchiveEntry* entries;   // Entradas ordenadas por nombre.
+	size_t         n_entries; // Número de entradas.
+	char*          names;     // Nombres de todas las entradas, cada uno terminado en '\0'.
+};
+
+// Nombre corto para el archivo único.
+typedef struct huff_archive HArchive;
+
+// Función para comprimir todos los archivos del lote (huff_batch_scan) en archive_path con
+// n_threads hilos. Cada hilo codifica un archivo en memoria y lo agrega al final del archivo único;
+// el índice se escribe al terminar. Informa cada archivo como huff_batch_report_job. Devuelve el
+// número de archivos que fallaron (esos quedan fuera del índice), o -1 si no se pudo escribir
+// archive_path.
+int huff_archive_create(HBatch* batch, const char* archive_path, int n_threads);
+
+// Función para abrir un archivo único y leer su índice. Devuelve 0, o -1 si no se puede leer o
+// no es un archivo único completo y válido.
+int huff_archive_open(const char* path, HArchive* ar);
+
+// Función para cerrar el archivo único.
+void huff_archive_close(HArchive* ar);
+
+// Función para buscar una entrada por nombre (búsqueda binaria en el índice). Devuelve NULL si no existe.
+const HArchiveEntry* huff_archive_find(const HArchive* ar, const char* name);
+
+// Función para decodificar una entrada en f_out. Devuelve 0 o -1 con res->msg.
+int huff_archive_extract_entry(const HArchive* ar, const HArchiveEntry* entry, FILE* f_out, const HOptions* opts, HFileResult* res);
+
+// Función para extraer todas las entradas en output_dir con n_threads hilos. batch (con report,
+// stats y opts ya puestos) recibe un trabajo por entrada, para informarlas y resumirlas como un
+// lote. Devuelve el número de entradas que fallaron, o -1 si no hay memoria para el lote.
+int huff_archive_extract_all(HBatch* batch, const HArchive* ar, const char* output_dir, int n_threads);
+
+#endif // !HUFF_ARCHIVE_H
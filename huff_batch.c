@@ -0,0 +1,371 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "huff_batch.h"
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_stats.h"
+
+// Compara dos trabajos para ordenarlos de mayor a menor tamaño.
+static int compare_job_size_desc(const void* a, const void* b) {
+    const HJob* ja = (const HJob*)a;
+    const HJob* jb = (const HJob*)b;
+    if (ja->size < jb->size) return 1;
+    if (ja->size > jb->size) return -1;
+    return strcmp(ja->input_path, jb->input_path); // Orden estable entre archivos del mismo tamaño.
+}
+
+// Función para recorrer el directorio de entrada y construir la lista de trabajos.
+int huff_batch_scan(HBatch* batch, int encode, const char* input_dir, const char* output_dir, const char* codebooks_dir) {
+    memset(batch, 0, sizeof(*batch));
+    batch->encode = encode;
+    batch->codebooks_dir = codebooks_dir;
+    batch->report = stdout;
+
+    DIR* dir = opendir(input_dir);
+    if (dir == NULL) {
+        return -1;
+    }
+    size_t capacity = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        if (batch->count == capacity) { // Crece el arreglo de trabajos al doble.
+            size_t new_capacity = capacity ? capacity * 2 : 64;
+            HJob* jobs = (HJob*)realloc(batch->jobs, new_capacity * sizeof(HJob));
+            if (jobs == NULL) {
+                closedir(dir);
+                huff_batch_free(batch);
+                return -1;
+            }
+            batch->jobs = jobs;
+            capacity = new_capacity;
+        }
+        HJob* job = &batch->jobs[batch->count];
+        memset(job, 0, sizeof(*job));
+        // Una ruta recortada abriría o escribiría otro archivo: el lote no se arma.
+        if (snprintf(job->input_path, sizeof(job->input_path), "%s/%s", input_dir, entry->d_name) >= (int)sizeof(job->input_path) ||
+            snprintf(job->output_path, sizeof(job->output_path), "%s/%s", output_dir, entry->d_name) >= (int)sizeof(job->output_path)) {
+            closedir(dir);
+            huff_batch_free(batch);
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+
+        struct stat st;
+        if (stat(job->input_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue; // Ignora subdirectorios y entradas que no se pueden leer.
+        }
+        job->size = (long long)st.st_size;
+        job->mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+        if (!encode && codebooks_dir != NULL) {
+            // Se asume que los archivos codificados terminan en "_encoded".
+            char name[HUFF_PATH_MAX];
+            snprintf(name, sizeof(name), "%s", entry->d_name);
+            char* encodedPosition = strstr(name, "_encoded");
+            if (encodedPosition != NULL) {
+                *encodedPosition = '\0'; // Corta el nombre para remover "_encoded".
+            }
+            if (snprintf(job->codebook_path, sizeof(job->codebook_path), "%s/%s_codebook.txt", codebooks_dir, name) >=
+                (int)sizeof(job->codebook_path)) {
+                closedir(dir);
+                huff_batch_free(batch);
+                errno = ENAMETOOLONG;
+                return -1;
+            }
+        }
+        batch->count++;
+    }
+    closedir(dir);
+
+    if (batch->count > 1) {
+        qsort(batch->jobs, batch->count, sizeof(HJob), compare_job_size_desc);
+    }
+    return 0;
+}
+
+// Función para liberar la memoria del lote.
+void huff_batch_free(HBatch* batch) {
+    free(batch->jobs);
+    batch->jobs = NULL;
+    batch->count = 0;
+}
+
+// Función para procesar un único trabajo del lote.
+void huff_batch_run_job(const HBatch* batch, HJob* job) {
+    if (batch->encode) {
+        huff_encode_file_r(job->input_path, job->output_path, batch->codebooks_dir, batch->opts, &job->result);
+    } else {
+        huff_decode_file_r(job->input_path, job->codebook_path, job->output_path, batch->opts, &job->result);
+    }
+}
+
+// Función para imprimir el resultado de un trabajo. La línea se arma completa y se
+// escribe con una sola llamada, así las líneas de distintos hilos no se mezclan.
+void huff_batch_report_job(const HBatch* batch, const HJob* job) {
+    if (batch->stats != NULL) huff_stats_write_file(batch->stats, job->input_path, batch->encode, &job->result);
+    if (batch->report == NULL) return;
+    char line[HUFF_PATH_MAX + HUFF_RESULT_MSG_LEN + 64];
+    if (job->result.status == 0 && job->result.cap_cost > 0.0f) {
+        // Se informa cuánto cuesta el límite de longitud cuando tuvo efecto.
+        snprintf(line, sizeof(line), "%s file: %s (%zu -> %zu bytes, codes capped at %d bits: +%.3f%%)\n",
+                 batch->encode ? "Encoded" : "Decoded", job->input_path,
+                 job->result.bytes_in, job->result.bytes_out, job->result.max_code_len, job->result.cap_cost * 100.0);
+    } else if (job->result.status == 0) {
+        snprintf(line, sizeof(line), "%s file: %s (%zu -> %zu bytes)\n",
+                 batch->encode ? "Encoded" : "Decoded", job->input_path,
+                 job->result.bytes_in, job->result.bytes_out);
+    } else {
+        snprintf(line, sizeof(line), "Failed to %s file: %s (%s)\n",
+                 batch->encode ? "encode" : "decode", job->input_path, job->result.msg);
+    }
+    fputs(line, batch->report);
+}
+
+// Estado compartido por los hilos del pool.
+struct huff_pool {
+    HBatch*         batch;
+    void            (*run)(HBatch* batch, size_t idx, void* arg); // Procesa un trabajo.
+    void*           arg;   // Estado de quien llama, para run.
+    size_t          next;  // Índice del siguiente trabajo por repartir.
+    pthread_mutex_t lock;  // Protege next.
+};
+
+// Función que ejecuta cada hilo: toma trabajos de la cola hasta vaciarla.
+static void* huff_pool_worker(void* arg) {
+    struct huff_pool* pool = (struct huff_pool*)arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        size_t idx = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (idx >= pool->batch->count) break;
+        pool->run(pool->batch, idx, pool->arg);
+        huff_batch_report_job(pool->batch, &pool->batch->jobs[idx]);
+    }
+    return NULL;
+}
+
+// Procesa el trabajo idx con huff_batch_run_job.
+static void huff_pool_run_job(HBatch* batch, size_t idx, void* arg) {
+    (void)arg;
+    huff_batch_run_job(batch, &batch->jobs[idx]);
+}
+
+// Función para procesar el lote con un pool de hilos.
+int huff_batch_run_threads(HBatch* batch, int n_threads) {
+    return huff_batch_run_pool(batch, n_threads, huff_pool_run_job, NULL);
+}
+
+// Función para ejecutar run sobre cada trabajo del lote con un pool de hilos.
+int huff_batch_run_pool(HBatch* batch, int n_threads, void (*run)(HBatch* batch, size_t idx, void* arg), void* arg) {
+    struct huff_pool pool;
+    pool.batch = batch;
+    pool.run = run;
+    pool.arg = arg;
+    pool.next = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+
+    if (n_threads < 1) n_threads = 1;
+    if ((size_t)n_threads > batch->count) n_threads = batch->count ? (int)batch->count : 1;
+
+    if (n_threads == 1) {
+        huff_pool_worker(&pool); // Sin hilos adicionales para el caso secuencial.
+    } else {
+        pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)n_threads);
+        int started = 0;
+        if (threads != NULL) {
+            for (started = 0; started < n_threads; started++) {
+                if (pthread_create(&threads[started], NULL, huff_pool_worker, &pool) != 0) break;
+            }
+        }
+        if (started == 0) {
+            huff_pool_worker(&pool); // Si no se pudo crear ningún hilo, procesa en el actual.
+        }
+        for (int i = 0; i < started; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        free(threads);
+    }
+    pthread_mutex_destroy(&pool.lock);
+
+    int failed = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (batch->jobs[i].result.status != 0) failed++;
+    }
+    return failed;
+}
+
+// Estado de un archivo en la tabla compartida entre procesos.
+#define HUFF_SLOT_PENDING 0
+#define HUFF_SLOT_RUNNING 1
+#define HUFF_SLOT_DONE    2
+
+// Encabezado de la memoria compartida: la cola de índices y el trabajo que procesa cada hijo.
+// A continuación van n_procs índices (long) y batch->count resultados (struct huff_shared_slot).
+struct huff_shared_queue {
+    size_t next; // Índice del siguiente trabajo; se incrementa de forma atómica.
+};
+
+// Resultado de un archivo en la tabla compartida.
+struct huff_shared_slot {
+    int         state;  // HUFF_SLOT_PENDING, HUFF_SLOT_RUNNING o HUFF_SLOT_DONE.
+    HFileResult result; // Resultado copiado por el hijo al terminar.
+};
+
+// Bucle de un proceso hijo: toma índices de la cola compartida hasta vaciarla.
+static void huff_proc_worker(HBatch* batch, struct huff_shared_queue* queue, long* current, struct huff_shared_slot* slots) {
+    for (;;) {
+        size_t idx = __atomic_fetch_add(&queue->next, 1, __ATOMIC_SEQ_CST);
+        if (idx >= batch->count) break;
+        __atomic_store_n(current, (long)idx, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&slots[idx].state, HUFF_SLOT_RUNNING, __ATOMIC_SEQ_CST);
+        HJob* job = &batch->jobs[idx];
+        huff_batch_run_job(batch, job);
+        slots[idx].result = job->result;
+        __atomic_store_n(&slots[idx].state, HUFF_SLOT_DONE, __ATOMIC_SEQ_CST);
+        __atomic_store_n(current, -1L, __ATOMIC_SEQ_CST);
+        huff_batch_report_job(batch, job);
+        if (batch->report) fflush(batch->report); // Cada hijo vacía su línea completa de una vez.
+        if (batch->stats) fflush(batch->stats);
+    }
+}
+
+// Lanza un proceso hijo que ejecuta huff_proc_worker. Devuelve el pid o -1.
+static pid_t huff_proc_spawn(HBatch* batch, struct huff_shared_queue* queue, long* current, struct huff_shared_slot* slots) {
+    __atomic_store_n(current, -1L, __ATOMIC_SEQ_CST);
+    pid_t pid = fork();
+    if (pid == 0) {
+        huff_proc_worker(batch, queue, current, slots);
+        _exit(0);
+    }
+    return pid;
+}
+
+// Función para procesar el lote con procesos hijos.
+int huff_batch_run_procs(HBatch* batch, int n_procs) {
+    if (n_procs < 1) n_procs = 1;
+    if ((size_t)n_procs > batch->count) n_procs = batch->count ? (int)batch->count : 1;
+
+    size_t shared_size = sizeof(struct huff_shared_queue) + sizeof(long) * (size_t)n_procs
+                       + sizeof(struct huff_shared_slot) * batch->count;
+    void* shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        return huff_batch_run_threads(batch, 1); // Sin memoria compartida procesa en el proceso actual.
+    }
+    memset(shared, 0, shared_size);
+    struct huff_shared_queue* queue = (struct huff_shared_queue*)shared;
+    long* current = (long*)(queue + 1);
+    struct huff_shared_slot* slots = (struct huff_shared_slot*)(current + n_procs);
+
+    if (batch->report) fflush(batch->report); // Evita que los hijos hereden salida pendiente.
+    if (batch->stats) fflush(batch->stats);
+    pid_t* pids = (pid_t*)calloc((size_t)n_procs, sizeof(pid_t));
+    int alive = 0;
+    for (int w = 0; pids != NULL && w < n_procs; w++) {
+        pids[w] = huff_proc_spawn(batch, queue, &current[w], slots);
+        if (pids[w] > 0) alive++;
+    }
+    if (alive == 0) {
+        // No se pudo crear ningún hijo: procesa en el proceso actual.
+        huff_proc_worker(batch, queue, &current[0], slots);
+    }
+
+    // Espera a los hijos. Si uno termina de forma anormal, marca su archivo como fallido
+    // y lanza un reemplazo mientras queden trabajos en la cola.
+    while (alive > 0) {
+        int wstatus = 0;
+        pid_t pid = wait(&wstatus);
+        if (pid < 0) break;
+        int w;
+        for (w = 0; w < n_procs && pids[w] != pid; w++) {}
+        if (w == n_procs) continue;
+        pids[w] = 0;
+        alive--;
+        long idx = __atomic_load_n(&current[w], __ATOMIC_SEQ_CST);
+        if (idx >= 0 && slots[idx].state != HUFF_SLOT_DONE) {
+            HFileResult* res = &slots[idx].result;
+            memset(res, 0, sizeof(*res));
+            res->status = -1;
+            if (WIFSIGNALED(wstatus)) {
+                snprintf(res->msg, sizeof(res->msg), "worker killed by signal %d", WTERMSIG(wstatus));
+            } else {
+                snprintf(res->msg, sizeof(res->msg), "worker exited with status %d", WEXITSTATUS(wstatus));
+            }
+            slots[idx].state = HUFF_SLOT_DONE;
+            batch->jobs[idx].result = *res;
+            huff_batch_report_job(batch, &batch->jobs[idx]);
+            if (batch->report) fflush(batch->report);
+            if (batch->stats) fflush(batch->stats);
+        }
+        if (__atomic_load_n(&queue->next, __ATOMIC_SEQ_CST) < batch->count) {
+            pids[w] = huff_proc_spawn(batch, queue, &current[w], slots);
+            if (pids[w] > 0) alive++;
+        }
+    }
+    free(pids);
+
+    int failed = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (slots[i].state == HUFF_SLOT_DONE) {
+            batch->jobs[i].result = slots[i].result;
+        } else {
+            memset(&batch->jobs[i].result, 0, sizeof(HFileResult));
+            batch->jobs[i].result.status = -1;
+            snprintf(batch->jobs[i].result.msg, sizeof(batch->jobs[i].result.msg), "not processed");
+        }
+        if (batch->jobs[i].result.status != 0) failed++;
+    }
+    munmap(shared, shared_size);
+    return failed;
+}
+
+// Función para imprimir el resumen del lote.
+void huff_batch_summary(const HBatch* batch, const char* mode, int workers, double elapsed) {
+    size_t bytes_in = 0, bytes_out = 0;
+    int failed = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        bytes_in += batch->jobs[i].result.bytes_in;
+        bytes_out += batch->jobs[i].result.bytes_out;
+        if (batch->jobs[i].result.status != 0) failed++;
+    }
+    printf("%zu files, %d failed, %zu -> %zu bytes, %s x%d, %.3f s\n",
+           batch->count, failed, bytes_in, bytes_out, mode, workers, elapsed);
+}
+
+// Función para escribir la línea JSON del total del lote.
+void huff_batch_stats(const HBatch* batch, const char* mode, int workers, double elapsed) {
+    if (batch->stats == NULL) return;
+    HFileResult total;
+    memset(&total, 0, sizeof(total));
+    int failed = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        huff_stats_add(&total, &batch->jobs[i].result);
+        if (batch->jobs[i].result.status != 0) failed++;
+    }
+    huff_stats_write_run(batch->stats, batch->encode, &total, batch->count, failed, mode, workers, elapsed);
+}
+
+// Función que devuelve el número de núcleos disponibles.
+int huff_batch_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+// Función que devuelve el tiempo de reloj actual en segundos.
+double huff_batch_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
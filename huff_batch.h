@@ -0,0 +1,92 @@
+#ifndef HUFF_BATCH_H
+#define HUFF_BATCH_H
+
+#include <stdio.h>
+#include "huff_result.h"
+#include "huff_options.h"
+
+// Longitud máxima de las rutas que maneja el procesamiento por lotes.
+#ifndef HUFF_PATH_MAX
+#define HUFF_PATH_MAX 1024
+#endif // !HUFF_PATH_MAX
+
+// Un trabajo del lote: un archivo a codificar o decodificar.
+struct huff_job {
+	char        input_path[HUFF_PATH_MAX];    // Archivo de entrada.
+	char        output_path[HUFF_PATH_MAX];   // Archivo de salida.
+	char        codebook_path[HUFF_PATH_MAX]; // Codebook a usar al decodificar.
+	long long   size;                         // Tamaño del archivo de entrada (para planificar).
+	long long   mtime;                        // Fecha de modificación de la entrada en nanosegundos (--incremental).
+	HFileResult result;                       // Resultado de procesar el archivo.
+};
+
+// Nombre corto para un trabajo del lote.
+typedef struct huff_job HJob;
+
+// Lote de archivos de un directorio.
+struct huff_batch {
+	HJob*       jobs;          // Trabajos ordenados del más grande al más pequeño.
+	size_t      count;         // Número de trabajos.
+	int         encode;        // 1 para codificar, 0 para decodificar.
+	const char* codebooks_dir; // Directorio de codebooks.
+	FILE*       report;        // Donde se imprime el resultado de cada archivo (NULL = no imprimir).
+	FILE*       stats;         // Donde se escriben las líneas JSON de --stats (NULL = sin estadísticas).
+	const HOptions* opts;      // Opciones por archivo (NULL = valores por defecto).
+};
+
+// Nombre corto para el lote.
+typedef struct huff_batch HBatch;
+
+// Función para recorrer input_dir y construir el lote. Los archivos se ordenan
+// de mayor a menor tamaño para que un archivo grande no retrase el final del trabajo.
+// El manifiesto de --incremental lo quita huff_manifest_filter, no el recorrido.
+int huff_batch_scan(HBatch* batch, int encode, const char* input_dir, const char* output_dir, const char* codebooks_dir);
+
+// Función para liberar la memoria del lote.
+void huff_batch_free(HBatch* batch);
+
+// Función para procesar un único trabajo del lote (reentrante).
+void huff_batch_run_job(const HBatch* batch, HJob* job);
+
+// Función para imprimir el resultado de un trabajo en una sola escritura (y su línea JSON en
+// batch->stats).
+void huff_batch_report_job(const HBatch* batch, const HJob* job);
+
+// Función para procesar el lote con un pool de n_threads hilos (1 = en el hilo actual).
+// Devuelve el número de archivos que fallaron.
+int huff_batch_run_threads(HBatch* batch, int n_threads);
+
+// Función para procesar el lote con un pool de n_threads hilos (1 = en el hilo actual) que se
+// reparten los trabajos en orden: cada hilo llama run(batch, idx, arg) con el índice del trabajo
+// y luego imprime su resultado con huff_batch_report_job. run debe dejar el resultado en
+// batch->jobs[idx].result. Devuelve el número de archivos que fallaron.
+int huff_batch_run_pool(HBatch* batch, int n_threads, void (*run)(HBatch* batch, size_t idx, void* arg), void* arg);
+
+// Función para procesar el lote con n_procs procesos hijos (fork). Los hijos toman
+// índices de una cola en memoria compartida y dejan bytes/estado en una tabla compartida
+// que el padre copia al lote al final. Si un hijo muere procesando un archivo, ese archivo
+// se marca como fallido y se lanza otro hijo para continuar con el resto del lote.
+// Devuelve el número de archivos que fallaron.
+int huff_batch_run_procs(HBatch* batch, int n_procs);
+
+// Función para procesar el lote en un pipeline (huff_pipeline.c): un hilo lector carga los
+// próximos archivos en buffers de un pool fijo, n_workers hilos los codifican o decodifican en
+// memoria y el hilo actual escribe las salidas y recicla los buffers, así el disco y los núcleos
+// trabajan a la vez. Los archivos de más de HUFF_PIPELINE_MAX_FILE bytes los procesa un trabajador
+// directamente. Con use_uring la lectura y la escritura usan io_uring si está disponible
+// (huff_uring.h). Devuelve el número de archivos que fallaron.
+int huff_batch_run_pipeline(HBatch* batch, int n_workers, int use_uring);
+
+// Función para imprimir el resumen del lote (archivos, fallos, bytes y tiempo).
+void huff_batch_summary(const HBatch* batch, const char* mode, int workers, double elapsed);
+
+// Función para escribir en batch->stats la línea JSON con el total del lote.
+void huff_batch_stats(const HBatch* batch, const char* mode, int workers, double elapsed);
+
+// Función que devuelve el número de núcleos disponibles.
+int huff_batch_cpu_count(void);
+
+// Función que devuelve el tiempo de reloj actual en segundos.
+double huff_batch_now(void);
+
+#endif // !HUFF_BATCH_H
@@ -0,0 +1,415 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_format.h"
+#include "huff_histogram.h"
+#include "huff_batch.h"
+#include "huff_ans.h"
+#include "huff_order1.h"
+
+// Banco de pruebas del codificador: genera corpus sintéticos en memoria y mide por separado
+// el histograma, la construcción del árbol, la codificación y la decodificación de cada uno, las
+// mismas codificación y decodificación con rANS (huff_ans.h) sobre el mismo histograma, y con
+// códigos de orden 1 (huff_order1.h): cuánto más pequeña es la salida que con una sola tabla y
+// cuánto más lentas son la codificación y la decodificación. Con --file se agregan archivos reales
+// (por ejemplo libros) como corpus. Imprime una tabla legible y, con --json, una línea JSON por
+// corpus para comparar entre versiones.
+
+// Generador pseudoaleatorio (xorshift64*), para que los corpus sean iguales en cada ejecución.
+static uint64_t bench_rand(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+// Bytes uniformes: no se pueden comprimir.
+static void gen_uniform(unsigned char* dst, size_t n, uint64_t* rng) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (unsigned char)(bench_rand(rng) >> 56);
+    }
+}
+
+// Distribución geométrica: pocos símbolos muy frecuentes y una cola larga.
+static void gen_skewed(unsigned char* dst, size_t n, uint64_t* rng) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t r = bench_rand(rng);
+        int s = 0;
+        while (s < 255 && (r & 3) == 0) { // Cada símbolo es 4 veces menos probable que el anterior.
+            s++;
+            r >>= 2;
+            if (r == 0) r = bench_rand(rng);
+        }
+        dst[i] = (unsigned char)s;
+    }
+}
+
+// Texto parecido al inglés: palabras de un vocabulario con frecuencias de Zipf y puntuación.
+static void gen_english(unsigned char* dst, size_t n, uint64_t* rng) {
+    static const char* words[] = {
+        "the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with", "be",
+        "by", "on", "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have",
+        "an", "had", "they", "you", "were", "their", "one", "all", "we", "can", "her", "has",
+        "there", "been", "if", "more", "when", "will", "would", "who", "so", "no", "time",
+        "people", "water", "through", "between", "government", "Huffman", "compression", "London"
+    };
+    const size_t n_words = sizeof(words) / sizeof(words[0]);
+    size_t pos = 0;
+    while (pos < n) {
+        // Aproximación de Zipf: el cuadrado de un uniforme hace mucho más frecuentes las primeras palabras.
+        size_t k = (size_t)((double)n_words * ((double)(bench_rand(rng) >> 11) / 9007199254740992.0));
+        k = (k * k) / n_words;
+        const char* w = words[k];
+        for (size_t j = 0; w[j] && pos < n; j++) dst[pos++] = (unsigned char)w[j];
+        if (pos < n) {
+            uint64_t r = bench_rand(rng) % 20;
+            dst[pos++] = r == 0 ? '.' : (r == 1 ? ',' : (r == 2 ? '\n' : ' '));
+        }
+    }
+}
+
+// Datos binarios: enteros pequeños de 32 bits en little-endian mezclados con tramos de ceros.
+static void gen_binary(unsigned char* dst, size_t n, uint64_t* rng) {
+    size_t pos = 0;
+    while (pos < n) {
+        uint64_t r = bench_rand(rng);
+        if ((r & 7) == 0) {
+            size_t run = (size_t)(r >> 8) % 64;
+            for (size_t j = 0; j < run && pos < n; j++) dst[pos++] = 0;
+        } else {
+            uint32_t v = (uint32_t)((r >> 16) % 4096);
+            for (int j = 0; j < 4 && pos < n; j++) dst[pos++] = (unsigned char)(v >> (8 * j));
+        }
+    }
+}
+
+// Un corpus del banco de pruebas.
+struct bench_corpus {
+    const char* name;                                    // Nombre en la salida.
+    void      (*gen)(unsigned char*, size_t, uint64_t*); // Generador.
+    size_t      file_size;                               // Bytes por archivo (0 = un solo archivo con todo).
+    const char* path;                                    // Archivo que se lee en lugar de generar (NULL = generado).
+};
+
+// Tiempos (el mejor de las repeticiones) y tamaños de un corpus.
+struct bench_result {
+    double histogram;     // Segundos del histograma.
+    double tree;          // Segundos del árbol y los códigos canónicos.
+    double encode;        // Segundos de la codificación.
+    double decode;        // Segundos de la decodificación (tabla incluida).
+    double ans_encode;    // Segundos de la codificación rANS (normalización incluida).
+    double ans_decode;    // Segundos de la decodificación rANS (tabla incluida).
+    double o1_encode;     // Segundos de la codificación de orden 1 (pares, grupos y códigos incluidos).
+    double o1_decode;     // Segundos de la decodificación de orden 1 (tablas incluidas).
+    size_t bytes_in;      // Bytes originales.
+    size_t bytes_out;     // Bytes comprimidos, encabezados incluidos.
+    size_t ans_bytes_out; // Bytes comprimidos con rANS, encabezados incluidos.
+    size_t o1_bytes_out;  // Bytes comprimidos con códigos de orden 1, encabezados incluidos.
+    int    max_len;       // Código más largo.
+    int    ok;            // 1 si las dos decodificaciones reprodujeron la entrada.
+};
+
+// Espacio de trabajo de bench_file.
+struct bench_work {
+    unsigned char* enc;   // Archivo comprimido.
+    unsigned char* dec;   // Archivo decodificado.
+    HAnsDecoder*   ans;   // Decodificador rANS.
+    HO1Decoder*    o1;    // Decodificador de orden 1.
+    uint64_t*      pairs; // Histograma de pares del orden 1.
+};
+
+// Mide las cuatro fases, las dos de rANS y las dos de orden 1 sobre un archivo en memoria y acumula
+// en res. Con first == 1 también suma los tamaños y comprueba la decodificación.
+static void bench_file(const unsigned char* data, size_t len, const struct bench_work* work, int first,
+                       struct bench_result* res, double* t) {
+    unsigned char* enc = work->enc;
+    unsigned char* dec = work->dec;
+    HAnsDecoder* ans = work->ans;
+    double t0 = huff_batch_now();
+    uint64_t counts[HUFF_MAX_SYMBOLS];
+    memset(counts, 0, sizeof(counts));
+    huff_histogram(data, len, counts);
+    double t1 = huff_batch_now();
+
+    HHeader header;
+    memset(&header, 0, sizeof(header));
+    HTreeArena arena;
+    huff_build_code_lengths(counts, HUFF_MAX_LEN - 1, &arena, header.lengths, NULL);
+    uint64_t codes[HUFF_MAX_SYMBOLS];
+    huff_canonical_codes(header.lengths, codes);
+    HPackedCode packed[HUFF_MAX_SYMBOLS];
+    int max_len = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        packed[s].bits = codes[s];
+        packed[s].len = header.lengths[s];
+        if (packed[s].len > max_len) max_len = packed[s].len;
+    }
+    double t2 = huff_batch_now();
+
+    header.orig_len = len;
+    size_t header_len = huff_write_header(&header, enc);
+    HBitWriter w = {0, 0, enc + header_len, 0};
+    huff_encode_symbols(&w, data, len, packed, max_len);
+    huff_bit_writer_finish(&w);
+    double t3 = huff_batch_now();
+
+    HDecodeNode* root_decode = create_huff_decode_node();
+    build_huff_decode_tree_from_lengths(header.lengths, root_decode);
+    HDecodeTable* table = build_huff_decode_table(root_decode);
+    uint64_t bit_pos = (uint64_t)header_len * 8;
+    size_t produced = table != NULL ? huff_decode_bits(table, enc, &bit_pos, (uint64_t)(header_len + w.pos) * 8, dec, len) : 0;
+    free_huff_decode_table(table);
+    free_huff_decode_tree(root_decode);
+    double t4 = huff_batch_now();
+    int ok = produced == len && memcmp(data, dec, len) == 0;
+
+    uint32_t freqs[HUFF_MAX_SYMBOLS];
+    huff_ans_normalize(counts, freqs);
+    size_t ans_header_len = huff_ans_write_header(freqs, len, enc);
+    size_t ans_len = huff_ans_encode(data, len, freqs, enc + ans_header_len);
+    double t5 = huff_batch_now();
+
+    int ans_ok = huff_ans_decoder_init(ans, freqs, enc + ans_header_len, ans_len) == 0 &&
+                 huff_ans_decode(ans, dec, len) == 0 && huff_ans_decoder_finish(ans) == 0 && memcmp(data, dec, len) == 0;
+    double t6 = huff_batch_now();
+
+    HO1Model model;
+    memset(work->pairs, 0, sizeof(uint64_t) * HUFF_MAX_SYMBOLS * HUFF_MAX_SYMBOLS);
+    huff_o1_histogram(data, len, work->pairs);
+    huff_o1_build(work->pairs, HUFF_O1_CLUSTERS, &model);
+    size_t o1_header_len = huff_o1_write_header(&model, len, enc);
+    size_t o1_len = huff_o1_encode_to(data, len, &model, enc + o1_header_len, HUFF_ENCODE_BOUND(len, HUFF_O1_MAX_LEN));
+    double t7 = huff_batch_now();
+
+    huff_o1_decoder_table(work->o1, &model);
+    huff_o1_decoder_start(work->o1, enc + o1_header_len, o1_len);
+    int o1_ok = huff_o1_decode(work->o1, dec, len) == 0;
+    double t8 = huff_batch_now();
+
+    t[0] += t1 - t0;
+    t[1] += t2 - t1;
+    t[2] += t3 - t2;
+    t[3] += t4 - t3;
+    t[4] += t5 - t4;
+    t[5] += t6 - t5;
+    t[6] += t7 - t6;
+    t[7] += t8 - t7;
+    if (first) {
+        res->bytes_in += len;
+        res->bytes_out += header_len + w.pos;
+        res->ans_bytes_out += ans_header_len + ans_len;
+        res->o1_bytes_out += o1_header_len + o1_len;
+        if (max_len > res->max_len) res->max_len = max_len;
+        if (!ok || !ans_ok || !o1_ok || memcmp(data, dec, len) != 0) res->ok = 0;
+    }
+}
+
+// Lee un archivo completo. Devuelve NULL si no se puede leer (o está vacío).
+static unsigned char* bench_read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    unsigned char* data = NULL;
+    long n = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (n > 0 && fseek(f, 0, SEEK_SET) == 0 && (data = (unsigned char*)malloc((size_t)n)) != NULL &&
+        fread(data, 1, (size_t)n, f) != (size_t)n) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = n > 0 ? (size_t)n : 0;
+    return data;
+}
+
+// Ejecuta un corpus reps veces y se queda con el mejor tiempo de cada fase.
+static void bench_corpus_run(const struct bench_corpus* corpus, size_t size, int reps, uint64_t seed, struct bench_result* res) {
+    memset(res, 0, sizeof(*res));
+    res->ok = 1;
+    res->histogram = res->tree = res->encode = res->decode = res->ans_encode = res->ans_decode = 1e30;
+    res->o1_encode = res->o1_decode = 1e30;
+    unsigned char* data = corpus->path ? bench_read_file(corpus->path, &size) : (unsigned char*)malloc(size);
+    size_t file_size = corpus->file_size ? corpus->file_size : size;
+    size_t enc_size = HUFF_HEADER_MAX_SIZE + HUFF_ENCODE_BOUND(file_size, HUFF_MAX_LEN);
+    if (enc_size < HUFF_ANS_HEADER_MAX_SIZE + HUFF_ANS_BOUND(file_size)) enc_size = HUFF_ANS_HEADER_MAX_SIZE + HUFF_ANS_BOUND(file_size);
+    if (enc_size < HUFF_O1_HEADER_MAX_SIZE + HUFF_ENCODE_BOUND(file_size, HUFF_O1_MAX_LEN)) {
+        enc_size = HUFF_O1_HEADER_MAX_SIZE + HUFF_ENCODE_BOUND(file_size, HUFF_O1_MAX_LEN);
+    }
+    struct bench_work work;
+    work.enc = (unsigned char*)malloc(enc_size);
+    work.dec = (unsigned char*)malloc(file_size);
+    work.ans = (HAnsDecoder*)malloc(sizeof(HAnsDecoder));
+    work.o1 = (HO1Decoder*)malloc(sizeof(HO1Decoder));
+    work.pairs = (uint64_t*)malloc(sizeof(uint64_t) * HUFF_MAX_SYMBOLS * HUFF_MAX_SYMBOLS);
+    if (data == NULL || work.enc == NULL || work.dec == NULL || work.ans == NULL || work.o1 == NULL || work.pairs == NULL) {
+        res->ok = 0;
+    } else {
+        uint64_t rng = seed;
+        if (corpus->path == NULL) corpus->gen(data, size, &rng);
+        for (int r = 0; r < reps; r++) {
+            double t[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            for (size_t off = 0; off < size; off += file_size) {
+                size_t n = size - off < file_size ? size - off : file_size;
+                bench_file(data + off, n, &work, r == 0, res, t);
+            }
+            if (t[0] < res->histogram) res->histogram = t[0];
+            if (t[1] < res->tree) res->tree = t[1];
+            if (t[2] < res->encode) res->encode = t[2];
+            if (t[3] < res->decode) res->decode = t[3];
+            if (t[4] < res->ans_encode) res->ans_encode = t[4];
+            if (t[5] < res->ans_decode) res->ans_decode = t[5];
+            if (t[6] < res->o1_encode) res->o1_encode = t[6];
+            if (t[7] < res->o1_decode) res->o1_decode = t[7];
+        }
+    }
+    free(data);
+    free(work.enc);
+    free(work.dec);
+    free(work.ans);
+    free(work.o1);
+    free(work.pairs);
+}
+
+// MB/s de una fase (0 si no se pudo medir).
+static double bench_mbps(size_t bytes, double seconds) {
+    return seconds > 0 ? (double)bytes / seconds / 1e6 : 0.0;
+}
+
+// Archivos reales que se pueden agregar como corpus con --file.
+#define BENCH_MAX_FILES 16
+
+static void usage(const char* prog) {
+    printf("Usage: %s [-s MB] [-r N] [--seed N] [--file FILE]... [--json FILE]\n", prog);
+    printf("  -s MB        bytes of each synthetic corpus in MB (default 16)\n");
+    printf("  -r N         repetitions per corpus; the best time of each phase is reported (default 5)\n");
+    printf("  --seed N     seed of the generators (default 1)\n");
+    printf("  --file FILE  also benchmark the contents of FILE as one corpus (up to %d times)\n", BENCH_MAX_FILES);
+    printf("  --json FILE  also write one JSON line per corpus to FILE (- = stdout)\n");
+    printf("Columns o1_*: order-1 codes; o1_gain is how much smaller than order-0 Huffman the output is and\n");
+    printf("o1_cost how much lower the decode throughput is.\n");
+}
+
+int main(int argc, char* argv[]) {
+    double size_mb = 16;
+    int reps = 5;
+    uint64_t seed = 1;
+    const char* json_path = NULL;
+    const char* files[BENCH_MAX_FILES];
+    int n_files = 0;
+
+    static const struct option long_opts[] = {
+        {"seed", required_argument, NULL, 'S'},
+        {"json", required_argument, NULL, 'J'},
+        {"file", required_argument, NULL, 'F'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:r:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            size_mb = atof(optarg);
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            break;
+        case 'S':
+            seed = strtoull(optarg, NULL, 10);
+            if (seed == 0) seed = 1; // xorshift no admite el estado 0.
+            break;
+        case 'J':
+            json_path = optarg;
+            break;
+        case 'F':
+            if (n_files == BENCH_MAX_FILES) {
+                fprintf(stderr, "At most %d --file corpora\n", BENCH_MAX_FILES);
+                return EXIT_FAILURE;
+            }
+            files[n_files++] = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : EXIT_FAILURE;
+        }
+    }
+    if (size_mb <= 0 || reps <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t size = (size_t)(size_mb * 1e6);
+
+    static const struct bench_corpus synthetic[] = {
+        {"uniform", gen_uniform, 0, NULL},
+        {"skewed", gen_skewed, 0, NULL},
+        {"english", gen_english, 0, NULL},
+        {"binary", gen_binary, 0, NULL},
+        {"tiny_files", gen_english, 512, NULL},
+    };
+    const int n_synthetic = (int)(sizeof(synthetic) / sizeof(synthetic[0]));
+    struct bench_corpus corpora[sizeof(synthetic) / sizeof(synthetic[0]) + BENCH_MAX_FILES];
+    memcpy(corpora, synthetic, sizeof(synthetic));
+    for (int f = 0; f < n_files; f++) {
+        const char* base = strrchr(files[f], '/');
+        corpora[n_synthetic + f].name = base ? base + 1 : files[f];
+        corpora[n_synthetic + f].gen = NULL;
+        corpora[n_synthetic + f].file_size = 0;
+        corpora[n_synthetic + f].path = files[f];
+    }
+    const int n_corpora = n_synthetic + n_files;
+
+    FILE* json = NULL;
+    if (json_path != NULL) {
+        json = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (json == NULL) {
+            fprintf(stderr, "Cannot open %s\n", json_path);
+            return EXIT_FAILURE;
+        }
+    }
+    if (json != stdout) {
+        printf("%-11s %7s %10s %10s %10s %10s %8s %9s %10s %10s %8s %8s %10s %10s %8s %7s\n", "corpus", "ratio", "hist_MB/s",
+               "tree_ms", "enc_MB/s", "dec_MB/s", "max_len", "ans_ratio", "ans_enc", "ans_dec", "o1_ratio", "o1_gain",
+               "o1_enc", "o1_dec", "o1_cost", "check");
+    }
+    int failed = 0;
+    for (int c = 0; c < n_corpora; c++) {
+        struct bench_result res;
+        bench_corpus_run(&corpora[c], size, reps, seed, &res);
+        double ratio = res.bytes_in ? (double)res.bytes_out / (double)res.bytes_in : 0.0;
+        double ans_ratio = res.bytes_in ? (double)res.ans_bytes_out / (double)res.bytes_in : 0.0;
+        double o1_ratio = res.bytes_in ? (double)res.o1_bytes_out / (double)res.bytes_in : 0.0;
+        // Ganancia: fracción de la salida de orden 0 que se ahorra. Costo: fracción del caudal de
+        // decodificación que se pierde, y cuántas veces más tarda la codificación completa (histograma,
+        // árbol y códigos incluidos).
+        double o1_gain = res.bytes_out ? 1.0 - (double)res.o1_bytes_out / (double)res.bytes_out : 0.0;
+        double o1_cost = res.o1_decode > 0 ? 1.0 - res.decode / res.o1_decode : 0.0;
+        double o1_encode_x = res.histogram + res.tree + res.encode > 0 ? res.o1_encode / (res.histogram + res.tree + res.encode) : 0.0;
+        if (!res.ok) failed++;
+        if (json != stdout) {
+            printf("%-11s %7.4f %10.1f %10.3f %10.1f %10.1f %8d %9.4f %10.1f %10.1f %8.4f %7.1f%% %10.1f %10.1f %7.1f%% %7s\n",
+                   corpora[c].name, ratio, bench_mbps(res.bytes_in, res.histogram), res.tree * 1e3,
+                   bench_mbps(res.bytes_in, res.encode), bench_mbps(res.bytes_in, res.decode), res.max_len, ans_ratio,
+                   bench_mbps(res.bytes_in, res.ans_encode), bench_mbps(res.bytes_in, res.ans_decode), o1_ratio,
+                   o1_gain * 100.0, bench_mbps(res.bytes_in, res.o1_encode), bench_mbps(res.bytes_in, res.o1_decode),
+                   o1_cost * 100.0, res.ok ? "ok" : "FAIL");
+        }
+        if (json != NULL) {
+            fprintf(json, "{\"corpus\":\"%s\",\"file_size\":%zu,\"bytes_in\":%zu,\"bytes_out\":%zu,\"ratio\":%.6f,"
+                          "\"histogram_s\":%.6f,\"tree_s\":%.6f,\"encode_s\":%.6f,\"decode_s\":%.6f,"
+                          "\"histogram_mbps\":%.2f,\"encode_mbps\":%.2f,\"decode_mbps\":%.2f,\"max_code_len\":%d,"
+                          "\"ans_bytes_out\":%zu,\"ans_ratio\":%.6f,\"ans_encode_s\":%.6f,\"ans_decode_s\":%.6f,"
+                          "\"ans_encode_mbps\":%.2f,\"ans_decode_mbps\":%.2f,"
+                          "\"o1_bytes_out\":%zu,\"o1_ratio\":%.6f,\"o1_gain\":%.6f,\"o1_encode_s\":%.6f,\"o1_decode_s\":%.6f,"
+                          "\"o1_encode_mbps\":%.2f,\"o1_decode_mbps\":%.2f,\"o1_decode_cost\":%.6f,\"o1_encode_x\":%.3f,\"ok\":%s}\n",
+                    corpora[c].name, corpora[c].file_size ? corpora[c].file_size : res.bytes_in, res.bytes_in, res.bytes_out, ratio,
+                    res.histogram, res.tree, res.encode, res.decode, bench_mbps(res.bytes_in, res.histogram),
+                    bench_mbps(res.bytes_in, res.encode), bench_mbps(res.bytes_in, res.decode), res.max_len,
+                    res.ans_bytes_out, ans_ratio, res.ans_encode, res.ans_decode, bench_mbps(res.bytes_in, res.ans_encode),
+                    bench_mbps(res.bytes_in, res.ans_decode), res.o1_bytes_out, o1_ratio, o1_gain, res.o1_encode, res.o1_decode,
+                    bench_mbps(res.bytes_in, res.o1_encode), bench_mbps(res.bytes_in, res.o1_decode), o1_cost, o1_encode_x,
+                    res.ok ? "true" : "false");
+        }
+    }
+    if (json != NULL && json != stdout) fclose(json);
+    return failed ? EXIT_FAILURE : 0;
+}
@@ -1,18 +1,144 @@
-#ifndef HUFF_CONST_H
-#define HUFF_CONST_H
-
-// Define el número máximo de símbolos que se pueden manejar en el algoritmo Huffman.
-// Esto es útil para limitar el rango de caracteres ASCII a 256, que es el tamaño total
-// de caracteres ASCII extendidos que se pueden representar en un byte.
-#ifndef HUFF_MAX_SYMBOLS
-#define HUFF_MAX_SYMBOLS 256
-#endif // !HUFF_MAX_SYMBOLS
-
-// Define la longitud máxima de los códigos Huffman que se pueden generar.
-// Esto es para asegurarse de que los códigos generados no excedan esta longitud,
-// manteniendo así la eficiencia del algoritmo y evitando el desbordamiento de buffers.
-#ifndef HUFF_MAX_LEN
-#define HUFF_MAX_LEN 50
-#endif // !HUFF_MAX_LEN
-
-#endif // !HUFF_CONST_H
+#ifndef HUFF_CONST_H
+#define HUFF_CONST_H
+
+// Define el número máximo de símbolos que se pueden manejar en el algoritmo Huffman.
+// Esto es útil para limitar el rango de caracteres ASCII a 256, que es el tamaño total
+// de caracteres ASCII extendidos que se pueden representar en un byte.
+#ifndef HUFF_MAX_SYMBOLS
+#define HUFF_MAX_SYMBOLS 256
+#endif // !HUFF_MAX_SYMBOLS
+
+// Define la longitud máxima de los códigos Huffman que se pueden generar.
+// Esto es para asegurarse de que los códigos generados no excedan esta longitud,
+// manteniendo así la eficiencia del algoritmo y evitando el desbordamiento de buffers.
+#ifndef HUFF_MAX_LEN
+#define HUFF_MAX_LEN 50
+#endif // !HUFF_MAX_LEN
+
+// Tamaño mínimo (en bytes) de cada trozo al codificar un único archivo con varios hilos.
+// Los archivos más pequeños que dos trozos se codifican de forma secuencial.
+#ifndef HUFF_PARALLEL_MIN_CHUNK
+#define HUFF_PARALLEL_MIN_CHUNK (256 * 1024)
+#endif // !HUFF_PARALLEL_MIN_CHUNK
+
+// Bits que se consultan en la tabla principal del decodificador. Los códigos más largos
+// continúan en una tabla secundaria de hasta HUFF_DECODE_SUB_BITS bits adicionales.
+#ifndef HUFF_DECODE_TABLE_BITS
+#define HUFF_DECODE_TABLE_BITS 11
+#endif // !HUFF_DECODE_TABLE_BITS
+
+#ifndef HUFF_DECODE_SUB_BITS
+#define HUFF_DECODE_SUB_BITS 12
+#endif // !HUFF_DECODE_SUB_BITS
+
+// Número máximo de símbolos que puede emitir una sola consulta a la tabla principal.
+#ifndef HUFF_DECODE_MAX_SYMS
+#define HUFF_DECODE_MAX_SYMS 3
+#endif // !HUFF_DECODE_MAX_SYMS
+
+// Tamaño del buffer de salida del decodificador.
+#ifndef HUFF_IO_BUFFER_SIZE
+#define HUFF_IO_BUFFER_SIZE (256 * 1024)
+#endif // !HUFF_IO_BUFFER_SIZE
+
+// Bytes por bloque del formato por bloques cuando no se indica otro tamaño (entrada estándar).
+#ifndef HUFF_STREAM_BLOCK_SIZE
+#define HUFF_STREAM_BLOCK_SIZE (1024 * 1024)
+#endif // !HUFF_STREAM_BLOCK_SIZE
+
+// Flujos de bits intercalados por bloque cuando se pide --streams sin un número válido.
+#ifndef HUFF_DEFAULT_STREAMS
+#define HUFF_DEFAULT_STREAMS 4
+#endif // !HUFF_DEFAULT_STREAMS
+
+// Bytes de salida mínimos de cada ventana del decodificador paralelo de un archivo por bloques.
+#ifndef HUFF_PARALLEL_DECODE_WINDOW
+#define HUFF_PARALLEL_DECODE_WINDOW (16 * 1024 * 1024)
+#endif // !HUFF_PARALLEL_DECODE_WINDOW
+
+// Bytes de salida máximos de cada ventana del decodificador paralelo (salvo un bloque por hilo).
+#ifndef HUFF_PARALLEL_DECODE_WINDOW_MAX
+#define HUFF_PARALLEL_DECODE_WINDOW_MAX (256 * 1024 * 1024)
+#endif // !HUFF_PARALLEL_DECODE_WINDOW_MAX
+
+// Bytes originales entre puntos de control del índice dentro de un bloque de un solo flujo.
+#ifndef HUFF_INDEX_INTERVAL
+#define HUFF_INDEX_INTERVAL (64 * 1024)
+#endif // !HUFF_INDEX_INTERVAL
+
+// Trazas de depuración del árbol de Huffman. Solo se compilan si se define HUFF_TRACE,
+// de modo que la codificación/decodificación no escribe en stdout y puede ejecutarse
+// desde varios hilos a la vez sin mezclar la salida.
+#ifdef HUFF_TRACE
+#define HUFF_TRACEF(...) printf(__VA_ARGS__)
+#else
+#define HUFF_TRACEF(...) ((void)0)
+#endif // HUFF_TRACE
+
+// Bytes que se leen de cada archivo para entrenar un diccionario (huff_dict.h).
+#ifndef HUFF_DICT_SAMPLE
+#define HUFF_DICT_SAMPLE (1024 * 1024)
+#endif // !HUFF_DICT_SAMPLE
+
+// Longitud máxima de los códigos de un diccionario cuando no se indica otra. Los bytes que no
+// aparecen en la muestra no alargan los códigos más allá de lo que permite escribir cuatro
+// códigos por vaciado del acumulador (huff_encode_symbols).
+#ifndef HUFF_DICT_MAX_LEN
+#define HUFF_DICT_MAX_LEN 14
+#endif // !HUFF_DICT_MAX_LEN
+
+// Bytes del principio de cada archivo con los que se compara el diccionario con una tabla propia.
+#ifndef HUFF_DICT_PROBE
+#define HUFF_DICT_PROBE (8 * 1024)
+#endif // !HUFF_DICT_PROBE
+
+// Porcentaje que puede crecer la salida con el diccionario antes de usar una tabla propia.
+#ifndef HUFF_DICT_THRESHOLD
+#define HUFF_DICT_THRESHOLD 10
+#endif // !HUFF_DICT_THRESHOLD
+
+// Archivos más grandes que esto no pasan por los buffers del pipeline (huff_pipeline.h): el
+// trabajador los mapea y escribe directamente, así la memoria del pool queda acotada.
+#ifndef HUFF_PIPELINE_MAX_FILE
+#define HUFF_PIPELINE_MAX_FILE (16 * 1024 * 1024)
+#endif // !HUFF_PIPELINE_MAX_FILE
+
+// Buffers del pipeline por trabajador: uno en cálculo y otro leído por adelantado.
+#ifndef HUFF_PIPELINE_BUFFERS_PER_WORKER
+#define HUFF_PIPELINE_BUFFERS_PER_WORKER 2
+#endif // !HUFF_PIPELINE_BUFFERS_PER_WORKER
+
+// Lecturas o escrituras en vuelo y bytes de cada una con io_uring (huff_uring.h).
+#ifndef HUFF_URING_DEPTH
+#define HUFF_URING_DEPTH 8
+#endif // !HUFF_URING_DEPTH
+#ifndef HUFF_URING_CHUNK
+#define HUFF_URING_CHUNK (512 * 1024)
+#endif // !HUFF_URING_CHUNK
+
+// Bits de precisión de las frecuencias del codificador rANS (huff_ans.h): la tabla de
+// decodificación tiene 2^HUFF_ANS_SCALE_BITS entradas. Como mucho 16 (frecuencias de 2 bytes).
+#ifndef HUFF_ANS_SCALE_BITS
+#define HUFF_ANS_SCALE_BITS 12
+#endif // !HUFF_ANS_SCALE_BITS
+
+// Grupos de contextos del modo de orden 1 (huff_order1.h). Como mucho 16: el encabezado guarda el
+// grupo de cada contexto en 4 bits.
+#ifndef HUFF_O1_CLUSTERS
+#define HUFF_O1_CLUSTERS 16
+#endif // !HUFF_O1_CLUSTERS
+
+// Longitud máxima de los códigos del modo de orden 1: cada grupo se decodifica con una sola tabla
+// de 2^HUFF_O1_MAX_LEN entradas. Entre 8 (para 256 símbolos) y 14 (cuatro códigos por vaciado del
+// acumulador y longitudes de 4 bits en el encabezado).
+#ifndef HUFF_O1_MAX_LEN
+#define HUFF_O1_MAX_LEN 11
+#endif // !HUFF_O1_MAX_LEN
+
+// Bytes mínimos para que --backend auto pruebe el modo de orden 1: en archivos más chicos las
+// tablas de los grupos casi nunca se pagan y agrupar los contextos cuesta más que codificarlos.
+#ifndef HUFF_O1_AUTO_MIN
+#define HUFF_O1_AUTO_MIN 4096
+#endif // !HUFF_O1_AUTO_MIN
+
+#endif // !HUFF_CONST_H
@@ -1,115 +1,613 @@
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <assert.h>
-#include "huff_decode.h"
-
-// Crea un nuevo nodo de decodificación Huffman.
-HDecodeNode* create_huff_decode_node() {
-    HDecodeNode* p_node = (HDecodeNode*)malloc(sizeof(HDecodeNode));
-    if (p_node != NULL) {
-        p_node->left = NULL;   // Hijo izquierdo.
-        p_node->right = NULL;  // Hijo derecho.
-        p_node->symbol = 0;    // Símbolo representado por el nodo.
-        p_node->is_leaf = 0;   // Indica si es un nodo hoja.
-    }
-    return p_node;
-}
-
-// Libera la memoria del árbol de decodificación.
-void free_huff_decode_tree(HDecodeNode* node) {
-    if (node == NULL) return;
-    free_huff_decode_tree(node->left);  // Libera el subárbol izquierdo.
-    free_huff_decode_tree(node->right); // Libera el subárbol derecho.
-    free(node);                         // Libera el nodo actual.
-}
-
-// Construye un árbol de decodificación basado en un libro de códigos.
-void build_huff_decode_tree(FILE* fp, HDecodeNode* root_decode) {
-    char symbol=0;
-    char strcode[HUFF_MAX_LEN];
-    int idx=0, length=0;
-    int num_input=0;
-    HDecodeNode* curr_node = NULL;
-    while (!feof(fp)) {
-        memset(strcode, 0, sizeof(strcode));
-        symbol = 0;
-        num_input = fscanf(fp, "#%c %s\n", &symbol, strcode); // Lee el símbolo y su código.
-        if (num_input != 2) {
-            break; // Finaliza si no hay más datos o hay un error.
-        }
-        curr_node = root_decode; // Comienza desde la raíz para este símbolo.
-        length = strlen(strcode);
-        for (idx = 0; idx < length; idx++) {
-            if (strcode[idx] == '0') {
-                // Si el carácter es '0', va o crea un nodo a la izquierda.
-                if (curr_node->left == NULL) {
-                    curr_node->left = create_huff_decode_node();
-                }
-                curr_node = curr_node->left;
-            } else if (strcode[idx] == '1') {
-                // Si el carácter es '1', va o crea un nodo a la derecha.
-                if (curr_node->right == NULL) {
-                    curr_node->right = create_huff_decode_node();
-                }
-                curr_node = curr_node->right;
-            } else {
-                printf("unexpected char %c\n", strcode[idx]);
-                assert(0); // Falla si el código contiene caracteres inesperados.
-            }
-        }
-        // Asigna el símbolo al último nodo como nodo hoja.
-        curr_node->is_leaf = 1;
-        curr_node->symbol = symbol;
-    }
-}
-
-// Decodifica un archivo basado en el árbol de decodificación Huffman.
-void huff_decode(FILE* f_in, FILE* f_out, HDecodeNode* root_decode) {
-    unsigned char c = 0;
-    int bit;
-    HDecodeNode* curr_node = root_decode;
-    while (fread(&c, sizeof(c), 1, f_in)) { // Lee el archivo codificado bit a bit.
-        for (int i = 7; i >= 0; i--) {
-            bit = (c >> i) & 1; // Obtiene el bit actual.
-            if (bit == 0) curr_node = curr_node->left; // Va hacia la izquierda para '0'.
-            else curr_node = curr_node->right;         // Va hacia la derecha para '1'.
-            if (curr_node->is_leaf) { // Si llega a una hoja, escribe el símbolo.
-                fprintf(f_out, "%c", curr_node->symbol);
-                curr_node = root_decode; // Regresa a la raíz para el siguiente bit.
-            }
-        }
-    }
-}
-
-// Interfaz para decodificar un archivo usando el libro de códigos especificado.
-int huff_decode_file(const char* filename, const char* codebook_filename, const char* decoded_filename){
-    FILE* f_in = fopen(codebook_filename, "rb");
-    if(f_in == NULL){
-        printf("cannot open %s\n.exit.\n", codebook_filename);
-        return -1;
-    }
-
-    HDecodeNode* root_decode = create_huff_decode_node();
-    build_huff_decode_tree(f_in, root_decode); // Construye el árbol de decodificación.
-    fclose(f_in); // Cierra el archivo del libro de códigos.
-
-    f_in = fopen(filename, "rb"); // Abre el archivo codificado.
-    if(f_in == NULL){
-        printf("cannot open %s\n.exit.\n", filename);
-        return -1;
-    }
-
-    FILE* f_out = fopen(decoded_filename, "w"); // Abre el archivo de salida.
-    if(f_out == NULL){
-        printf("cannot open %s\n.exit.\n", decoded_filename);
-        fclose(f_in); // Cierra el archivo de entrada antes de salir.
-        return -1;
-    }
-
-    huff_decode(f_in, f_out, root_decode); // Decodifica el archivo.
-    fclose(f_in); // Cierra el archivo de entrada.
-    fclose(f_out); // Cierra el archivo de salida.
-    free_huff_decode_tree(root_decode); // Libera la memoria del árbol.
-    return 0;
-}
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "huff_decode.h"
+#include "huff_format.h"
+#include "huff_io.h"
+#include "huff_stream.h"
+#include "huff_dict.h"
+#include "huff_stats.h"
+#include "huff_ans.h"
+#include "huff_order1.h"
+
+// Crea un nuevo nodo de decodificación Huffman.
+HDecodeNode* create_huff_decode_node() {
+    HDecodeNode* p_node = (HDecodeNode*)malloc(sizeof(HDecodeNode));
+    if (p_node != NULL) {
+        p_node->left = NULL;   // Hijo izquierdo.
+        p_node->right = NULL;  // Hijo derecho.
+        p_node->symbol = 0;    // Símbolo representado por el nodo.
+        p_node->is_leaf = 0;   // Indica si es un nodo hoja.
+    }
+    return p_node;
+}
+
+// Libera la memoria del árbol de decodificación.
+void free_huff_decode_tree(HDecodeNode* node) {
+    if (node == NULL) return;
+    free_huff_decode_tree(node->left);  // Libera el subárbol izquierdo.
+    free_huff_decode_tree(node->right); // Libera el subárbol derecho.
+    free(node);                         // Libera el nodo actual.
+}
+
+// Construye un árbol de decodificación basado en un libro de códigos.
+void build_huff_decode_tree(FILE* fp, HDecodeNode* root_decode) {
+    char symbol=0;
+    char strcode[HUFF_MAX_LEN];
+    int idx=0, length=0;
+    int num_input=0;
+    HDecodeNode* curr_node = NULL;
+    while (!feof(fp)) {
+        memset(strcode, 0, sizeof(strcode));
+        symbol = 0;
+        num_input = fscanf(fp, "#%c %s\n", &symbol, strcode); // Lee el símbolo y su código.
+        if (num_input != 2) {
+            break; // Finaliza si no hay más datos o hay un error.
+        }
+        curr_node = root_decode; // Comienza desde la raíz para este símbolo.
+        length = strlen(strcode);
+        for (idx = 0; idx < length; idx++) {
+            if (strcode[idx] == '0') {
+                // Si el carácter es '0', va o crea un nodo a la izquierda.
+                if (curr_node->left == NULL) {
+                    curr_node->left = create_huff_decode_node();
+                }
+                curr_node = curr_node->left;
+            } else if (strcode[idx] == '1') {
+                // Si el carácter es '1', va o crea un nodo a la derecha.
+                if (curr_node->right == NULL) {
+                    curr_node->right = create_huff_decode_node();
+                }
+                curr_node = curr_node->right;
+            } else {
+                printf("unexpected char %c\n", strcode[idx]);
+                assert(0); // Falla si el código contiene caracteres inesperados.
+            }
+        }
+        // Asigna el símbolo al último nodo como nodo hoja.
+        curr_node->is_leaf = 1;
+        curr_node->symbol = symbol;
+    }
+}
+
+// Recorre el árbol y guarda el código (bits y longitud) de cada símbolo.
+static void collect_huff_codes(const HDecodeNode* node, uint64_t bits, int len, uint64_t* code_bits, int* code_len) {
+    if (node == NULL) return;
+    if (node->is_leaf) {
+        unsigned char symbol = (unsigned char)node->symbol;
+        code_bits[symbol] = bits;
+        code_len[symbol] = len;
+        return;
+    }
+    if (len >= 64) return; // Un código así no puede venir de un codebook válido.
+    collect_huff_codes(node->left, bits << 1, len + 1, code_bits, code_len);
+    collect_huff_codes(node->right, (bits << 1) | 1, len + 1, code_bits, code_len);
+}
+
+// Construye la tabla de decodificación a partir del árbol.
+HDecodeTable* build_huff_decode_table(const HDecodeNode* root_decode) {
+    const int root_bits = HUFF_DECODE_TABLE_BITS;
+    const size_t root_size = (size_t)1 << root_bits;
+    uint64_t code_bits[HUFF_MAX_SYMBOLS];
+    int code_len[HUFF_MAX_SYMBOLS];
+    memset(code_len, 0, sizeof(code_len));
+    collect_huff_codes(root_decode, 0, 0, code_bits, code_len);
+
+    HDecodeTable* table = (HDecodeTable*)calloc(1, sizeof(HDecodeTable));
+    if (table == NULL) return NULL;
+    table->root = root_decode;
+
+    // Tabla de un símbolo por consulta y longitud máxima de los códigos de cada prefijo largo.
+    unsigned char single_sym[1 << HUFF_DECODE_TABLE_BITS];
+    unsigned char single_len[1 << HUFF_DECODE_TABLE_BITS];
+    int prefix_max[1 << HUFF_DECODE_TABLE_BITS];
+    memset(single_len, 0, sizeof(single_len));
+    memset(prefix_max, 0, sizeof(prefix_max));
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        int len = code_len[s];
+        if (len == 0) continue;
+        if (len <= root_bits) {
+            size_t first = (size_t)code_bits[s] << (root_bits - len);
+            for (size_t k = 0; k < ((size_t)1 << (root_bits - len)); k++) {
+                single_sym[first + k] = (unsigned char)s;
+                single_len[first + k] = (unsigned char)len;
+            }
+        } else {
+            size_t prefix = (size_t)(code_bits[s] >> (len - root_bits));
+            if (len > prefix_max[prefix]) prefix_max[prefix] = len;
+        }
+    }
+
+    // Reserva las tablas secundarias de forma contigua.
+    size_t sub_total = 0;
+    for (size_t i = 0; i < root_size; i++) {
+        if (prefix_max[i] == 0) continue;
+        int sub_bits = prefix_max[i] - root_bits;
+        if (sub_bits > HUFF_DECODE_SUB_BITS) sub_bits = HUFF_DECODE_SUB_BITS;
+        table->primary[i].sub_bits = (unsigned char)sub_bits;
+        table->primary[i].sub = (uint32_t)sub_total;
+        sub_total += (size_t)1 << sub_bits;
+    }
+    if (sub_total > 0) {
+        table->sub = (struct huff_decode_entry*)calloc(sub_total, sizeof(struct huff_decode_entry));
+        if (table->sub == NULL) {
+            free(table);
+            return NULL;
+        }
+    }
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        int len = code_len[s];
+        if (len <= root_bits) continue;
+        size_t prefix = (size_t)(code_bits[s] >> (len - root_bits));
+        int sub_bits = table->primary[prefix].sub_bits;
+        int rest = len - root_bits;
+        uint64_t rest_code = code_bits[s] & ((((uint64_t)1) << rest) - 1);
+        struct huff_decode_entry* sub = table->sub + table->primary[prefix].sub;
+        if (rest <= sub_bits) {
+            size_t first = (size_t)rest_code << (sub_bits - rest);
+            for (size_t k = 0; k < ((size_t)1 << (sub_bits - rest)); k++) {
+                sub[first + k].symbols[0] = (unsigned char)s;
+                sub[first + k].n_symbols = 1;
+                sub[first + k].n_bits = (unsigned char)len;
+                sub[first + k].first_bits = (unsigned char)len;
+            }
+        }
+        // Los códigos que no caben en la tabla secundaria dejan su entrada sin símbolos
+        // y se resuelven recorriendo el árbol.
+    }
+
+    // Tabla principal: encadena tantos símbolos como quepan en root_bits bits.
+    const size_t mask = root_size - 1;
+    for (size_t i = 0; i < root_size; i++) {
+        struct huff_decode_entry* e = &table->primary[i];
+        if (single_len[i] == 0) continue; // Prefijo largo (tabla secundaria) o inválido.
+        int bits = single_len[i];
+        e->symbols[0] = single_sym[i];
+        e->first_bits = (unsigned char)bits;
+        e->n_symbols = 1;
+        while (e->n_symbols < HUFF_DECODE_MAX_SYMS && bits < root_bits) {
+            size_t next = (i << bits) & mask;
+            if (single_len[next] == 0 || bits + single_len[next] > root_bits) break;
+            e->symbols[e->n_symbols++] = single_sym[next];
+            bits += single_len[next];
+        }
+        e->n_bits = (unsigned char)bits;
+    }
+    return table;
+}
+
+// Libera la tabla de decodificación.
+void free_huff_decode_table(HDecodeTable* table) {
+    if (table == NULL) return;
+    free(table->sub);
+    free(table);
+}
+
+// Decodifica los bits [*bit_pos, bit_end) de un buffer usando la tabla.
+// Los bits se leen en un acumulador de 64 bits alineado a la izquierda.
+size_t huff_decode_bits(const HDecodeTable* table, const unsigned char* in, uint64_t* bit_pos, uint64_t bit_end,
+                        unsigned char* out, size_t out_cap) {
+    const int root_bits = HUFF_DECODE_TABLE_BITS;
+    uint64_t pos = *bit_pos;
+    size_t byte_cur = (size_t)(pos >> 3);
+    const size_t byte_end = (size_t)((bit_end + 7) >> 3);
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    size_t produced = 0;
+
+    // Carga inicial y descarte de los bits anteriores a pos dentro del primer byte.
+    while (acc_bits <= 56 && byte_cur < byte_end) {
+        acc |= (uint64_t)in[byte_cur++] << (56 - acc_bits);
+        acc_bits += 8;
+    }
+    acc <<= (pos & 7);
+    acc_bits -= (int)(pos & 7);
+
+    while (pos < bit_end && produced < out_cap) {
+        while (acc_bits <= 56 && byte_cur < byte_end) { // Recarga el acumulador byte a byte.
+            acc |= (uint64_t)in[byte_cur++] << (56 - acc_bits);
+            acc_bits += 8;
+        }
+        uint64_t avail = bit_end - pos;
+        const struct huff_decode_entry* e = &table->primary[acc >> (64 - root_bits)];
+        int used;
+        if (e->n_symbols) {
+            if (e->n_bits <= avail && produced + HUFF_DECODE_MAX_SYMS <= out_cap) {
+                // Caso rápido: copia todos los símbolos de la entrada.
+                for (int k = 0; k < HUFF_DECODE_MAX_SYMS; k++) out[produced + k] = e->symbols[k];
+                produced += e->n_symbols;
+                used = e->n_bits;
+            } else if (e->first_bits <= avail) {
+                out[produced++] = e->symbols[0];
+                used = e->first_bits;
+            } else {
+                break; // Los bits restantes no forman un código completo (relleno).
+            }
+        } else if (e->sub_bits) {
+            const struct huff_decode_entry* se =
+                &table->sub[e->sub + (size_t)((acc << root_bits) >> (64 - e->sub_bits))];
+            if (se->n_symbols) {
+                if (se->n_bits > avail) break;
+                out[produced++] = se->symbols[0];
+                used = se->n_bits;
+            } else {
+                // Código más largo que las dos tablas: se recorre el árbol con los bits del acumulador.
+                const HDecodeNode* node = table->root;
+                int len = 0;
+                while (node != NULL && !node->is_leaf && len < acc_bits) {
+                    node = ((acc << len) >> 63) ? node->right : node->left;
+                    len++;
+                }
+                if (node == NULL || !node->is_leaf || (uint64_t)len > avail) break;
+                out[produced++] = (unsigned char)node->symbol;
+                used = len;
+            }
+        } else {
+            break; // Prefijo que no corresponde a ningún código.
+        }
+        acc <<= used;
+        acc_bits -= used;
+        pos += (uint64_t)used;
+    }
+    *bit_pos = pos;
+    return produced;
+}
+
+// Lee 8 bytes en big-endian (el primer bit del flujo queda en el bit más significativo).
+static inline uint64_t huff_load_be64(const unsigned char* src) {
+    uint64_t value;
+    memcpy(&value, src, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// Estado de un flujo de bits dentro de huff_decode_interleaved.
+struct huff_lane {
+    const unsigned char* in;      // Bytes del flujo.
+    uint64_t             pos;     // Bits consumidos.
+    uint64_t             bit_end; // Bits del flujo.
+    unsigned char*       out;     // Siguiente posición de salida del trozo.
+    size_t               left;    // Símbolos que faltan en el trozo.
+};
+
+// Avanza un flujo una búsqueda en la tabla. El llamador garantiza que quedan al menos 8 bytes
+// en el flujo y HUFF_DECODE_MAX_SYMS símbolos en el trozo. Devuelve 0, o -1 si el código no es válido.
+static inline int huff_lane_step(const HDecodeTable* table, struct huff_lane* l) {
+    const int root_bits = HUFF_DECODE_TABLE_BITS;
+    uint64_t bits = huff_load_be64(l->in + (l->pos >> 3)) << (l->pos & 7); // Al menos 57 bits válidos.
+    const struct huff_decode_entry* e = &table->primary[bits >> (64 - root_bits)];
+    if (e->n_symbols) {
+        memcpy(l->out, e->symbols, HUFF_DECODE_MAX_SYMS);
+        l->out += e->n_symbols;
+        l->left -= e->n_symbols;
+        l->pos += e->n_bits;
+        return 0;
+    }
+    if (e->sub_bits) {
+        const struct huff_decode_entry* se = &table->sub[e->sub + (size_t)((bits << root_bits) >> (64 - e->sub_bits))];
+        if (se->n_symbols) {
+            *l->out++ = se->symbols[0];
+            l->left--;
+            l->pos += se->n_bits;
+            return 0;
+        }
+    }
+    // Código más largo que las tablas (o inválido): lo resuelve el decodificador general.
+    if (huff_decode_bits(table, l->in, &l->pos, l->bit_end, l->out, 1) != 1) return -1;
+    l->out++;
+    l->left--;
+    return 0;
+}
+
+// Hace rounds vueltas en las que cada flujo avanza un paso. Con n_streams constante el
+// compilador desenrolla el ciclo interno y mantiene el estado de los flujos en registros.
+static inline int huff_lanes_run(const HDecodeTable* table, struct huff_lane* lanes, int n_streams, size_t rounds) {
+    int err = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        for (int k = 0; k < n_streams; k++) err |= huff_lane_step(table, &lanes[k]);
+    }
+    return err;
+}
+
+// Decodifica n_streams flujos consecutivos de in, cada uno en su trozo consecutivo de out.
+// En cada vuelta del ciclo cada flujo hace una búsqueda en la tabla: las búsquedas de flujos
+// distintos no dependen entre sí, así que el procesador las solapa.
+int huff_decode_interleaved(const HDecodeTable* table, const unsigned char* in, const uint32_t* stream_len,
+                            int n_streams, unsigned char* out, const uint32_t* seg_len) {
+    struct huff_lane lanes[HUFF_MAX_STREAMS];
+    if (n_streams < 1 || n_streams > HUFF_MAX_STREAMS) return -1;
+    for (int k = 0; k < n_streams; k++) {
+        lanes[k].in = in;
+        lanes[k].pos = 0;
+        lanes[k].bit_end = (uint64_t)stream_len[k] * 8;
+        lanes[k].out = out;
+        lanes[k].left = seg_len[k];
+        in += stream_len[k];
+        out += seg_len[k];
+    }
+    for (;;) {
+        // Vueltas seguras para todos los flujos: un paso consume como mucho 63 bits (y la lectura
+        // de 8 bytes queda dentro del flujo) y emite como mucho HUFF_DECODE_MAX_SYMS símbolos.
+        size_t rounds = SIZE_MAX;
+        for (int k = 0; k < n_streams; k++) {
+            uint64_t avail = lanes[k].bit_end - lanes[k].pos;
+            size_t r = avail > 64 ? (size_t)((avail - 64) / 64) : 0;
+            if (lanes[k].left / HUFF_DECODE_MAX_SYMS < r) r = lanes[k].left / HUFF_DECODE_MAX_SYMS;
+            if (r < rounds) rounds = r;
+        }
+        if (rounds == 0) break;
+        int err;
+        switch (n_streams) {
+        case 2: err = huff_lanes_run(table, lanes, 2, rounds); break;
+        case 4: err = huff_lanes_run(table, lanes, 4, rounds); break;
+        case 8: err = huff_lanes_run(table, lanes, 8, rounds); break;
+        default: err = huff_lanes_run(table, lanes, n_streams, rounds); break;
+        }
+        if (err) return -1;
+    }
+    // Final de cada flujo: el decodificador general respeta bit_end y la cantidad exacta.
+    for (int k = 0; k < n_streams; k++) {
+        if (huff_decode_bits(table, lanes[k].in, &lanes[k].pos, lanes[k].bit_end, lanes[k].out, lanes[k].left) != lanes[k].left) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Construye el árbol de decodificación a partir de las longitudes de los códigos canónicos.
+int build_huff_decode_tree_from_lengths(const unsigned char* lengths, HDecodeNode* root_decode) {
+    uint64_t codes[HUFF_MAX_SYMBOLS];
+    if (huff_canonical_codes(lengths, codes) != 0) return -1;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        int len = lengths[s];
+        if (len == 0) continue;
+        if (len > 63) return -1;
+        HDecodeNode* curr_node = root_decode;
+        for (int b = len - 1; b >= 0; b--) {
+            HDecodeNode** next = ((codes[s] >> b) & 1) ? &curr_node->right : &curr_node->left;
+            if (*next == NULL) {
+                *next = create_huff_decode_node();
+                if (*next == NULL) return -1;
+            }
+            curr_node = *next;
+        }
+        curr_node->is_leaf = 1;
+        curr_node->symbol = (char)s;
+    }
+    return 0;
+}
+
+// Lee un archivo abierto completo en memoria. Devuelve NULL si no hay memoria.
+static unsigned char* read_huff_input(FILE* f_in, size_t* len) {
+    size_t in_len = 0, in_cap = HUFF_IO_BUFFER_SIZE;
+    unsigned char* in = (unsigned char*)malloc(in_cap);
+    if (in == NULL) return NULL;
+    size_t n;
+    while ((n = fread(in + in_len, 1, in_cap - in_len, f_in)) > 0) {
+        in_len += n;
+        if (in_len == in_cap) {
+            unsigned char* grown = (unsigned char*)realloc(in, in_cap * 2);
+            if (grown == NULL) {
+                free(in);
+                return NULL;
+            }
+            in = grown;
+            in_cap *= 2;
+        }
+    }
+    *len = in_len;
+    return in;
+}
+
+// Decodifica hasta max_symbols símbolos de los bits [bit_pos, bit_end) y los escribe en f_out
+// en bloques grandes. Deja en *written los símbolos escritos. Devuelve 0, o -1 si una escritura
+// quedó corta.
+static int write_huff_decoded(const HDecodeTable* table, const unsigned char* in, uint64_t bit_pos, uint64_t bit_end,
+                              uint64_t max_symbols, FILE* f_out, uint64_t* written) {
+    *written = 0;
+    unsigned char* out = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    if (out == NULL) return 0;
+    uint64_t total = 0;
+    int ret = 0;
+    while (total < max_symbols) {
+        size_t cap = HUFF_IO_BUFFER_SIZE;
+        if (max_symbols - total < cap) cap = (size_t)(max_symbols - total);
+        size_t produced = huff_decode_bits(table, in, &bit_pos, bit_end, out, cap);
+        if (produced == 0) break;
+        if (fwrite(out, 1, produced, f_out) != produced) {
+            ret = -1;
+            break;
+        }
+        total += produced;
+    }
+    free(out);
+    *written = total;
+    return ret;
+}
+
+// Decodifica un archivo basado en el árbol de decodificación Huffman.
+// Lee el archivo codificado completo en memoria, decodifica con la tabla de varios bits
+// y escribe la salida en bloques grandes en lugar de un fprintf por símbolo.
+void huff_decode(FILE* f_in, FILE* f_out, HDecodeNode* root_decode) {
+    if (root_decode == NULL || root_decode->is_leaf) return; // Sin códigos no hay nada que decodificar.
+    size_t in_len = 0;
+    unsigned char* in = read_huff_input(f_in, &in_len);
+    HDecodeTable* table = build_huff_decode_table(root_decode);
+    if (in != NULL && table != NULL) {
+        // El formato anterior no guarda la longitud original: se decodifica hasta agotar los bits.
+        uint64_t written;
+        write_huff_decoded(table, in, 0, (uint64_t)in_len * 8, UINT64_MAX, f_out, &written);
+    }
+    free_huff_decode_table(table);
+    free(in);
+}
+
+// Decodifica un archivo en el formato binario (huff_format.h) ya leído en memoria.
+static int huff_decode_container(const unsigned char* in, size_t in_len, FILE* f_out, const HOptions* opts, HFileResult* res) {
+    int stats = opts ? opts->stats : 0;
+    HPhaseClock clock = {0, 0};
+    huff_phase_start(&clock, stats);
+    if (huff_container_version(in, in_len) == HUFF_STREAM_VERSION) {
+        // Formato por bloques: los bloques son independientes y se reparten entre los hilos, así
+        // que la tabla de cada bloque se cuenta dentro de la decodificación.
+        int ret = huff_decode_blocks_parallel(in, in_len, f_out, opts ? opts->threads : 1, res);
+        huff_phase_stop(&clock, stats, res, HUFF_PHASE_DECODE);
+        return ret;
+    }
+    if (huff_container_version(in, in_len) == HUFF_ANS_VERSION) {
+        // rANS: la tabla de decodificación se arma junto con la decodificación.
+        int ret = huff_ans_decode_file(in, in_len, 0, UINT64_MAX, f_out, res);
+        huff_phase_stop(&clock, stats, res, HUFF_PHASE_DECODE);
+        return ret;
+    }
+    if (huff_container_version(in, in_len) == HUFF_O1_VERSION) {
+        // Orden 1: las tablas de los grupos se arman junto con la decodificación.
+        int ret = huff_o1_decode_file(in, in_len, 0, UINT64_MAX, f_out, res);
+        huff_phase_stop(&clock, stats, res, HUFF_PHASE_DECODE);
+        return ret;
+    }
+    HHeader header;
+    long header_len = huff_read_header(in, in_len, &header);
+    if (header_len < 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid header");
+        return -1;
+    }
+    if (header.flags & HUFF_FLAG_DICT) {
+        // Los códigos están en el diccionario con el que se codificó el archivo.
+        const HDict* dict = opts ? opts->dict : NULL;
+        if (dict == NULL || dict->id != header.dict_id) {
+            snprintf(res->msg, sizeof(res->msg), "needs dictionary %08x (--dict)", (unsigned)header.dict_id);
+            return -1;
+        }
+        memcpy(header.lengths, dict->lengths, HUFF_MAX_SYMBOLS);
+    }
+    if (header.orig_len == 0) return 0;
+    HDecodeNode* root_decode = create_huff_decode_node();
+    if (root_decode == NULL || build_huff_decode_tree_from_lengths(header.lengths, root_decode) != 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid code lengths");
+        free_huff_decode_tree(root_decode);
+        return -1;
+    }
+    HDecodeTable* table = build_huff_decode_table(root_decode);
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_TREE);
+    huff_phase_start(&clock, stats);
+    uint64_t written = 0;
+    int write_failed = 0;
+    if (table != NULL) {
+        write_failed = write_huff_decoded(table, in, (uint64_t)header_len * 8, (uint64_t)in_len * 8, header.orig_len,
+                                          f_out, &written) != 0;
+    }
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_DECODE);
+    free_huff_decode_table(table);
+    free_huff_decode_tree(root_decode);
+    if (write_failed) {
+        snprintf(res->msg, sizeof(res->msg), "cannot write output");
+        return -1;
+    }
+    if (written != header.orig_len) {
+        snprintf(res->msg, sizeof(res->msg), "truncated or corrupt data (%llu of %llu bytes)",
+                 (unsigned long long)written, (unsigned long long)header.orig_len);
+        return -1;
+    }
+    return 0;
+}
+
+// Interfaz reentrante para decodificar un archivo ya cargado en memoria.
+// Los archivos en el formato binario se decodifican solo con su encabezado. Los archivos en el
+// formato anterior solo se aceptan con opts->legacy y usan el codebook indicado.
+// No escribe en stdout; el resultado queda en res.
+int huff_decode_memory_r(const unsigned char* in, size_t in_len, const char* filename, const char* codebook_filename,
+                         FILE* f_out, const HOptions* opts, HFileResult* res){
+    memset(res, 0, sizeof(*res));
+    res->status = -1;
+    int legacy = opts ? opts->legacy : 0;
+    int container = huff_is_container(in, in_len);
+    if(!container && !legacy){
+        snprintf(res->msg, sizeof(res->msg), "%s is not a compressed container (use --legacy)", filename);
+        return -1;
+    }
+
+    int stats = opts ? opts->stats : 0;
+    HPhaseClock clock = {0, 0};
+    int ret = 0;
+    if(container){
+        ret = huff_decode_container(in, in_len, f_out, opts, res);
+    }else{
+        FILE* f_in = fopen(codebook_filename, "rb");
+        if(f_in == NULL){
+            snprintf(res->msg, sizeof(res->msg), "cannot open %s", codebook_filename);
+            return -1;
+        }
+        huff_phase_start(&clock, stats);
+        HDecodeNode* root_decode = create_huff_decode_node();
+        build_huff_decode_tree(f_in, root_decode); // Construye el árbol de decodificación.
+        fclose(f_in); // Cierra el archivo del libro de códigos.
+        huff_phase_stop(&clock, stats, res, HUFF_PHASE_TREE);
+        if(!root_decode->is_leaf){
+            huff_phase_start(&clock, stats);
+            HDecodeTable* table = build_huff_decode_table(root_decode);
+            huff_phase_stop(&clock, stats, res, HUFF_PHASE_TREE);
+            huff_phase_start(&clock, stats);
+            uint64_t written;
+            if(table != NULL && write_huff_decoded(table, in, 0, (uint64_t)in_len * 8, UINT64_MAX, f_out, &written) != 0){
+                snprintf(res->msg, sizeof(res->msg), "cannot write output");
+                ret = -1;
+            }
+            free_huff_decode_table(table);
+            huff_phase_stop(&clock, stats, res, HUFF_PHASE_DECODE);
+        }
+        free_huff_decode_tree(root_decode); // Libera la memoria del árbol.
+    }
+    res->bytes_in = in_len;
+    res->bytes_out = (size_t)ftell(f_out);
+    if(ret != 0) return -1;
+    // Una escritura que falla en el buffer de stdio puede no llegar a verse en fwrite ni en fclose.
+    if(ferror(f_out)){
+        snprintf(res->msg, sizeof(res->msg), "cannot write output");
+        return -1;
+    }
+    res->status = 0;
+    return 0;
+}
+
+// Interfaz reentrante para decodificar un archivo: lo carga en memoria (mmap o una lectura grande)
+// y lo decodifica con huff_decode_memory_r.
+int huff_decode_file_r(const char* filename, const char* codebook_filename, const char* decoded_filename, const HOptions* opts, HFileResult* res){
+    memset(res, 0, sizeof(*res));
+    res->status = -1;
+    HInput input;
+    if(huff_input_open(filename, &input) != 0){
+        snprintf(res->msg, sizeof(res->msg), "cannot open %s", filename);
+        return -1;
+    }
+    FILE* f_out = fopen(decoded_filename, "wb"); // Abre el archivo de salida.
+    if(f_out == NULL){
+        snprintf(res->msg, sizeof(res->msg), "cannot open %s", decoded_filename);
+        huff_input_close(&input);
+        return -1;
+    }
+    int ret = huff_decode_memory_r(input.data, input.len, filename, codebook_filename, f_out, opts, res);
+    huff_input_close(&input);
+    if(fclose(f_out) != 0 && ret == 0){
+        snprintf(res->msg, sizeof(res->msg), "cannot write %s", decoded_filename);
+        res->status = -1;
+        ret = -1;
+    }
+    return ret;
+}
+
+// Interfaz para decodificar un archivo usando el libro de códigos especificado.
+int huff_decode_file(const char* filename, const char* codebook_filename, const char* decoded_filename){
+    HFileResult res;
+    HOptions opts;
+    huff_options_default(&opts);
+    opts.legacy = 1; // Acepta tanto el formato binario como el anterior.
+    int ret = huff_decode_file_r(filename, codebook_filename, decoded_filename, &opts, &res);
+    if(ret != 0){
+        printf("%s\n.exit.\n", res.msg);
+    }
+    return ret;
+}
@@ -1,39 +1,99 @@
-#ifndef HUFF_DECODE_H
-#define HUFF_DECODE_H
-
-#include "huff_const.h"
-
-// Define la estructura del nodo de decodificación Huffman.
-struct huff_decode_node {
-	struct huff_decode_node* left;  
-	struct huff_decode_node* right; 
-	int is_leaf;                    // Indica si el nodo es una hoja.
-	char symbol;                    // El símbolo que representa el nodo (en caso de ser una hoja).
-};
-
-// Nombre corto para la estructura de nodo de decodificación Huffman.
-typedef struct huff_decode_node HDecodeNode;
-
-// Función utilizada para crear un nodo de decodificación Huffman.
-HDecodeNode* create_huff_decode_node();
-
-// Función utilizada para liberar la memoria asignada al árbol de decodificación.
-void free_huff_decode_tree(HDecodeNode* node);
-
-// Función para construir un árbol de decodificación Huffman basado en el libro de códigos.
-// El formato del libro de códigos debe ser como sigue:
-// a 10000
-// b 10001
-// ...
-// Para cada símbolo, crea nodos desde la parte superior hasta la inferior del árbol.
-void build_huff_decode_tree(FILE* fp, HDecodeNode* root_decode);
-
-// Función para decodificar.
-// f_in es el puntero al archivo codificado.
-// f_out es el puntero al archivo donde escribir el mensaje decodificado.
-void huff_decode(FILE* f_in, FILE* f_out, HDecodeNode* root_decode);
-
-// Interfaz para decodificar un archivo.
-int huff_decode_file(const char* filename, const char* codebook_filename, const char* decoded_filename);
-
-#endif // HUFF_DECODE_H
+#ifndef HUFF_DECODE_H
+#define HUFF_DECODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_const.h"
+#include "huff_result.h"
+#include "huff_options.h"
+
+// Define la estructura del nodo de decodificación Huffman.
+struct huff_decode_node {
+	struct huff_decode_node* left;  
+	struct huff_decode_node* right; 
+	int is_leaf;                    // Indica si el nodo es una hoja.
+	char symbol;                    // El símbolo que representa el nodo (en caso de ser una hoja).
+};
+
+// Nombre corto para la estructura de nodo de decodificación Huffman.
+typedef struct huff_decode_node HDecodeNode;
+
+// Entrada de la tabla de decodificación. En la tabla principal una entrada emite hasta
+// HUFF_DECODE_MAX_SYMS símbolos cuyos códigos caben en HUFF_DECODE_TABLE_BITS bits, o apunta
+// a una tabla secundaria (sub_bits > 0) para los códigos más largos. En una tabla secundaria,
+// una entrada sin símbolos indica un código demasiado largo que se resuelve con el árbol.
+struct huff_decode_entry {
+	unsigned char symbols[HUFF_DECODE_MAX_SYMS]; // Símbolos decodificados.
+	unsigned char n_symbols;                     // Cantidad de símbolos (0 = tabla secundaria o árbol).
+	unsigned char n_bits;                        // Bits que consumen todos los símbolos.
+	unsigned char first_bits;                    // Bits que consume solo el primer símbolo.
+	unsigned char sub_bits;                      // Bits indexados por la tabla secundaria.
+	uint32_t      sub;                           // Posición de la tabla secundaria.
+};
+
+// Tabla de decodificación construida a partir del árbol.
+struct huff_decode_table {
+	struct huff_decode_entry  primary[1 << HUFF_DECODE_TABLE_BITS]; // Tabla principal.
+	struct huff_decode_entry* sub;                                  // Tablas secundarias contiguas.
+	const struct huff_decode_node* root;                            // Árbol para los códigos más largos.
+};
+
+// Nombre corto para la tabla de decodificación.
+typedef struct huff_decode_table HDecodeTable;
+
+// Función utilizada para crear un nodo de decodificación Huffman.
+HDecodeNode* create_huff_decode_node();
+
+// Función utilizada para liberar la memoria asignada al árbol de decodificación.
+void free_huff_decode_tree(HDecodeNode* node);
+
+// Función para construir un árbol de decodificación Huffman basado en el libro de códigos.
+// El formato del libro de códigos debe ser como sigue:
+// a 10000
+// b 10001
+// ...
+// Para cada símbolo, crea nodos desde la parte superior hasta la inferior del árbol.
+void build_huff_decode_tree(FILE* fp, HDecodeNode* root_decode);
+
+// Función para construir el árbol de decodificación a partir de las longitudes de códigos
+// canónicos (huff_format.h). Devuelve 0, o -1 si las longitudes no son válidas.
+int build_huff_decode_tree_from_lengths(const unsigned char* lengths, HDecodeNode* root_decode);
+
+// Función para construir la tabla de decodificación a partir del árbol.
+// El árbol debe seguir existiendo mientras se use la tabla.
+HDecodeTable* build_huff_decode_table(const HDecodeNode* root_decode);
+
+// Función para liberar la tabla de decodificación.
+void free_huff_decode_table(HDecodeTable* table);
+
+// Función para decodificar los bits [*bit_pos, bit_end) de un buffer en memoria.
+// Escribe como máximo out_cap símbolos en out, avanza *bit_pos y devuelve los símbolos escritos.
+// Se detiene cuando los bits restantes no forman un código completo.
+size_t huff_decode_bits(const HDecodeTable* table, const unsigned char* in, uint64_t* bit_pos, uint64_t bit_end,
+                        unsigned char* out, size_t out_cap);
+
+// Función para decodificar n_streams flujos de bits guardados uno detrás de otro en in
+// (stream_len[k] bytes cada uno). El flujo k produce exactamente seg_len[k] símbolos, que se
+// escriben uno detrás de otro en out. Todos los flujos avanzan en el mismo ciclo.
+// Devuelve 0, o -1 si algún flujo no contiene sus símbolos.
+int huff_decode_interleaved(const HDecodeTable* table, const unsigned char* in, const uint32_t* stream_len,
+                            int n_streams, unsigned char* out, const uint32_t* seg_len);
+
+// Función para decodificar.
+// f_in es el puntero al archivo codificado.
+// f_out es el puntero al archivo donde escribir el mensaje decodificado.
+void huff_decode(FILE* f_in, FILE* f_out, HDecodeNode* root_decode);
+
+// Interfaz para decodificar un archivo (formato binario o, con su codebook, formato anterior).
+int huff_decode_file(const char* filename, const char* codebook_filename, const char* decoded_filename);
+
+// Interfaz reentrante para decodificar un archivo: no escribe en stdout y deja el resultado en res.
+// El formato anterior (flujo de bits más codebook_filename) solo se acepta con opts->legacy.
+int huff_decode_file_r(const char* filename, const char* codebook_filename, const char* decoded_filename, const HOptions* opts, HFileResult* res);
+
+// Interfaz reentrante para decodificar in_len bytes en memoria y escribir el resultado en f_out (que
+// no se cierra). filename es el nombre del archivo codificado, solo para los mensajes de error.
+int huff_decode_memory_r(const unsigned char* in, size_t in_len, const char* filename, const char* codebook_filename,
+                         FILE* f_out, const HOptions* opts, HFileResult* res);
+
+#endif // HUFF_DECODE_H
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "huff_dict.h"
+#include "huff_encode.h"
+#include "huff_histogram.h"
+#include "huff_batch.h"
+#include "huff_io.h"
+#include "huff_format.h"
+
+// Calcula el identificador de las longitudes.
+uint32_t huff_dict_id(const unsigned char* lengths) {
+    uint32_t hash = 2166136261u;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        hash ^= lengths[s];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Entrena un diccionario con una muestra de cada archivo del directorio.
+int huff_dict_train(const char* input_dir, size_t sample_per_file, int max_code_len, HDict* dict,
+                    uint64_t* sampled, size_t* n_files) {
+    if (sample_per_file == 0) sample_per_file = HUFF_DICT_SAMPLE;
+    if (max_code_len <= 0) max_code_len = HUFF_DICT_MAX_LEN;
+    if (max_code_len > HUFF_MAX_LEN - 1) max_code_len = HUFF_MAX_LEN - 1;
+    *sampled = 0;
+    *n_files = 0;
+    HBatch batch; // Solo para listar los archivos regulares del directorio.
+    if (huff_batch_scan(&batch, 1, input_dir, "", NULL) != 0) return -1;
+    uint64_t counts[HUFF_MAX_SYMBOLS];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < batch.count; i++) {
+        HInput input;
+        if (huff_input_open(batch.jobs[i].input_path, &input) != 0) continue;
+        size_t n = input.len < sample_per_file ? input.len : sample_per_file;
+        huff_histogram(input.data, n, counts);
+        huff_input_close(&input);
+        *sampled += n;
+        (*n_files)++;
+    }
+    huff_batch_free(&batch);
+    // Cada símbolo cuenta al menos una vez: los bytes que no aparecen en la muestra reciben un
+    // código largo en lugar de ninguno.
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        counts[s]++;
+    }
+    HTreeArena arena;
+    memset(dict, 0, sizeof(*dict));
+    huff_build_code_lengths(counts, max_code_len, &arena, dict->lengths, NULL);
+    dict->id = huff_dict_id(dict->lengths);
+    return 0;
+}
+
+// Guarda el diccionario.
+int huff_dict_save(const HDict* dict, const char* filename) {
+    unsigned char buf[HUFF_DICT_FILE_SIZE];
+    memcpy(buf, HUFF_DICT_MAGIC, HUFF_DICT_MAGIC_LEN);
+    buf[HUFF_DICT_MAGIC_LEN] = HUFF_DICT_VERSION;
+    for (int i = 0; i < 4; i++) {
+        buf[HUFF_DICT_MAGIC_LEN + 1 + i] = (unsigned char)(dict->id >> (8 * i));
+    }
+    memcpy(buf + HUFF_DICT_MAGIC_LEN + 5, dict->lengths, HUFF_MAX_SYMBOLS);
+    FILE* f = fopen(filename, "wb");
+    if (f == NULL) return -1;
+    size_t written = fwrite(buf, 1, sizeof(buf), f);
+    if (fclose(f) != 0 || written != sizeof(buf)) return -1;
+    return 0;
+}
+
+// Carga un diccionario.
+int huff_dict_load(const char* filename, HDict* dict) {
+    unsigned char buf[HUFF_DICT_FILE_SIZE + 1];
+    FILE* f = fopen(filename, "rb");
+    if (f == NULL) return -1;
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    if (n != HUFF_DICT_FILE_SIZE || memcmp(buf, HUFF_DICT_MAGIC, HUFF_DICT_MAGIC_LEN) != 0 ||
+        buf[HUFF_DICT_MAGIC_LEN] != HUFF_DICT_VERSION) {
+        return -1;
+    }
+    dict->id = 0;
+    for (int i = 0; i < 4; i++) {
+        dict->id |= (uint32_t)buf[HUFF_DICT_MAGIC_LEN + 1 + i] << (8 * i);
+    }
+    memcpy(dict->lengths, buf + HUFF_DICT_MAGIC_LEN + 5, HUFF_MAX_SYMBOLS);
+    // Las longitudes deben formar un código completo para todos los símbolos y coincidir con el id.
+    uint64_t codes[HUFF_MAX_SYMBOLS];
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (dict->lengths[s] == 0 || dict->lengths[s] >= HUFF_MAX_LEN) return -1;
+    }
+    if (huff_canonical_codes(dict->lengths, codes) != 0 || huff_dict_id(dict->lengths) != dict->id) return -1;
+    return 0;
+}
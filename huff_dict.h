@@ -0,0 +1,49 @@
+#ifndef HUFF_DICT_H
+#define HUFF_DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "huff_const.h"
+
+// Diccionario: longitudes de códigos canónicos compartidas por todos los archivos de un corpus.
+// Un archivo codificado con el diccionario guarda solo su identificador (HUFF_FLAG_DICT en
+// huff_format.h) y se codifica en una sola pasada, sin histograma ni tabla propia.
+// Formato del archivo del diccionario (enteros en little-endian):
+//
+//   magic       4 bytes  "HUFD"
+//   version     1 byte   HUFF_DICT_VERSION
+//   id          4 bytes  identificador (huff_dict_id de las longitudes)
+//   longitudes  256 bytes, la longitud de cada símbolo (todas distintas de cero)
+#define HUFF_DICT_MAGIC "HUFD"
+#define HUFF_DICT_MAGIC_LEN 4
+#define HUFF_DICT_VERSION 1
+
+// Tamaño del archivo del diccionario.
+#define HUFF_DICT_FILE_SIZE (HUFF_DICT_MAGIC_LEN + 1 + 4 + HUFF_MAX_SYMBOLS)
+
+// Diccionario en memoria.
+struct huff_dict {
+	uint32_t      id;                        // Identificador que se guarda en los archivos.
+	unsigned char lengths[HUFF_MAX_SYMBOLS]; // Longitud del código de cada símbolo.
+};
+
+// Nombre corto para el diccionario.
+typedef struct huff_dict HDict;
+
+// Función para calcular el identificador de un juego de longitudes (FNV-1a de 32 bits).
+uint32_t huff_dict_id(const unsigned char* lengths);
+
+// Función para entrenar un diccionario con los primeros sample_per_file bytes de cada archivo de
+// input_dir (0 = HUFF_DICT_SAMPLE), con códigos de hasta max_code_len bits (0 = HUFF_DICT_MAX_LEN).
+// Todos los símbolos reciben un código, aunque no aparezcan en la muestra, para que cualquier
+// archivo se pueda codificar. En *sampled quedan los bytes leídos y en *n_files los archivos. Devuelve 0 o -1 si no se pudo leer el directorio.
+int huff_dict_train(const char* input_dir, size_t sample_per_file, int max_code_len, HDict* dict,
+                    uint64_t* sampled, size_t* n_files);
+
+// Función para guardar el diccionario en filename. Devuelve 0 o -1.
+int huff_dict_save(const HDict* dict, const char* filename);
+
+// Función para cargar un diccionario. Devuelve 0, o -1 si el archivo no es un diccionario válido.
+int huff_dict_load(const char* filename, HDict* dict);
+
+#endif // !HUFF_DICT_H
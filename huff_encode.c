@@ -1,262 +1,1001 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <assert.h>
-#include "huff_encode.h"
-
-// Función para crear un nodo de codificación Huffman. Asigna memoria para el nodo.
-HEncodeNode* create_huff_encode_node(char symbol, double freq, int is_leaf) {
-    HEncodeNode* p_node = (HEncodeNode*)malloc(sizeof(HEncodeNode));
-    if (p_node != NULL) {
-        p_node->left = NULL;  // Inicializa el hijo izquierdo a NULL
-        p_node->right = NULL; // Inicializa el hijo derecho a NULL
-        p_node->parent = NULL; // Inicializa el padre a NULL
-        p_node->next = NULL; // Inicializa el siguiente nodo en la cola de prioridad a NULL
-        p_node->freq = freq; // Establece la frecuencia del nodo
-        p_node->is_leaf = is_leaf; // Indica si el nodo es una hoja
-        p_node->symbol = symbol; // Establece el símbolo del nodo
-    }
-    return p_node;
-}
-
-// Función para insertar un nodo en la cola de prioridad.
-void insert_huff_pqueue(HEncodeNode* node, HEncodeNode** q_head) {
-    printf("inserting node: (%c, %f)\n", node->symbol, node->freq);
-    if (*q_head == NULL) { // Si la cola está vacía, el nodo se convierte en el nuevo cabeza.
-        *q_head = node;
-        return;
-    }
-    HEncodeNode* curr_node = NULL;
-    HEncodeNode* prev_node = NULL;
-    curr_node = *q_head;
-    // Busca la posición correcta para el nodo según su frecuencia.
-    while ((curr_node != NULL) && (curr_node->freq < node->freq)) {
-        prev_node = curr_node;
-        curr_node = curr_node->next;
-    }
-    // Inserta el nodo en la posición encontrada.
-    if (curr_node == *q_head) {
-        node->next = *q_head;
-        *q_head = node;
-    } else {
-        prev_node->next = node;
-        node->next = curr_node;
-    }
-}
-
-// Función para mostrar la cola de prioridad.
-void disp_huff_pqueue(HEncodeNode* q_head) {
-    printf("priority queue: ");
-    while (q_head) {
-        printf("(%c, %f),", q_head->symbol, q_head->freq);
-        q_head = q_head->next;
-    }
-    printf("\n");
-}
-
-// Función para extraer (pop) el elemento de mayor prioridad (menor frecuencia) de la cola.
-HEncodeNode* pop_huff_pqueue(HEncodeNode** q_head) {
-    if (*q_head == NULL) return NULL;
-    HEncodeNode* p_node = *q_head;
-    *q_head = (*q_head)->next;
-    printf("popped: (%c, %f)\n", p_node->symbol, p_node->freq);
-    return p_node;
-}
-
-// Función para generar el codebook de forma recursiva.
-void generate_huff_codebook(HEncodeNode* root, int depth, char* codebook) {
-    if (root->is_leaf) {
-        int len = depth;
-        char symbol = root->symbol;
-        *(codebook + ((size_t)symbol) * HUFF_MAX_LEN + len) = 0; // Agrega un carácter nulo al final del string.
-        HEncodeNode* parent = root->parent;
-        // Recorre el camino desde la hoja hasta la raíz para generar el código.
-        while (parent != NULL && len > 0) {
-            if (root == parent->left) {
-                *(codebook + ((size_t)symbol) * HUFF_MAX_LEN + (--len)) = '0';
-            } else {
-                *(codebook + ((size_t)symbol) * HUFF_MAX_LEN + (--len)) = '1';
-            }
-            root = parent;
-            parent = root->parent;
-        }
-        printf("built code: (%c, %s)\n", symbol, codebook + ((size_t)symbol) * HUFF_MAX_LEN);
-    } else {
-        // Si no es una hoja, continúa generando el codebook para sus hijos.
-        generate_huff_codebook(root->left, depth + 1, codebook);
-        generate_huff_codebook(root->right, depth + 1, codebook);
-    }
-}
-
-// Función para escribir el codebook en un archivo.
-void write_huff_codebook(FILE* f_out, char* codebook) {
-    int i = 0;
-    for (i = 0; i < HUFF_MAX_SYMBOLS; i++) {
-        if (*(codebook + i * HUFF_MAX_LEN)) {
-            fprintf(f_out, "#%c %s\n", i, codebook + i * HUFF_MAX_LEN);
-        }
-    }
-}
-
-// Función para escribir el flujo de bits codificados en un archivo.
-void write_huff_encode_stream(FILE* f_out, char* str, char* codebook) {
-    while (*str) {
-        fprintf(f_out, "%s", codebook + (size_t)(*str) * HUFF_MAX_LEN);
-        str++;
-    }
-}
-
-// Función para liberar la memoria del árbol de codificación Huffman.
-void free_huff_encode_tree(HEncodeNode* root) {
-    if (root == NULL) return;
-    free_huff_encode_tree(root->left);
-    free_huff_encode_tree(root->right);
-    free(root);
-}
-
-// Función para construir el árbol de codificación Huffman a partir de un arreglo de símbolos y sus frecuencias.
-void build_huff_encode_tree(const char* str_arr, const double* freq_arr, size_t len, HEncodeNode** q_head) {
-    size_t i = 0;
-    HEncodeNode* left = NULL;
-    HEncodeNode* right = NULL;
-    HEncodeNode* parent = NULL;
-    // Inserta todos los elementos en la cola de prioridad.
-    for (i = 0; i < len; i++) {
-        insert_huff_pqueue(create_huff_encode_node(str_arr[i], freq_arr[i], 1), q_head);
-    }
-    // Construye el árbol combinando los dos nodos de menor frecuencia hasta que solo queda uno.
-    for (i = 0; i < len - 1; i++) {
-        left = pop_huff_pqueue(q_head);
-        right = pop_huff_pqueue(q_head);
-        parent = create_huff_encode_node(0, left->freq + right->freq, 0);
-        parent->left = left;
-        parent->right = right;
-        left->parent = parent;
-        right->parent = parent;
-        insert_huff_pqueue(parent, q_head);
-    }
-}
-
-// Función para construir el árbol de codificación Huffman utilizando solo un arreglo de frecuencias.
-void build_huff_encode_tree256(double* freq_arr, size_t len, HEncodeNode** q_head) {
-    assert(len == 256 && 256 <= HUFF_MAX_SYMBOLS);
-    size_t i = 0;
-    HEncodeNode* left = NULL;
-    HEncodeNode* right = NULL;
-    HEncodeNode* parent = NULL;
-    size_t valid_char_num = 0;
-    // Inserta todos los caracteres válidos en la cola de prioridad.
-    for (i = 0; i < len; i++) {
-        if (freq_arr[i] > 0.0f) {
-            insert_huff_pqueue(create_huff_encode_node((char)i, freq_arr[i], 1), q_head);
-            valid_char_num++;
-        }
-    }
-    // Construye el árbol combinando nodos de la cola.
-    for (i = 0; i < valid_char_num - 1; i++) {
-        left = pop_huff_pqueue(q_head);
-        right = pop_huff_pqueue(q_head);
-        parent = create_huff_encode_node(0, left->freq + right->freq, 0);
-        parent->left = left;
-        parent->right = right;
-        left->parent = parent;
-        right->parent = parent;
-        insert_huff_pqueue(parent, q_head);
-    }
-}
-
-// Función para escribir el archivo codificado leyendo del archivo original.
-void write_huff_encode_stream_from_file(FILE* f_in, FILE* f_out, char* codebook) {
-    char c;
-    unsigned char buffer = 0;
-    int bit_count = 0;
-    // Lee cada carácter del archivo de entrada, busca su código en el codebook y escribe el flujo de bits en el archivo de salida.
-    while ((c = getc(f_in)) != EOF) {
-        char* code = codebook + (size_t)c * HUFF_MAX_LEN;
-        while (*code) {
-            buffer = (buffer << 1) | (*code - '0'); // Convierte el código de string a bits.
-            bit_count++;
-            if (bit_count == 8) { // Cuando el buffer está lleno, escribe en el archivo de salida.
-                fwrite(&buffer, sizeof(buffer), 1, f_out);
-                buffer = 0;
-                bit_count = 0;
-            }
-            code++;
-        }
-    }
-    // Escribe los bits restantes en el archivo de salida.
-    if (bit_count > 0) {
-        buffer <<= (8 - bit_count); // Alinea los bits a la derecha.
-        fwrite(&buffer, sizeof(buffer), 1, f_out);
-    }
-}
-
-// Función para contar los caracteres ASCII en el archivo de entrada y calcular su frecuencia.
-void huff_count_char(double* freq_arr, FILE* f_in, size_t len) {
-    assert(len == 256 && len <= HUFF_MAX_SYMBOLS);
-    char c;
-    double s = 0.0f; // Suma total de caracteres.
-    // Cuenta cada carácter y suma al total.
-    while ((c = getc(f_in)) != EOF) {
-        freq_arr[(size_t)c] += 1.0f;
-        s += 1.0f;
-    }
-    // Calcula la frecuencia de cada carácter.
-    size_t i = 0;
-    for (i = 0; i < len; i++) {
-        if (freq_arr[i] > 0.0f) {
-            freq_arr[i] = freq_arr[i] / s;
-        }
-    }
-}
-
-// Función interfaz para codificar un archivo. Genera el archivo codificado y el codebook.
-int huff_encode_file(const char* filename, const char* encoded_filename, const char* codebooks_dir) {
-    FILE* f_in = fopen(filename, "r");
-    if (f_in == NULL) {
-        printf("Cannot open %s\n.exit.\n", filename);
-        return -1;
-    }
-    double freq_arr[HUFF_MAX_SYMBOLS];
-    for (int i = 0; i < HUFF_MAX_SYMBOLS; i++) {
-        freq_arr[i] = 0.0f; // Inicializa el arreglo de frecuencias.
-    }
-    huff_count_char(freq_arr, f_in, HUFF_MAX_SYMBOLS); // Cuenta y calcula la frecuencia de los caracteres.
-    fclose(f_in);
-    HEncodeNode* q_head = NULL;
-    HEncodeNode* root_encode = NULL;
-    char codebook[HUFF_MAX_SYMBOLS][HUFF_MAX_LEN];
-    memset(codebook, 0, sizeof(codebook)); // Inicializa el codebook.
-    build_huff_encode_tree256(freq_arr, HUFF_MAX_SYMBOLS, &q_head); // Construye el árbol de codificación.
-    root_encode = pop_huff_pqueue(&q_head); // Extrae la raíz del árbol.
-    generate_huff_codebook(root_encode, 0, &codebook[0][0]); // Genera el codebook.
-    // Genera el nombre del archivo del codebook y lo escribe.
-    char* baseName = strrchr(filename, '/');
-    baseName = baseName ? baseName + 1 : (char*)filename;
-    char codebookFilename[1024];
-    snprintf(codebookFilename, sizeof(codebookFilename), "%s/%s_codebook.txt", codebooks_dir, baseName);
-    FILE* f_out = fopen(codebookFilename, "w");
-    if (f_out == NULL) {
-        printf("Cannot open %s\n.exit.\n", codebookFilename);
-        return -1;
-    }
-    write_huff_codebook(f_out, &codebook[0][0]);
-    fclose(f_out);
-    // Abre nuevamente el archivo original y el archivo codificado para escribir el flujo de bits.
-    f_in = fopen(filename, "r");
-    if (f_in == NULL) {
-        printf("Cannot open %s for a second time.\n.exit.\n", filename);
-        return -1;
-    }
-    f_out = fopen(encoded_filename, "wb");
-    if (f_out == NULL) {
-        printf("Cannot open %s\n.exit.\n", encoded_filename);
-        fclose(f_in); // Asegura cerrar el archivo de entrada antes de salir.
-        return -1;
-    }
-    write_huff_encode_stream_from_file(f_in, f_out, &codebook[0][0]); // Escribe el flujo de bits codificado.
-    fclose(f_in);
-    fclose(f_out);
-    free_huff_encode_tree(root_encode); // Libera la memoria del árbol de codificación.
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "huff_encode.h"
+#include "huff_format.h"
+#include "huff_io.h"
+#include "huff_stream.h"
+#include "huff_dict.h"
+#include "huff_stats.h"
+#include "huff_ans.h"
+
+// Función para crear un nodo de codificación Huffman. Asigna memoria para el nodo.
+HEncodeNode* create_huff_encode_node(char symbol, uint64_t freq, int is_leaf) {
+    HEncodeNode* p_node = (HEncodeNode*)malloc(sizeof(HEncodeNode));
+    if (p_node != NULL) {
+        p_node->left = NULL;  // Inicializa el hijo izquierdo a NULL
+        p_node->right = NULL; // Inicializa el hijo derecho a NULL
+        p_node->parent = NULL; // Inicializa el padre a NULL
+        p_node->next = NULL; // Inicializa el siguiente nodo en la cola de prioridad a NULL
+        p_node->freq = freq; // Establece la frecuencia del nodo
+        p_node->is_leaf = is_leaf; // Indica si el nodo es una hoja
+        p_node->symbol = symbol; // Establece el símbolo del nodo
+    }
+    return p_node;
+}
+
+// Función para insertar un nodo en la cola de prioridad.
+void insert_huff_pqueue(HEncodeNode* node, HEncodeNode** q_head) {
+    HUFF_TRACEF("inserting node: (%c, %llu)\n", node->symbol, (unsigned long long)node->freq);
+    if (*q_head == NULL) { // Si la cola está vacía, el nodo se convierte en el nuevo cabeza.
+        *q_head = node;
+        return;
+    }
+    HEncodeNode* curr_node = NULL;
+    HEncodeNode* prev_node = NULL;
+    curr_node = *q_head;
+    // Busca la posición correcta para el nodo según su frecuencia.
+    while ((curr_node != NULL) && (curr_node->freq < node->freq)) {
+        prev_node = curr_node;
+        curr_node = curr_node->next;
+    }
+    // Inserta el nodo en la posición encontrada.
+    if (curr_node == *q_head) {
+        node->next = *q_head;
+        *q_head = node;
+    } else {
+        prev_node->next = node;
+        node->next = curr_node;
+    }
+}
+
+// Función para mostrar la cola de prioridad.
+void disp_huff_pqueue(HEncodeNode* q_head) {
+    printf("priority queue: ");
+    while (q_head) {
+        printf("(%c, %llu),", q_head->symbol, (unsigned long long)q_head->freq);
+        q_head = q_head->next;
+    }
+    printf("\n");
+}
+
+// Función para extraer (pop) el elemento de mayor prioridad (menor frecuencia) de la cola.
+HEncodeNode* pop_huff_pqueue(HEncodeNode** q_head) {
+    if (*q_head == NULL) return NULL;
+    HEncodeNode* p_node = *q_head;
+    *q_head = (*q_head)->next;
+    HUFF_TRACEF("popped: (%c, %llu)\n", p_node->symbol, (unsigned long long)p_node->freq);
+    return p_node;
+}
+
+// Función para generar el codebook de forma recursiva.
+void generate_huff_codebook(HEncodeNode* root, int depth, char* codebook) {
+    if (root->is_leaf) {
+        int len = depth;
+        unsigned char symbol = (unsigned char)root->symbol; // Sin signo: los bytes >= 0x80 no dan índices negativos.
+        *(codebook + ((size_t)symbol) * HUFF_MAX_LEN + len) = 0; // Agrega un carácter nulo al final del string.
+        HEncodeNode* parent = root->parent;
+        // Recorre el camino desde la hoja hasta la raíz para generar el código.
+        while (parent != NULL && len > 0) {
+            if (root == parent->left) {
+                *(codebook + ((size_t)symbol) * HUFF_MAX_LEN + (--len)) = '0';
+            } else {
+                *(codebook + ((size_t)symbol) * HUFF_MAX_LEN + (--len)) = '1';
+            }
+            root = parent;
+            parent = root->parent;
+        }
+        HUFF_TRACEF("built code: (%c, %s)\n", symbol, codebook + ((size_t)symbol) * HUFF_MAX_LEN);
+    } else {
+        // Si no es una hoja, continúa generando el codebook para sus hijos.
+        generate_huff_codebook(root->left, depth + 1, codebook);
+        generate_huff_codebook(root->right, depth + 1, codebook);
+    }
+}
+
+// Función para escribir el codebook en un archivo.
+void write_huff_codebook(FILE* f_out, char* codebook) {
+    int i = 0;
+    for (i = 0; i < HUFF_MAX_SYMBOLS; i++) {
+        if (*(codebook + i * HUFF_MAX_LEN)) {
+            fprintf(f_out, "#%c %s\n", i, codebook + i * HUFF_MAX_LEN);
+        }
+    }
+}
+
+// Función para escribir el flujo de bits codificados en un archivo.
+void write_huff_encode_stream(FILE* f_out, char* str, char* codebook) {
+    while (*str) {
+        fprintf(f_out, "%s", codebook + (size_t)(unsigned char)(*str) * HUFF_MAX_LEN);
+        str++;
+    }
+}
+
+// Función para liberar la memoria del árbol de codificación Huffman.
+void free_huff_encode_tree(HEncodeNode* root) {
+    if (root == NULL) return;
+    free_huff_encode_tree(root->left);
+    free_huff_encode_tree(root->right);
+    free(root);
+}
+
+// Función para construir el árbol de codificación Huffman a partir de un arreglo de símbolos y sus frecuencias.
+void build_huff_encode_tree(const char* str_arr, const uint64_t* freq_arr, size_t len, HEncodeNode** q_head) {
+    size_t i = 0;
+    HEncodeNode* left = NULL;
+    HEncodeNode* right = NULL;
+    HEncodeNode* parent = NULL;
+    // Inserta todos los elementos en la cola de prioridad.
+    for (i = 0; i < len; i++) {
+        insert_huff_pqueue(create_huff_encode_node(str_arr[i], freq_arr[i], 1), q_head);
+    }
+    // Construye el árbol combinando los dos nodos de menor frecuencia hasta que solo queda uno.
+    for (i = 0; i < len - 1; i++) {
+        left = pop_huff_pqueue(q_head);
+        right = pop_huff_pqueue(q_head);
+        parent = create_huff_encode_node(0, left->freq + right->freq, 0);
+        parent->left = left;
+        parent->right = right;
+        left->parent = parent;
+        right->parent = parent;
+        insert_huff_pqueue(parent, q_head);
+    }
+}
+
+// Función para construir el árbol de codificación Huffman utilizando los contadores de cada byte.
+void build_huff_encode_tree256(const uint64_t* counts, size_t len, HEncodeNode** q_head) {
+    assert(len == 256 && 256 <= HUFF_MAX_SYMBOLS);
+    size_t i = 0;
+    HEncodeNode* left = NULL;
+    HEncodeNode* right = NULL;
+    HEncodeNode* parent = NULL;
+    size_t valid_char_num = 0;
+    // Inserta todos los caracteres válidos en la cola de prioridad.
+    for (i = 0; i < len; i++) {
+        if (counts[i] > 0) {
+            insert_huff_pqueue(create_huff_encode_node((char)i, counts[i], 1), q_head);
+            valid_char_num++;
+        }
+    }
+    // Construye el árbol combinando nodos de la cola (un archivo vacío no tiene nodos).
+    for (i = 0; i + 1 < valid_char_num; i++) {
+        left = pop_huff_pqueue(q_head);
+        right = pop_huff_pqueue(q_head);
+        parent = create_huff_encode_node(0, left->freq + right->freq, 0);
+        parent->left = left;
+        parent->right = right;
+        left->parent = parent;
+        right->parent = parent;
+        insert_huff_pqueue(parent, q_head);
+    }
+}
+
+// Elemento de package-merge: una hoja (symbol >= 0) o un paquete de dos elementos del nivel anterior.
+struct huff_pm_item {
+    uint64_t weight;
+    int    symbol;
+    int    left;
+    int    right;
+};
+
+// Suma uno a la longitud de cada hoja contenida en el elemento.
+static void huff_pm_count(const struct huff_pm_item* pool, int idx, unsigned char* lengths) {
+    if (pool[idx].symbol >= 0) {
+        lengths[pool[idx].symbol]++;
+        return;
+    }
+    huff_pm_count(pool, pool[idx].left, lengths);
+    huff_pm_count(pool, pool[idx].right, lengths);
+}
+
+// Compara dos hojas por peso ascendente (y símbolo para desempatar).
+static int huff_pm_compare(const void* a, const void* b) {
+    const struct huff_pm_item* ia = (const struct huff_pm_item*)a;
+    const struct huff_pm_item* ib = (const struct huff_pm_item*)b;
+    if (ia->weight < ib->weight) return -1;
+    if (ia->weight > ib->weight) return 1;
+    return ia->symbol - ib->symbol;
+}
+
+// Función para calcular longitudes de código óptimas limitadas a max_len bits (package-merge).
+void huff_limited_code_lengths(const uint64_t* counts, size_t len, int max_len, unsigned char* lengths) {
+    memset(lengths, 0, len);
+    int n = 0;
+    struct huff_pm_item leaves[HUFF_MAX_SYMBOLS];
+    for (size_t i = 0; i < len; i++) {
+        if (counts[i] > 0) {
+            leaves[n].weight = counts[i];
+            leaves[n].symbol = (int)i;
+            leaves[n].left = leaves[n].right = -1;
+            n++;
+        }
+    }
+    if (n == 0) return;
+    if (n == 1) {
+        lengths[leaves[0].symbol] = 1;
+        return;
+    }
+    while ((1 << max_len) < n) max_len++; // Con max_len bits caben como mucho 2^max_len símbolos.
+    qsort(leaves, (size_t)n, sizeof(leaves[0]), huff_pm_compare);
+
+    // El nivel i se forma mezclando las hojas con los paquetes (pares consecutivos) del nivel i-1.
+    struct huff_pm_item* pool = (struct huff_pm_item*)malloc(sizeof(struct huff_pm_item) * (size_t)(n + max_len * n));
+    int* prev = (int*)malloc(sizeof(int) * (size_t)(2 * n));
+    int* curr = (int*)malloc(sizeof(int) * (size_t)(2 * n));
+    if (pool == NULL || prev == NULL || curr == NULL) {
+        free(pool);
+        free(prev);
+        free(curr);
+        return;
+    }
+    memcpy(pool, leaves, sizeof(leaves[0]) * (size_t)n);
+    int pool_len = n;
+    int prev_len = n;
+    for (int i = 0; i < n; i++) prev[i] = i;
+    for (int level = 1; level < max_len; level++) {
+        int li = 0, pi = 0, curr_len = 0;
+        int n_packages = prev_len / 2;
+        while (li < n || pi < n_packages) {
+            uint64_t package_weight = 0;
+            if (pi < n_packages) package_weight = pool[prev[2 * pi]].weight + pool[prev[2 * pi + 1]].weight;
+            if (pi >= n_packages || (li < n && pool[li].weight <= package_weight)) {
+                curr[curr_len++] = li++;
+            } else {
+                struct huff_pm_item* item = &pool[pool_len];
+                item->weight = package_weight;
+                item->symbol = -1;
+                item->left = prev[2 * pi];
+                item->right = prev[2 * pi + 1];
+                curr[curr_len++] = pool_len++;
+                pi++;
+            }
+        }
+        int* tmp = prev;
+        prev = curr;
+        curr = tmp;
+        prev_len = curr_len;
+    }
+    // Los 2n-2 elementos más livianos del último nivel determinan las longitudes.
+    for (int i = 0; i < 2 * n - 2 && i < prev_len; i++) {
+        huff_pm_count(pool, prev[i], lengths);
+    }
+    free(pool);
+    free(prev);
+    free(curr);
+}
+
+// Compara dos hojas del arena por frecuencia ascendente. A igual frecuencia va primero el
+// símbolo mayor, el mismo orden en que quedaban en la cola de prioridad enlazada.
+static int huff_arena_leaf_compare(const void* a, const void* b) {
+    const HEncodeNode* na = (const HEncodeNode*)a;
+    const HEncodeNode* nb = (const HEncodeNode*)b;
+    if (na->freq < nb->freq) return -1;
+    if (na->freq > nb->freq) return 1;
+    return (int)(unsigned char)nb->symbol - (int)(unsigned char)na->symbol;
+}
+
+// Función para construir el árbol de codificación Huffman dentro de un arena, sin reservar memoria.
+HEncodeNode* build_huff_encode_tree_arena(const uint64_t* counts, size_t len, HTreeArena* arena, FILE* trace) {
+    assert(len <= HUFF_MAX_SYMBOLS);
+    size_t n_leaves = 0;
+    arena->root = NULL;
+    for (size_t i = 0; i < len; i++) {
+        if (counts[i] > 0) {
+            HEncodeNode* leaf = &arena->nodes[n_leaves++];
+            memset(leaf, 0, sizeof(*leaf));
+            leaf->freq = counts[i];
+            leaf->is_leaf = 1;
+            leaf->symbol = (char)i;
+        }
+    }
+    arena->n_nodes = n_leaves;
+    if (n_leaves == 0) return NULL;
+    // Dos colas: las hojas ordenadas y los nodos internos, que se crean con frecuencia no decreciente.
+    // Se respeta el desempate de insert_huff_pqueue (el nodo más nuevo primero), así que el árbol
+    // y el codebook del formato anterior son idénticos a los de build_huff_encode_tree256.
+    HEncodeNode* inner[HUFF_MAX_SYMBOLS];
+    size_t inner_head = 0, inner_tail = 0;
+    size_t leaf_head = 0;
+    qsort(arena->nodes, n_leaves, sizeof(HEncodeNode), huff_arena_leaf_compare);
+    for (size_t i = 0; i + 1 < n_leaves; i++) {
+        HEncodeNode* pair[2];
+        for (int k = 0; k < 2; k++) {
+            if (leaf_head < n_leaves && (inner_head == inner_tail || arena->nodes[leaf_head].freq < inner[inner_head]->freq)) {
+                pair[k] = &arena->nodes[leaf_head++];
+            } else {
+                pair[k] = inner[inner_head++];
+            }
+        }
+        HEncodeNode* parent = &arena->nodes[arena->n_nodes++];
+        memset(parent, 0, sizeof(*parent));
+        parent->freq = pair[0]->freq + pair[1]->freq;
+        parent->left = pair[0];
+        parent->right = pair[1];
+        pair[0]->parent = parent;
+        pair[1]->parent = parent;
+        // Se ubica delante de los nodos internos pendientes con la misma frecuencia.
+        size_t pos = inner_tail++;
+        while (pos > inner_head && inner[pos - 1]->freq >= parent->freq) {
+            inner[pos] = inner[pos - 1];
+            pos--;
+        }
+        inner[pos] = parent;
+        if (trace != NULL) {
+            fprintf(trace, "merged: %llu + %llu -> %llu\n", (unsigned long long)pair[0]->freq,
+                    (unsigned long long)pair[1]->freq, (unsigned long long)parent->freq);
+        }
+    }
+    arena->root = &arena->nodes[arena->n_nodes - 1];
+    return arena->root;
+}
+
+// Función para obtener las longitudes de código, limitándolas a max_len bits.
+double huff_build_code_lengths(const uint64_t* counts, int max_len, HTreeArena* arena, unsigned char* lengths, FILE* trace) {
+    memset(lengths, 0, HUFF_MAX_SYMBOLS);
+    if (build_huff_encode_tree_arena(counts, HUFF_MAX_SYMBOLS, arena, trace) == NULL) return 0.0f;
+    huff_code_lengths(arena->root, 0, lengths);
+    int deepest = 0;
+    for (int i = 0; i < HUFF_MAX_SYMBOLS; i++) {
+        if (lengths[i] > deepest) deepest = lengths[i];
+    }
+    if (deepest <= max_len) return 0.0f; // El árbol de Huffman ya respeta el límite.
+
+    // Costo del límite: bits promedio por símbolo con y sin límite.
+    unsigned char limited[HUFF_MAX_SYMBOLS];
+    huff_limited_code_lengths(counts, HUFF_MAX_SYMBOLS, max_len, limited);
+    uint64_t bits_free = 0, bits_limited = 0;
+    for (int i = 0; i < HUFF_MAX_SYMBOLS; i++) {
+        bits_free += counts[i] * lengths[i];
+        bits_limited += counts[i] * limited[i];
+    }
+    memcpy(lengths, limited, HUFF_MAX_SYMBOLS);
+    arena->root = NULL; // Las longitudes ya no corresponden al árbol: se usan códigos canónicos.
+    if (trace != NULL) {
+        fprintf(trace, "capped code lengths: %d -> %d bits\n", deepest, max_len);
+    }
+    return bits_free > 0 ? (double)bits_limited / (double)bits_free - 1.0f : 0.0f;
+}
+
+// Función para empaquetar el codebook de texto en pares (código, longitud).
+int huff_pack_codebook(const char* codebook, HPackedCode* codes) {
+    int max_len = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        const char* code = codebook + (size_t)s * HUFF_MAX_LEN;
+        codes[s].bits = 0;
+        codes[s].len = 0;
+        while (*code) {
+            codes[s].bits = (codes[s].bits << 1) | (uint64_t)(*code - '0');
+            codes[s].len++;
+            code++;
+        }
+        if (codes[s].len > max_len) max_len = codes[s].len;
+    }
+    return max_len;
+}
+
+// Escribe los 8 bytes del acumulador en big-endian (el primer bit emitido queda primero).
+static inline void huff_store_be64(unsigned char* dst, uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+    memcpy(dst, &value, sizeof(value));
+#else
+    for (int i = 0; i < 8; i++) dst[i] = (unsigned char)(value >> (56 - 8 * i));
+#endif
+}
+
+// Agrega un código al acumulador (alineado a la izquierda).
+#define HUFF_PUT_CODE(w, c) \
+    do { (w)->acc |= (c).bits << (64 - (w)->bits - (c).len); (w)->bits += (c).len; } while (0)
+
+// Vacía los bytes completos del acumulador con una sola escritura de 8 bytes.
+static inline void huff_bit_writer_flush(HBitWriter* w) {
+    huff_store_be64(w->out + w->pos, w->acc);
+    int n_bytes = w->bits >> 3;
+    w->pos += (size_t)n_bytes;
+    w->acc = n_bytes == 8 ? 0 : w->acc << (n_bytes * 8);
+    w->bits &= 7;
+}
+
+// Función para codificar n símbolos con códigos empaquetados.
+void huff_encode_symbols(HBitWriter* w, const unsigned char* src, size_t n, const HPackedCode* codes, int max_len) {
+    size_t i = 0;
+    if (max_len <= 0) return; // Ningún símbolo tiene código.
+    if (max_len * 4 <= 57) {
+        // Camino desenrollado: tras vaciar quedan como mucho 7 bits, así que caben 4 códigos.
+        for (; i + 4 <= n; i += 4) {
+            HUFF_PUT_CODE(w, codes[src[i]]);
+            HUFF_PUT_CODE(w, codes[src[i + 1]]);
+            HUFF_PUT_CODE(w, codes[src[i + 2]]);
+            HUFF_PUT_CODE(w, codes[src[i + 3]]);
+            huff_bit_writer_flush(w);
+        }
+    } else if (max_len * 2 <= 57) {
+        for (; i + 2 <= n; i += 2) {
+            HUFF_PUT_CODE(w, codes[src[i]]);
+            HUFF_PUT_CODE(w, codes[src[i + 1]]);
+            huff_bit_writer_flush(w);
+        }
+    }
+    for (; i < n; i++) {
+        HUFF_PUT_CODE(w, codes[src[i]]);
+        huff_bit_writer_flush(w);
+    }
+}
+
+// Función para escribir el último byte parcial (rellenado con ceros).
+void huff_bit_writer_finish(HBitWriter* w) {
+    if (w->bits > 0) {
+        w->out[w->pos++] = (unsigned char)(w->acc >> 56);
+        w->acc = 0;
+        w->bits = 0;
+    }
+}
+
+// Codifica len bytes en dst, que tiene cap bytes, sin escribir fuera de dst. Mientras sobra lugar
+// se codifica directamente en dst, en trozos que caben con la holgura de HUFF_ENCODE_BOUND; los
+// últimos símbolos pasan por un buffer pequeño y se copian solo si caben. Los bits que no llegan a
+// completar un byte quedan en el acumulador de w. Devuelve los bytes escritos o (size_t)-1.
+static size_t huff_encode_bounded(HBitWriter* w, const unsigned char* data, size_t len, const HPackedCode* codes,
+                                  int max_len, unsigned char* dst, size_t cap) {
+    unsigned char tail[64];
+    size_t pos = 0, i = 0;
+    if (max_len <= 0) return 0; // Ningún símbolo tiene código.
+    while (i < len) {
+        size_t room = cap - pos;
+        size_t n = room > 16 ? (room - 16) * 8 / (size_t)max_len : 0;
+        if (n > 0) {
+            if (n > len - i) n = len - i;
+            w->out = dst + pos;
+            w->pos = 0;
+            huff_encode_symbols(w, data + i, n, codes, max_len);
+        } else {
+            n = (sizeof(tail) - 16) * 8 / (size_t)max_len;
+            if (n > len - i) n = len - i;
+            w->out = tail;
+            w->pos = 0;
+            huff_encode_symbols(w, data + i, n, codes, max_len);
+            if (w->pos > room) return (size_t)-1;
+            memcpy(dst + pos, tail, w->pos);
+        }
+        pos += w->pos; // Los bits pendientes siguen en el acumulador.
+        i += n;
+    }
+    return pos;
+}
+
+// Función para codificar en un buffer acotado y rellenar el último byte.
+size_t huff_encode_symbols_to(const unsigned char* data, size_t len, const HPackedCode* codes, int max_len,
+                              unsigned char* dst, size_t cap) {
+    HBitWriter w = {0, 0, dst, 0};
+    size_t pos = huff_encode_bounded(&w, data, len, codes, max_len, dst, cap);
+    if (pos == (size_t)-1) return pos;
+    if (w.bits > 0) {
+        if (pos == cap) return (size_t)-1;
+        w.out = dst + pos;
+        w.pos = 0;
+        huff_bit_writer_finish(&w);
+        pos += w.pos;
+    }
+    return pos;
+}
+
+// Función para escribir el archivo codificado leyendo del archivo original.
+// Lee la entrada en bloques grandes, codifica con los códigos empaquetados en un acumulador
+// de 64 bits y escribe la salida en bloques grandes.
+void write_huff_encode_stream_from_file(FILE* f_in, FILE* f_out, char* codebook) {
+    HPackedCode codes[HUFF_MAX_SYMBOLS];
+    int max_len = huff_pack_codebook(codebook, codes);
+    unsigned char* in = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    // Cada byte de entrada produce como máximo max_len bits; más 8 bytes de holgura para el vaciado.
+    size_t out_cap = HUFF_ENCODE_BOUND(HUFF_IO_BUFFER_SIZE, max_len);
+    unsigned char* out = (unsigned char*)malloc(out_cap);
+    if (in == NULL || out == NULL) {
+        free(in);
+        free(out);
+        return;
+    }
+    HBitWriter w = {0, 0, out, 0};
+    size_t n;
+    while ((n = fread(in, 1, HUFF_IO_BUFFER_SIZE, f_in)) > 0) {
+        huff_encode_symbols(&w, in, n, codes, max_len);
+        fwrite(out, 1, w.pos, f_out);
+        w.pos = 0; // Los bits pendientes siguen en el acumulador.
+    }
+    huff_bit_writer_finish(&w);
+    fwrite(out, 1, w.pos, f_out);
+    free(out);
+    free(in);
+}
+
+// Trozo de la entrada que codifica un hilo.
+struct huff_chunk {
+    const unsigned char* data;     // Inicio del trozo en la entrada.
+    size_t               len;      // Longitud del trozo en bytes.
+    const HPackedCode*   codes;    // Códigos empaquetados de los 256 símbolos.
+    int                  max_len;  // Longitud del código más largo.
+    unsigned char*       out;      // Buffer de salida compartido.
+    uint64_t             bit_len;  // Bits que produce el trozo (fase 1).
+    uint64_t             bit_off;  // Desplazamiento en bits dentro de la salida (fase 2).
+    unsigned char        tail;     // Último byte incompleto, compartido con el trozo siguiente.
+    int                  failed;   // 1 si los bits no cupieron en su lugar.
+};
+
+// Fase 1: calcula la longitud en bits del trozo.
+static void* huff_chunk_measure(void* arg) {
+    struct huff_chunk* chunk = (struct huff_chunk*)arg;
+    uint64_t bits = 0;
+    for (size_t i = 0; i < chunk->len; i++) {
+        bits += (uint64_t)chunk->codes[chunk->data[i]].len;
+    }
+    chunk->bit_len = bits;
+    return NULL;
+}
+
+// Fase 2: codifica el trozo directamente en su lugar de la salida, empezando con bit_off % 8 bits
+// en cero. El trozo escribe solo sus bytes completos [bit_off / 8, (bit_off + bit_len) / 8), que
+// no se pisan con los de los vecinos: su primer byte deja en cero los bits del trozo anterior y
+// el último byte incompleto queda en tail para unirlo con un OR después de los hilos.
+static void* huff_chunk_write(void* arg) {
+    struct huff_chunk* chunk = (struct huff_chunk*)arg;
+    chunk->tail = 0;
+    chunk->failed = 0;
+    if (chunk->bit_len == 0) return NULL;
+    int lead = (int)(chunk->bit_off & 7);
+    size_t n_bytes = (size_t)((lead + chunk->bit_len) >> 3);
+    unsigned char* dst = chunk->out + (chunk->bit_off >> 3);
+    HBitWriter w = {0, lead, dst, 0};
+    if (huff_encode_bounded(&w, chunk->data, chunk->len, chunk->codes, chunk->max_len, dst, n_bytes) != n_bytes) {
+        chunk->failed = 1;
+        return NULL;
+    }
+    chunk->tail = (unsigned char)(w.acc >> 56);
+    return NULL;
+}
+
+// Ejecuta fn sobre todos los trozos, un hilo por trozo (el primero en el hilo actual).
+// Devuelve 0, o -1 si no hay memoria para los hilos.
+static int huff_chunk_run(struct huff_chunk* chunks, int n_chunks, void* (*fn)(void*)) {
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)n_chunks);
+    int* started = (int*)calloc((size_t)n_chunks, sizeof(int));
+    if (threads == NULL || started == NULL) {
+        free(threads);
+        free(started);
+        return -1;
+    }
+    for (int t = 1; t < n_chunks; t++) {
+        started[t] = pthread_create(&threads[t], NULL, fn, &chunks[t]) == 0;
+        if (!started[t]) fn(&chunks[t]);
+    }
+    fn(&chunks[0]);
+    for (int t = 1; t < n_chunks; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    free(started);
+    return 0;
+}
+
+// Función para codificar en paralelo un buffer en memoria.
+long write_huff_encode_stream_parallel(const unsigned char* data, size_t len, FILE* f_out, char* codebook, int n_threads) {
+    HPackedCode codes[HUFF_MAX_SYMBOLS];
+    int max_len = huff_pack_codebook(codebook, codes);
+    size_t max_chunks = len / HUFF_PARALLEL_MIN_CHUNK;
+    int n_chunks = n_threads;
+    if ((size_t)n_chunks > max_chunks) n_chunks = (int)max_chunks;
+    if (n_chunks < 1) n_chunks = 1;
+
+    struct huff_chunk* chunks = (struct huff_chunk*)malloc(sizeof(struct huff_chunk) * (size_t)n_chunks);
+    if (chunks == NULL) return -1;
+    size_t per_chunk = len / (size_t)n_chunks;
+    for (int t = 0; t < n_chunks; t++) {
+        chunks[t].data = data + per_chunk * (size_t)t;
+        chunks[t].len = (t == n_chunks - 1) ? len - per_chunk * (size_t)t : per_chunk;
+        chunks[t].codes = codes;
+        chunks[t].max_len = max_len;
+    }
+    if (huff_chunk_run(chunks, n_chunks, huff_chunk_measure) < 0) {
+        free(chunks);
+        return -1;
+    }
+
+    // Suma de prefijos: desplazamiento en bits de cada trozo en la salida.
+    uint64_t total_bits = 0;
+    for (int t = 0; t < n_chunks; t++) {
+        chunks[t].bit_off = total_bits;
+        total_bits += chunks[t].bit_len;
+    }
+    // En cero: los bytes que solo tienen bits de tail no los escribe ningún hilo.
+    size_t out_len = (size_t)((total_bits + 7) >> 3);
+    unsigned char* out = (unsigned char*)calloc(out_len ? out_len : 1, 1);
+    if (out == NULL) {
+        free(chunks);
+        return -1;
+    }
+    for (int t = 0; t < n_chunks; t++) {
+        chunks[t].out = out;
+    }
+    int ret = huff_chunk_run(chunks, n_chunks, huff_chunk_write);
+
+    // Une los bytes compartidos entre trozos vecinos.
+    for (int t = 0; t < n_chunks && ret == 0; t++) {
+        uint64_t end = chunks[t].bit_off + chunks[t].bit_len;
+        if (chunks[t].failed) ret = -1;
+        else if (chunks[t].bit_len > 0 && (end & 7)) out[end >> 3] |= chunks[t].tail;
+    }
+    free(chunks);
+    size_t written = ret == 0 ? fwrite(out, 1, out_len, f_out) : 0;
+    free(out);
+    return ret == 0 && written == out_len ? (long)out_len : -1;
+}
+
+// Función para contar los bytes del archivo de entrada. Lee en bloques grandes y cuenta
+// con huff_histogram, con índices sin signo para los bytes >= 0x80.
+void huff_count_char(uint64_t* counts, FILE* f_in, size_t len) {
+    assert(len == 256 && len <= HUFF_MAX_SYMBOLS);
+    unsigned char buffer[64 * 1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f_in)) > 0) {
+        huff_histogram(buffer, n, counts);
+    }
+}
+
+// Función para obtener la longitud del código de cada símbolo a partir del árbol.
+void huff_code_lengths(HEncodeNode* root, int depth, unsigned char* lengths) {
+    if (root == NULL) return;
+    if (root->is_leaf) {
+        // Un archivo con un único símbolo distinto necesita igualmente un código de un bit.
+        lengths[(unsigned char)root->symbol] = (unsigned char)(depth > 0 ? depth : 1);
+        return;
+    }
+    huff_code_lengths(root->left, depth + 1, lengths);
+    huff_code_lengths(root->right, depth + 1, lengths);
+}
+
+// Función para generar el codebook de texto a partir de códigos canónicos.
+void huff_codebook_from_codes(const unsigned char* lengths, const uint64_t* codes, char* codebook) {
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        char* code = codebook + (size_t)s * HUFF_MAX_LEN;
+        int len = lengths[s];
+        for (int b = 0; b < len; b++) {
+            code[b] = ((codes[s] >> (len - 1 - b)) & 1) ? '1' : '0';
+        }
+        code[len] = 0;
+    }
+}
+
+// Función para escribir el flujo de bits de un buffer en memoria en f_out, secuencialmente
+// (en bloques de HUFF_IO_BUFFER_SIZE bytes de entrada) o en paralelo según las opciones.
+static int write_huff_payload(const unsigned char* data, size_t len, FILE* f_out, char* codebook, const HOptions* opts) {
+    int n_threads = opts ? opts->threads : 1;
+    if (n_threads > 1 && len >= 2 * (size_t)HUFF_PARALLEL_MIN_CHUNK) {
+        return write_huff_encode_stream_parallel(data, len, f_out, codebook, n_threads) < 0 ? -1 : 0;
+    }
+    HPackedCode codes[HUFF_MAX_SYMBOLS];
+    int max_len = huff_pack_codebook(codebook, codes);
+    unsigned char* out = (unsigned char*)malloc(HUFF_ENCODE_BOUND(HUFF_IO_BUFFER_SIZE, max_len));
+    if (out == NULL) return -1;
+    HBitWriter w = {0, 0, out, 0};
+    for (size_t off = 0; off < len; off += HUFF_IO_BUFFER_SIZE) {
+        size_t n = len - off < HUFF_IO_BUFFER_SIZE ? len - off : HUFF_IO_BUFFER_SIZE;
+        huff_encode_symbols(&w, data + off, n, codes, max_len);
+        if (fwrite(out, 1, w.pos, f_out) != w.pos) {
+            free(out);
+            return -1;
+        }
+        w.pos = 0; // Los bits pendientes siguen en el acumulador.
+    }
+    huff_bit_writer_finish(&w);
+    size_t written = fwrite(out, 1, w.pos, f_out);
+    free(out);
+    return written == w.pos ? 0 : -1;
+}
+
+// Decide si conviene codificar data con el diccionario. Compara, sobre los primeros
+// HUFF_DICT_PROBE bytes, los bits con los códigos del diccionario y con una tabla propia, y
+// extrapola a todo el archivo sumando lo que ocupa cada encabezado. El diccionario se rechaza si
+// la salida crecería más de threshold por ciento (0 = ante cualquier pérdida, < 0 = nunca se rechaza).
+static int huff_dict_accepts(const HDict* dict, const unsigned char* data, size_t len, int max_len, int threshold) {
+    if (threshold < 0 || len == 0) return 1;
+    size_t n = len < HUFF_DICT_PROBE ? len : HUFF_DICT_PROBE;
+    uint64_t counts[HUFF_MAX_SYMBOLS];
+    memset(counts, 0, sizeof(counts));
+    huff_histogram(data, n, counts);
+    HTreeArena arena;
+    unsigned char own[HUFF_MAX_SYMBOLS];
+    huff_build_code_lengths(counts, max_len, &arena, own, NULL);
+    double dict_bits = 0, own_bits = 0;
+    size_t n_symbols = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        dict_bits += (double)counts[s] * dict->lengths[s];
+        own_bits += (double)counts[s] * own[s];
+        if (own[s]) n_symbols++;
+    }
+    double scale = (double)len / (double)n;
+    double table_bits = 8.0 * (double)(2 + (2 * n_symbols < HUFF_MAX_SYMBOLS ? 2 * n_symbols : HUFF_MAX_SYMBOLS));
+    double with_dict = dict_bits * scale + 32.0;
+    double with_own = own_bits * scale + table_bits;
+    return with_dict * 100.0 <= with_own * (100.0 + threshold);
+}
+
+// Codifica un buffer en memoria con el formato por bloques (huff_stream.h).
+static int huff_encode_blocks(const unsigned char* data, size_t len, FILE* f_out, const HOptions* opts, HFileResult* res) {
+    HEncoder enc;
+    int ret = huff_encoder_init(&enc, f_out, opts);
+    if (ret == 0) ret = huff_encoder_push(&enc, data, len);
+    if (huff_encoder_finish(&enc) != 0) ret = -1;
+    *res = enc.result;
+    return ret;
+}
+
+// Codifica un archivo con rANS (huff_ans.h) a partir de su histograma y sus frecuencias normalizadas.
+static int huff_encode_ans(const unsigned char* data, size_t len, const uint64_t* counts, const uint32_t* freqs,
+                           FILE* f_out, const char* encoded_filename, int stats, HFileResult* res) {
+    HPhaseClock clock = {0, 0};
+    if (stats) {
+        res->entropy = huff_stats_entropy(counts);
+        res->code_bits = len > 0 ? huff_ans_cost(counts, freqs) / (double)len : 0.0;
+    }
+    huff_phase_start(&clock, stats);
+    int ret = huff_ans_encode_file(data, len, freqs, f_out);
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_ENCODE);
+    res->bytes_in = len;
+    res->bytes_out = (size_t)ftell(f_out);
+    if (ret != 0 || ferror(f_out)) {
+        snprintf(res->msg, sizeof(res->msg), "Cannot write %s", encoded_filename);
+        return -1;
+    }
+    res->status = 0;
+    return 0;
+}
+
+// Codifica un archivo con códigos de orden 1 (huff_order1.h) a partir del modelo del plan.
+static int huff_encode_o1(const unsigned char* data, size_t len, const HEncodePlan* plan,
+                          FILE* f_out, const char* encoded_filename, int stats, HFileResult* res) {
+    HPhaseClock clock = {0, 0};
+    if (stats) {
+        res->entropy = huff_stats_entropy(plan->counts);
+        res->code_bits = len > 0 ? plan->o1_bits / (double)len : 0.0;
+    }
+    for (int j = 0; j < plan->o1.n_clusters; j++) {
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+            if (plan->o1.lengths[j][s] > res->max_code_len) res->max_code_len = plan->o1.lengths[j][s];
+        }
+    }
+    huff_phase_start(&clock, stats);
+    int ret = huff_o1_encode_file(data, len, &plan->o1, f_out);
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_ENCODE);
+    res->bytes_in = len;
+    res->bytes_out = (size_t)ftell(f_out);
+    if (ret != 0 || ferror(f_out)) {
+        snprintf(res->msg, sizeof(res->msg), "Cannot write %s", encoded_filename);
+        return -1;
+    }
+    res->status = 0;
+    return 0;
+}
+
+// Arma el modelo de orden 1 del buffer y deja en plan->o1_bits los bits de su payload.
+// Devuelve 0, o -1 si no hay memoria para el histograma de pares.
+static int huff_plan_o1(const unsigned char* data, size_t len, HEncodePlan* plan, FILE* trace) {
+    uint64_t* pairs = (uint64_t*)calloc((size_t)HUFF_MAX_SYMBOLS * HUFF_MAX_SYMBOLS, sizeof(uint64_t));
+    if (pairs == NULL) return -1;
+    huff_o1_histogram(data, len, pairs);
+    huff_o1_build(pairs, HUFF_O1_CLUSTERS, &plan->o1);
+    plan->o1_bits = huff_o1_cost(pairs, &plan->o1);
+    free(pairs);
+    if (trace != NULL) fprintf(trace, "order1: %d clusters\n", plan->o1.n_clusters);
+    return 0;
+}
+
+// Devuelve el backend (HUFF_BACKEND_HUFFMAN, HUFF_BACKEND_ANS o HUFF_BACKEND_ORDER1) que produce el
+// archivo más pequeño según los tamaños estimados con el histograma. Sin have_o1 no se considera
+// el modelo de orden 1.
+static int huff_smallest_backend(const HEncodePlan* plan, HHeader* header, int have_o1, size_t len) {
+    unsigned char buf[HUFF_O1_HEADER_MAX_SIZE > HUFF_HEADER_MAX_SIZE ? HUFF_O1_HEADER_MAX_SIZE : HUFF_HEADER_MAX_SIZE];
+    header->orig_len = (uint64_t)len;
+    double huffman = 8.0 * (double)huff_write_header(header, buf) + huff_stats_code_bits(plan->counts, header->lengths) * (double)len;
+    double ans = 8.0 * (double)(huff_ans_write_header(plan->freqs, (uint64_t)len, buf) + 8) + huff_ans_cost(plan->counts, plan->freqs);
+    int best = ans < huffman ? HUFF_BACKEND_ANS : HUFF_BACKEND_HUFFMAN;
+    if (have_o1) {
+        double o1 = 8.0 * (double)huff_o1_write_header(&plan->o1, (uint64_t)len, buf) + plan->o1_bits;
+        if (o1 < (ans < huffman ? ans : huffman)) best = HUFF_BACKEND_ORDER1;
+    }
+    return best;
+}
+
+// Función para elegir los códigos de un buffer: los del diccionario (salvo que una tabla propia sea
+// claramente mejor, huff_dict_accepts), o los del histograma del buffer, y con opts->backend
+// HUFF_BACKEND_ANS las frecuencias de rANS, con HUFF_BACKEND_ORDER1 el modelo de orden 1, o con
+// HUFF_BACKEND_AUTO lo que resulte más pequeño.
+int huff_encode_plan_r(const unsigned char* data, size_t len, const HOptions* opts, HTreeArena* arena,
+                       HEncodePlan* plan, HFileResult* res) {
+    arena->root = NULL;
+    memset(&plan->header, 0, sizeof(plan->header));
+    memset(plan->counts, 0, sizeof(plan->counts));
+    plan->use_ans = 0;
+    plan->use_o1 = 0;
+    int legacy = opts ? opts->legacy : 0;
+    FILE* trace = opts && opts->verbose ? stderr : NULL;
+    // Los códigos nunca superan el tamaño del codebook de texto.
+    int max_len = opts && opts->max_code_len > 0 ? opts->max_code_len : HUFF_MAX_LEN - 1;
+    if (max_len > HUFF_MAX_LEN - 1) max_len = HUFF_MAX_LEN - 1;
+    int stats = opts ? opts->stats : 0;
+    HPhaseClock clock = {0, 0};
+    const HDict* dict = !legacy && opts ? opts->dict : NULL;
+    if (dict != NULL && huff_dict_accepts(dict, data, len, max_len, opts->dict_threshold)) {
+        // Sin histograma ni árbol: el diccionario tiene un código para cada byte.
+        huff_phase_start(&clock, stats);
+        memcpy(plan->header.lengths, dict->lengths, HUFF_MAX_SYMBOLS);
+        plan->header.flags = HUFF_FLAG_DICT;
+        plan->header.dict_id = dict->id;
+        if (trace != NULL) fprintf(trace, "dict: %08x\n", (unsigned)dict->id);
+        huff_phase_stop(&clock, stats, res, HUFF_PHASE_TREE);
+        if (stats) huff_histogram(data, len, plan->counts); // Solo para comparar con la entropía.
+        return 0;
+    }
+    if (dict != NULL && trace != NULL) fprintf(trace, "dict: %08x rejected, per-file table\n", (unsigned)dict->id);
+    huff_phase_start(&clock, stats);
+    huff_histogram(data, len, plan->counts); // Cuenta las apariciones exactas de cada byte.
+    int backend = !legacy && opts ? opts->backend : HUFF_BACKEND_HUFFMAN;
+    // El histograma de pares solo hace falta para el modelo de orden 1 (si no hay memoria, Huffman);
+    // se mide junto con el histograma, grupos incluidos. auto no lo prueba en archivos chicos.
+    int want_o1 = backend == HUFF_BACKEND_ORDER1 || (backend == HUFF_BACKEND_AUTO && len >= HUFF_O1_AUTO_MIN);
+    int have_o1 = want_o1 && huff_plan_o1(data, len, plan, trace) == 0;
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_HISTOGRAM);
+    huff_phase_start(&clock, stats);
+    if (backend == HUFF_BACKEND_ANS || backend == HUFF_BACKEND_AUTO) huff_ans_normalize(plan->counts, plan->freqs);
+    if (backend != HUFF_BACKEND_ANS && !(backend == HUFF_BACKEND_ORDER1 && have_o1)) {
+        res->cap_cost = huff_build_code_lengths(plan->counts, max_len, arena, plan->header.lengths, trace);
+        // Sin memoria para package-merge las longitudes quedan en cero.
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+            if (plan->counts[s] > 0 && plan->header.lengths[s] == 0) {
+                snprintf(res->msg, sizeof(res->msg), "out of memory");
+                return -1;
+            }
+        }
+    }
+    int chosen = backend == HUFF_BACKEND_AUTO ? huff_smallest_backend(plan, &plan->header, have_o1, len)
+                 : backend == HUFF_BACKEND_ORDER1 && !have_o1 ? HUFF_BACKEND_HUFFMAN : backend;
+    plan->use_ans = chosen == HUFF_BACKEND_ANS;
+    plan->use_o1 = chosen == HUFF_BACKEND_ORDER1;
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_TREE);
+    if (trace != NULL && backend != HUFF_BACKEND_HUFFMAN) {
+        fprintf(trace, "backend: %s\n", plan->use_ans ? "ans" : plan->use_o1 ? "order1" : "huffman");
+    }
+    return 0;
+}
+
+// Función interfaz para codificar un buffer en memoria.
+// Por defecto genera un único archivo con encabezado binario y códigos canónicos (huff_format.h),
+// con los códigos que elige huff_encode_plan_r (diccionario, tabla propia, rANS u orden 1);
+// con opts->block_size u opts->streams usa el formato por bloques, con códigos propios en cada bloque.
+// Con opts->legacy genera el formato anterior: el flujo de bits más un codebook de texto
+// en codebooks_dir. No escribe en stdout: el resultado queda en res, por lo que puede
+// llamarse desde varios hilos a la vez.
+int huff_encode_memory_r(const unsigned char* data, size_t len, const char* filename, FILE* f_out,
+                         const char* encoded_filename, const char* codebooks_dir, const HOptions* opts, HFileResult* res) {
+    memset(res, 0, sizeof(*res));
+    res->status = -1;
+    int legacy = opts ? opts->legacy : 0;
+    if (!legacy && opts && (opts->block_size > 0 || opts->streams > 1)) {
+        if (huff_encode_blocks(data, len, f_out, opts, res) != 0) {
+            snprintf(res->msg, sizeof(res->msg), "Cannot write %s", encoded_filename);
+            res->status = -1;
+            return -1;
+        }
+        res->status = 0;
+        return 0;
+    }
+    HTreeArena arena; // Todos los nodos del árbol, sin malloc por nodo.
+    FILE* trace = opts && opts->verbose ? stderr : NULL;
+    int stats = opts ? opts->stats : 0;
+    HPhaseClock clock = {0, 0};
+    HEncodePlan plan;
+    if (huff_encode_plan_r(data, len, opts, &arena, &plan, res) != 0) return -1;
+    if (plan.use_ans) return huff_encode_ans(data, len, plan.counts, plan.freqs, f_out, encoded_filename, stats, res);
+    if (plan.use_o1) return huff_encode_o1(data, len, &plan, f_out, encoded_filename, stats, res);
+    char codebook[HUFF_MAX_SYMBOLS][HUFF_MAX_LEN];
+    memset(codebook, 0, sizeof(codebook)); // Inicializa el codebook.
+    huff_phase_start(&clock, stats);
+    for (int i = 0; i < HUFF_MAX_SYMBOLS; i++) {
+        if (plan.header.lengths[i] > res->max_code_len) res->max_code_len = plan.header.lengths[i];
+    }
+    if (legacy && arena.root != NULL && !arena.root->is_leaf) {
+        generate_huff_codebook(arena.root, 0, &codebook[0][0]); // Genera el codebook con los códigos del árbol.
+    } else {
+        // Códigos canónicos: el decodificador los reconstruye solo con las longitudes.
+        uint64_t codes[HUFF_MAX_SYMBOLS];
+        huff_canonical_codes(plan.header.lengths, codes);
+        huff_codebook_from_codes(plan.header.lengths, codes, &codebook[0][0]);
+    }
+    if (trace != NULL) {
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+            if (plan.header.lengths[s]) fprintf(trace, "code: 0x%02x %s\n", s, codebook[s]);
+        }
+    }
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_TREE);
+    if (stats) {
+        res->entropy = huff_stats_entropy(plan.counts);
+        res->code_bits = huff_stats_code_bits(plan.counts, plan.header.lengths);
+    }
+    huff_phase_start(&clock, stats);
+    if (legacy) {
+        // Genera el nombre del archivo del codebook y lo escribe.
+        char* baseName = strrchr(filename, '/');
+        baseName = baseName ? baseName + 1 : (char*)filename;
+        char codebookFilename[1024];
+        if (snprintf(codebookFilename, sizeof(codebookFilename), "%s/%s_codebook.txt", codebooks_dir, baseName) >=
+            (int)sizeof(codebookFilename)) {
+            snprintf(res->msg, sizeof(res->msg), "path too long");
+            return -1;
+        }
+        FILE* f_cb = fopen(codebookFilename, "w");
+        if (f_cb == NULL) {
+            if (snprintf(res->msg, sizeof(res->msg), "Cannot open %s", codebookFilename) >= (int)sizeof(res->msg)) {
+                snprintf(res->msg, sizeof(res->msg), "Cannot open codebook");
+            }
+            return -1;
+        }
+        write_huff_codebook(f_cb, &codebook[0][0]);
+        fclose(f_cb);
+    } else {
+        plan.header.orig_len = (uint64_t)len;
+        unsigned char header_buf[HUFF_HEADER_MAX_SIZE];
+        size_t header_len = huff_write_header(&plan.header, header_buf);
+        fwrite(header_buf, 1, header_len, f_out);
+    }
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_CODEBOOK);
+    huff_phase_start(&clock, stats);
+    int ret = write_huff_payload(data, len, f_out, &codebook[0][0], opts);
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_ENCODE);
+    res->bytes_in = len;
+    res->bytes_out = (size_t)ftell(f_out);
+    if (ret != 0 || ferror(f_out)) {
+        snprintf(res->msg, sizeof(res->msg), "Cannot write %s", encoded_filename);
+        return -1;
+    }
+    res->status = 0;
+    return 0;
+}
+
+// Función interfaz para codificar un archivo: lo carga en memoria (mmap o un read grande), así el
+// histograma y la codificación recorren los mismos bytes, y lo codifica con huff_encode_memory_r.
+int huff_encode_file_r(const char* filename, const char* encoded_filename, const char* codebooks_dir, const HOptions* opts, HFileResult* res) {
+    memset(res, 0, sizeof(*res));
+    res->status = -1;
+    HInput input;
+    if (huff_input_open(filename, &input) != 0) {
+        snprintf(res->msg, sizeof(res->msg), "Cannot open %s", filename);
+        return -1;
+    }
+    FILE* f_out = fopen(encoded_filename, "wb");
+    if (f_out == NULL) {
+        snprintf(res->msg, sizeof(res->msg), "Cannot open %s", encoded_filename);
+        huff_input_close(&input);
+        return -1;
+    }
+    int ret = huff_encode_memory_r(input.data, input.len, filename, f_out, encoded_filename, codebooks_dir, opts, res);
+    huff_input_close(&input);
+    if (fclose(f_out) != 0 && ret == 0) {
+        snprintf(res->msg, sizeof(res->msg), "Cannot write %s", encoded_filename);
+        res->status = -1;
+        ret = -1;
+    }
+    return ret;
+}
+
+// Función interfaz para codificar un archivo en el formato anterior (flujo de bits y codebook).
+int huff_encode_file(const char* filename, const char* encoded_filename, const char* codebooks_dir) {
+    HFileResult res;
+    HOptions opts;
+    huff_options_default(&opts);
+    opts.legacy = 1;
+    int ret = huff_encode_file_r(filename, encoded_filename, codebooks_dir, &opts, &res);
+    if (ret != 0) {
+        printf("%s\n.exit.\n", res.msg);
+    }
+    return ret;
+}
@@ -1,60 +1,179 @@
-#ifndef HUFF_ENCODE_H
-#define HUFF_ENCODE_H
-
-#include "huff_const.h"
-#include <stdio.h>
-
-// Estructura para los nodos del árbol de Huffman usados en la codificación.
-struct huff_encode_node {
-	struct huff_encode_node* left;   // Apunta al hijo izquierdo en el árbol; representa un '0'.
-	struct huff_encode_node* right;  // Apunta al hijo derecho en el árbol; representa un '1'.
-	struct huff_encode_node* parent; // Apunta al nodo padre en el árbol.
-	struct huff_encode_node* next;   // Usado en la cola de prioridad.
-	double freq;                     // Frecuencia del símbolo en el archivo.
-	int    is_leaf;                  // Indica si el nodo es una hoja en el árbol.
-	char   symbol;                   // El símbolo asignado a este nodo.
-};
-
-// Tipo definido para el nodo de codificación de Huffman.
-typedef struct huff_encode_node HEncodeNode;
-
-// Función para asignar memoria para un nodo de codificación de Huffman.
-HEncodeNode* create_huff_encode_node(char symbol, double freq, int is_leaf);
-
-// Función utilizada para insertar un nodo en la cola de prioridad.
-void insert_huff_pqueue(HEncodeNode* node, HEncodeNode** q_head);
-
-// Función utilizada para mostrar la cola de prioridad.
-void disp_huff_pqueue(HEncodeNode* q_head);
-
-// Función para extraer un elemento de la cola de prioridad.
-HEncodeNode* pop_huff_pqueue(HEncodeNode** q_head);
-
-// Función para generar el codebook de manera recursiva.
-void generate_huff_codebook(HEncodeNode* root, int depth, char* codebook);
-
-// Función para escribir el codebook en un archivo.
-void write_huff_codebook(FILE* f_out, char* codebook);
-
-// Función para escribir el flujo de bits codificados en un archivo.
-void write_huff_encode_stream(FILE* f_out, char* str, char* codebook);
-
-// Función para liberar la memoria del árbol de codificación Huffman.
-void free_huff_encode_tree(HEncodeNode* root);
-
-// Función para construir el árbol de codificación Huffman.
-void build_huff_encode_tree(const char* str_arr, const double* freq_arr, size_t len, HEncodeNode** q_head);
-
-// Función para construir el árbol de codificación Huffman solo con un arreglo de frecuencias.
-void build_huff_encode_tree256(double* freq_arr, size_t len, HEncodeNode** q_head);
-
-// Función para escribir el archivo codificado leyendo del archivo original.
-void write_huff_encode_stream_from_file(FILE* f_in, FILE* f_out, char* codebook);
-
-// Interfaz para codificar un archivo.
-int huff_encode_file(const char* filename, const char* encoded_filename, const char* codebooks_dir);
-
-// Función para contar caracteres ASCII.
-void huff_count_char(double* freq_arr, FILE* f_in, size_t len);
-
-#endif // !HUFF_ENCODE_H
+#ifndef HUFF_ENCODE_H
+#define HUFF_ENCODE_H
+
+#include "huff_const.h"
+#include "huff_result.h"
+#include "huff_options.h"
+#include "huff_histogram.h"
+#include "huff_format.h"
+#include "huff_order1.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// Estructura para los nodos del árbol de Huffman usados en la codificación.
+struct huff_encode_node {
+	struct huff_encode_node* left;   // Apunta al hijo izquierdo en el árbol; representa un '0'.
+	struct huff_encode_node* right;  // Apunta al hijo derecho en el árbol; representa un '1'.
+	struct huff_encode_node* parent; // Apunta al nodo padre en el árbol.
+	struct huff_encode_node* next;   // Usado en la cola de prioridad.
+	uint64_t freq;                   // Apariciones del símbolo en el archivo (o suma de las hojas).
+	int    is_leaf;                  // Indica si el nodo es una hoja en el árbol.
+	char   symbol;                   // El símbolo asignado a este nodo.
+};
+
+// Tipo definido para el nodo de codificación de Huffman.
+typedef struct huff_encode_node HEncodeNode;
+
+// Función para asignar memoria para un nodo de codificación de Huffman.
+HEncodeNode* create_huff_encode_node(char symbol, uint64_t freq, int is_leaf);
+
+// Función utilizada para insertar un nodo en la cola de prioridad.
+void insert_huff_pqueue(HEncodeNode* node, HEncodeNode** q_head);
+
+// Función utilizada para mostrar la cola de prioridad.
+void disp_huff_pqueue(HEncodeNode* q_head);
+
+// Función para extraer un elemento de la cola de prioridad.
+HEncodeNode* pop_huff_pqueue(HEncodeNode** q_head);
+
+// Función para generar el codebook de manera recursiva.
+void generate_huff_codebook(HEncodeNode* root, int depth, char* codebook);
+
+// Función para obtener la longitud del código de cada símbolo a partir del árbol.
+void huff_code_lengths(HEncodeNode* root, int depth, unsigned char* lengths);
+
+// Función para generar el codebook de texto a partir de longitudes y códigos canónicos.
+void huff_codebook_from_codes(const unsigned char* lengths, const uint64_t* codes, char* codebook);
+
+// Función para escribir el codebook en un archivo.
+void write_huff_codebook(FILE* f_out, char* codebook);
+
+// Función para escribir el flujo de bits codificados en un archivo.
+void write_huff_encode_stream(FILE* f_out, char* str, char* codebook);
+
+// Función para liberar la memoria del árbol de codificación Huffman.
+void free_huff_encode_tree(HEncodeNode* root);
+
+// Función para construir el árbol de codificación Huffman.
+void build_huff_encode_tree(const char* str_arr, const uint64_t* freq_arr, size_t len, HEncodeNode** q_head);
+
+// Función para construir el árbol de codificación Huffman solo con los contadores exactos de cada byte.
+void build_huff_encode_tree256(const uint64_t* counts, size_t len, HEncodeNode** q_head);
+
+// Función para calcular longitudes de código óptimas de como máximo max_len bits (package-merge).
+// Si max_len no alcanza para todos los símbolos se usa el mínimo posible.
+void huff_limited_code_lengths(const uint64_t* counts, size_t len, int max_len, unsigned char* lengths);
+
+// Arena con todos los nodos de un árbol de Huffman de bytes (n hojas y n - 1 nodos internos).
+// Permite construir el árbol sin reservar memoria por nodo; se libera junto con el arena.
+struct huff_tree_arena {
+	HEncodeNode  nodes[2 * HUFF_MAX_SYMBOLS - 1]; // Hojas ordenadas y luego los nodos internos en orden de creación.
+	size_t       n_nodes;                         // Nodos usados.
+	HEncodeNode* root;                            // Raíz del árbol (NULL si no hay símbolos).
+};
+
+// Nombre corto para el arena de nodos.
+typedef struct huff_tree_arena HTreeArena;
+
+// Función para construir el árbol de codificación Huffman en el arena con el método de dos colas
+// (hojas ordenadas y nodos internos en orden de creación). Si trace no es NULL escribe cada mezcla.
+// Devuelve la raíz o NULL si ningún contador es positivo.
+HEncodeNode* build_huff_encode_tree_arena(const uint64_t* counts, size_t len, HTreeArena* arena, FILE* trace);
+
+// Función para obtener las longitudes de código de los 256 bytes con como máximo max_len bits.
+// Si el árbol de Huffman excede el límite se usan longitudes de package-merge y arena->root
+// queda en NULL. Devuelve el costo relativo del límite en bits promedio por símbolo (0 si no fue necesario).
+double huff_build_code_lengths(const uint64_t* counts, int max_len, HTreeArena* arena, unsigned char* lengths, FILE* trace);
+
+// Código de un símbolo empaquetado en bits (el bit más significativo se emite primero).
+struct huff_packed_code {
+	uint64_t bits; // Bits del código alineados a la derecha.
+	int      len;  // Longitud del código (0 = el símbolo no aparece).
+};
+
+// Nombre corto para el código empaquetado.
+typedef struct huff_packed_code HPackedCode;
+
+// Escritor de bits con un acumulador de 64 bits alineado a la izquierda.
+struct huff_bit_writer {
+	uint64_t       acc;  // Bits pendientes (los más significativos se escriben primero).
+	int            bits; // Cantidad de bits pendientes en acc.
+	unsigned char* out;  // Buffer de salida.
+	size_t         pos;  // Bytes completos escritos en out.
+};
+
+// Nombre corto para el escritor de bits.
+typedef struct huff_bit_writer HBitWriter;
+
+// Tamaño de buffer suficiente para codificar n bytes con códigos de hasta max_len bits
+// (incluye la holgura de 8 bytes que usa el vaciado del acumulador).
+#define HUFF_ENCODE_BOUND(n, max_len) ((((size_t)(n) * (size_t)(max_len)) >> 3) + 16)
+
+// Función para empaquetar el codebook de texto. Devuelve la longitud del código más largo.
+int huff_pack_codebook(const char* codebook, HPackedCode* codes);
+
+// Función para codificar n símbolos agregando sus códigos al escritor. El buffer del escritor
+// debe tener al menos HUFF_ENCODE_BOUND(n, max_len) bytes libres. Con códigos cortos se
+// agregan cuatro símbolos por iteración antes de vaciar el acumulador.
+void huff_encode_symbols(HBitWriter* w, const unsigned char* src, size_t n, const HPackedCode* codes, int max_len);
+
+// Función para escribir el último byte parcial del escritor (rellenado con ceros).
+void huff_bit_writer_finish(HBitWriter* w);
+
+// Función para codificar len bytes en dst, que tiene cap bytes, sin escribir fuera de dst (con un
+// buffer de HUFF_ENCODE_BOUND(len, max_len) bytes no hace falta ninguna copia). El último byte
+// se rellena con ceros. Devuelve los bytes escritos o (size_t)-1 si el flujo de bits no cabe.
+size_t huff_encode_symbols_to(const unsigned char* data, size_t len, const HPackedCode* codes, int max_len,
+                              unsigned char* dst, size_t cap);
+
+// Función para escribir el archivo codificado leyendo del archivo original.
+void write_huff_encode_stream_from_file(FILE* f_in, FILE* f_out, char* codebook);
+
+// Función para codificar en paralelo un buffer en memoria y escribir el flujo de bits en f_out.
+// Cada hilo calcula la longitud en bits de su trozo, una suma de prefijos da el desplazamiento
+// de cada trozo en la salida y luego cada hilo escribe sus bits directamente en su posición.
+// La salida es idéntica byte a byte a la de write_huff_encode_stream_from_file.
+// Devuelve el número de bytes escritos o -1 en caso de error.
+long write_huff_encode_stream_parallel(const unsigned char* data, size_t len, FILE* f_out, char* codebook, int n_threads);
+
+// Interfaz para codificar un archivo en el formato anterior (flujo de bits y codebook de texto).
+int huff_encode_file(const char* filename, const char* encoded_filename, const char* codebooks_dir);
+
+// Interfaz reentrante para codificar un archivo: no escribe en stdout y deja el resultado en res.
+// Genera el formato binario de huff_format.h, o el formato anterior si opts->legacy.
+// opts puede ser NULL para usar las opciones por defecto.
+int huff_encode_file_r(const char* filename, const char* encoded_filename, const char* codebooks_dir, const HOptions* opts, HFileResult* res);
+
+// Plan de codificación del formato de un solo bloque: los códigos (o las frecuencias de rANS, o el
+// modelo de orden 1) elegidos a partir del histograma, del diccionario y de opts->backend.
+struct huff_encode_plan {
+	HHeader  header;                   // Encabezado con las longitudes de los códigos y, con diccionario, su id.
+	uint64_t counts[HUFF_MAX_SYMBOLS]; // Histograma (con diccionario solo se cuenta con opts->stats).
+	uint32_t freqs[HUFF_MAX_SYMBOLS];  // Frecuencias normalizadas de rANS (solo con use_ans).
+	int      use_ans;                  // 1 si el buffer se codifica con rANS (huff_ans.h).
+	HO1Model o1;                       // Grupos y códigos de orden 1 (solo con use_o1).
+	double   o1_bits;                  // Bits del payload de orden 1.
+	int      use_o1;                   // 1 si el buffer se codifica con códigos de orden 1 (huff_order1.h).
+};
+
+// Nombre corto para el plan de codificación.
+typedef struct huff_encode_plan HEncodePlan;
+
+// Función para elegir los códigos de len bytes según opts (diccionario, backend y longitud máxima).
+// El árbol queda en arena (para el codebook del formato anterior); deja en res cap_cost y, con
+// opts->stats, el tiempo del histograma y del árbol. Con opts->verbose escribe las trazas en stderr.
+// Devuelve 0, o -1 con res->msg si no se pudieron calcular los códigos.
+int huff_encode_plan_r(const unsigned char* data, size_t len, const HOptions* opts, HTreeArena* arena,
+                       HEncodePlan* plan, HFileResult* res);
+
+// Interfaz reentrante para codificar len bytes en memoria y escribir el resultado en f_out (que no
+// se cierra). filename es el nombre del original (para el codebook del formato anterior) y
+// encoded_filename el de la salida, solo para los mensajes de error.
+int huff_encode_memory_r(const unsigned char* data, size_t len, const char* filename, FILE* f_out,
+                         const char* encoded_filename, const char* codebooks_dir, const HOptions* opts, HFileResult* res);
+
+// Función para contar los bytes (0-255) de un archivo. Suma a counts las apariciones exactas;
+// para buffers en memoria se usa directamente huff_histogram (huff_histogram.h).
+void huff_count_char(uint64_t* counts, FILE* f_in, size_t len);
+
+#endif // !HUFF_ENCODE_H
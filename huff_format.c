@@ -0,0 +1,229 @@
+#include <string.h>
+#include "huff_format.h"
+
+// Escribe un entero de n bytes en little-endian.
+void huff_put_le(unsigned char* dst, uint64_t value, int n) {
+    for (int i = 0; i < n; i++) {
+        dst[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+// Lee un entero de n bytes en little-endian.
+uint64_t huff_get_le(const unsigned char* src, int n) {
+    uint64_t value = 0;
+    for (int i = 0; i < n; i++) {
+        value |= (uint64_t)src[i] << (8 * i);
+    }
+    return value;
+}
+
+// Escribe las longitudes como pares (símbolo, longitud) o como la tabla completa.
+static size_t put_lengths(unsigned char* dst, const unsigned char* lengths, size_t n_symbols, int sparse) {
+    size_t pos = 0;
+    huff_put_le(dst, n_symbols, 2);
+    pos += 2;
+    if (sparse) {
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+            if (lengths[s]) {
+                dst[pos++] = (unsigned char)s;
+                dst[pos++] = lengths[s];
+            }
+        }
+    } else {
+        memcpy(dst + pos, lengths, HUFF_MAX_SYMBOLS);
+        pos += HUFF_MAX_SYMBOLS;
+    }
+    return pos;
+}
+
+// Cuenta los símbolos con longitud distinta de cero.
+static size_t count_symbols(const unsigned char* lengths) {
+    size_t n_symbols = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (lengths[s]) n_symbols++;
+    }
+    return n_symbols;
+}
+
+// Verifica si el buffer empieza con el magic del formato.
+int huff_is_container(const unsigned char* src, size_t len) {
+    return len >= HUFF_MAGIC_LEN && memcmp(src, HUFF_MAGIC, HUFF_MAGIC_LEN) == 0;
+}
+
+// Escribe el encabezado en dst y devuelve los bytes escritos.
+size_t huff_write_header(HHeader* header, unsigned char* dst) {
+    size_t n_symbols = count_symbols(header->lengths);
+    // Los pares (símbolo, longitud) ocupan menos que la tabla completa si hay pocos símbolos.
+    if (2 * n_symbols < HUFF_MAX_SYMBOLS && !(header->flags & HUFF_FLAG_DICT)) header->flags |= HUFF_FLAG_SPARSE_LENGTHS;
+    else header->flags &= ~(unsigned int)HUFF_FLAG_SPARSE_LENGTHS;
+    header->version = HUFF_FORMAT_VERSION;
+
+    size_t pos = 0;
+    memcpy(dst, HUFF_MAGIC, HUFF_MAGIC_LEN);
+    pos += HUFF_MAGIC_LEN;
+    dst[pos++] = (unsigned char)header->version;
+    dst[pos++] = (unsigned char)header->flags;
+    huff_put_le(dst + pos, header->orig_len, 8);
+    pos += 8;
+    if (header->flags & HUFF_FLAG_DICT) {
+        huff_put_le(dst + pos, header->dict_id, 4);
+        return pos + 4;
+    }
+    pos += put_lengths(dst + pos, header->lengths, n_symbols, header->flags & HUFF_FLAG_SPARSE_LENGTHS);
+    return pos;
+}
+
+// Lee el encabezado y devuelve los bytes consumidos o -1 si no es válido.
+long huff_read_header(const unsigned char* src, size_t len, HHeader* header) {
+    memset(header, 0, sizeof(*header));
+    if (!huff_is_container(src, len) || len < HUFF_MAGIC_LEN + 1 + 1 + 8 + 2) return -1;
+    size_t pos = HUFF_MAGIC_LEN;
+    header->version = src[pos++];
+    header->flags = src[pos++];
+    if (header->version != HUFF_FORMAT_VERSION) return -1;
+    header->orig_len = huff_get_le(src + pos, 8);
+    pos += 8;
+    if (header->flags & HUFF_FLAG_DICT) {
+        if (len - pos < 4) return -1;
+        header->dict_id = (uint32_t)huff_get_le(src + pos, 4);
+        return (long)(pos + 4);
+    }
+    size_t n_symbols = (size_t)huff_get_le(src + pos, 2);
+    pos += 2;
+    if (n_symbols > HUFF_MAX_SYMBOLS) return -1;
+    if (header->flags & HUFF_FLAG_SPARSE_LENGTHS) {
+        if (len - pos < 2 * n_symbols) return -1;
+        for (size_t i = 0; i < n_symbols; i++) {
+            header->lengths[src[pos]] = src[pos + 1];
+            pos += 2;
+        }
+    } else {
+        if (len - pos < HUFF_MAX_SYMBOLS) return -1;
+        memcpy(header->lengths, src + pos, HUFF_MAX_SYMBOLS);
+        pos += HUFF_MAX_SYMBOLS;
+    }
+    return (long)pos;
+}
+
+// Lee la versión de un archivo comprimido.
+unsigned int huff_container_version(const unsigned char* src, size_t len) {
+    if (!huff_is_container(src, len) || len < HUFF_MAGIC_LEN + 1) return 0;
+    return src[HUFF_MAGIC_LEN];
+}
+
+// Escribe el encabezado del formato por bloques.
+size_t huff_write_stream_header(HStreamHeader* header, unsigned char* dst) {
+    if (header->n_streams > 1) header->flags |= HUFF_STREAM_FLAG_INTERLEAVED;
+    else header->flags &= ~(unsigned int)HUFF_STREAM_FLAG_INTERLEAVED;
+    size_t pos = 0;
+    memcpy(dst, HUFF_MAGIC, HUFF_MAGIC_LEN);
+    pos += HUFF_MAGIC_LEN;
+    dst[pos++] = HUFF_STREAM_VERSION;
+    dst[pos++] = (unsigned char)header->flags;
+    huff_put_le(dst + pos, header->block_size, 4);
+    pos += 4;
+    if (header->flags & HUFF_STREAM_FLAG_INTERLEAVED) dst[pos++] = (unsigned char)header->n_streams;
+    return pos;
+}
+
+// Lee el encabezado del formato por bloques.
+long huff_read_stream_header(const unsigned char* src, size_t len, HStreamHeader* header, size_t* need) {
+    // Con los bytes que hay ya se puede descartar algo que no es un flujo por bloques.
+    size_t n = len < HUFF_MAGIC_LEN ? len : HUFF_MAGIC_LEN;
+    if (memcmp(src, HUFF_MAGIC, n) != 0) return -1;
+    if (len > HUFF_MAGIC_LEN && src[HUFF_MAGIC_LEN] != HUFF_STREAM_VERSION) return -1;
+    *need = HUFF_MAGIC_LEN + 1 + 1 + 4;
+    if (len < *need) return 0;
+    header->flags = src[HUFF_MAGIC_LEN + 1];
+    header->block_size = (uint32_t)huff_get_le(src + HUFF_MAGIC_LEN + 2, 4);
+    header->n_streams = 1;
+    if (header->block_size == 0 || header->block_size > HUFF_STREAM_MAX_BLOCK) return -1;
+    if (header->flags & HUFF_STREAM_FLAG_INTERLEAVED) {
+        *need += 1;
+        if (len < *need) return 0;
+        header->n_streams = src[*need - 1];
+        if (header->n_streams < 2 || header->n_streams > HUFF_MAX_STREAMS) return -1;
+    }
+    return (long)*need;
+}
+
+// Escribe el encabezado de un bloque.
+size_t huff_write_block_header(const HBlockHeader* block, int n_streams, unsigned char* dst) {
+    huff_put_le(dst, block->raw_len, 4);
+    if (block->raw_len == 0) return 4;
+    huff_put_le(dst + 4, block->payload_len, 4);
+    size_t n_symbols = count_symbols(block->lengths);
+    size_t pos = 8 + put_lengths(dst + 8, block->lengths, n_symbols, 2 * n_symbols < HUFF_MAX_SYMBOLS);
+    for (int k = 0; k + 1 < n_streams; k++) {
+        huff_put_le(dst + pos, block->stream_len[k], 4);
+        pos += 4;
+    }
+    return pos;
+}
+
+// Lee el encabezado de un bloque.
+long huff_read_block_header(const unsigned char* src, size_t len, int n_streams, HBlockHeader* block, size_t* need) {
+    *need = 4;
+    if (len < *need) return 0;
+    block->raw_len = (uint32_t)huff_get_le(src, 4);
+    if (block->raw_len == 0) {
+        block->payload_len = 0;
+        return 4;
+    }
+    *need = 10;
+    if (len < *need) return 0;
+    block->payload_len = (uint32_t)huff_get_le(src + 4, 4);
+    size_t n_symbols = (size_t)huff_get_le(src + 8, 2);
+    if (n_symbols == 0 || n_symbols > HUFF_MAX_SYMBOLS) return -1;
+    int sparse = 2 * n_symbols < HUFF_MAX_SYMBOLS;
+    size_t lengths_end = 10 + (sparse ? 2 * n_symbols : HUFF_MAX_SYMBOLS);
+    *need = lengths_end + 4 * (size_t)(n_streams - 1);
+    if (len < *need) return 0;
+    memset(block->lengths, 0, sizeof(block->lengths));
+    if (sparse) {
+        for (size_t i = 0; i < n_symbols; i++) {
+            block->lengths[src[10 + 2 * i]] = src[10 + 2 * i + 1];
+        }
+    } else {
+        memcpy(block->lengths, src + 10, HUFF_MAX_SYMBOLS);
+    }
+    // El último flujo ocupa lo que queda del payload.
+    uint64_t used = 0;
+    for (int k = 0; k + 1 < n_streams; k++) {
+        block->stream_len[k] = (uint32_t)huff_get_le(src + lengths_end + 4 * (size_t)k, 4);
+        used += block->stream_len[k];
+    }
+    if (used > block->payload_len) return -1;
+    block->stream_len[n_streams - 1] = block->payload_len - (uint32_t)used;
+    return (long)*need;
+}
+
+// Reparte raw_len bytes en n_streams trozos consecutivos.
+void huff_split_streams(uint32_t raw_len, int n_streams, uint32_t* seg_len) {
+    for (int k = 0; k < n_streams; k++) {
+        seg_len[k] = raw_len / (uint32_t)n_streams + ((uint32_t)k < raw_len % (uint32_t)n_streams ? 1 : 0);
+    }
+}
+
+// Asigna códigos canónicos a partir de las longitudes.
+int huff_canonical_codes(const unsigned char* lengths, uint64_t* codes) {
+    int count[HUFF_MAX_SYMBOLS + 1];
+    uint64_t next_code[HUFF_MAX_SYMBOLS + 1];
+    memset(count, 0, sizeof(count));
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        count[lengths[s]]++;
+    }
+    count[0] = 0;
+    // Primer código de cada longitud; comprueba que no se excede el espacio de códigos.
+    uint64_t code = 0;
+    for (int len = 1; len <= HUFF_MAX_SYMBOLS; len++) {
+        code = (code + (uint64_t)count[len - 1]) << 1;
+        next_code[len] = code;
+        if (count[len] && len < 64 && code + (uint64_t)count[len] > ((uint64_t)1 << len)) return -1;
+        if (count[len] && len >= 64) return -1;
+    }
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        codes[s] = lengths[s] ? next_code[lengths[s]]++ : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+#ifndef HUFF_FORMAT_H
+#define HUFF_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "huff_const.h"
+
+// Formato binario autocontenido de un archivo comprimido (todos los enteros en little-endian):
+//
+//   magic       4 bytes  "HUFZ"
+//   version     1 byte   HUFF_FORMAT_VERSION
+//   flags       1 byte   HUFF_FLAG_*
+//   orig_len    8 bytes  longitud del archivo original en bytes
+//   n_symbols   2 bytes  símbolos con longitud de código distinta de cero
+//   longitudes  si HUFF_FLAG_SPARSE_LENGTHS: n_symbols pares (símbolo, longitud)
+//               si no: 256 bytes, la longitud de cada símbolo
+//               (con HUFF_FLAG_DICT, en lugar de n_symbols y longitudes: dict_id, 4 bytes)
+//   payload     flujo de bits con los códigos canónicos (el bit más significativo primero)
+//
+// Los códigos se reconstruyen solo a partir de las longitudes (códigos canónicos), así que
+// no hace falta un codebook aparte. orig_len indica cuántos símbolos decodificar, de modo
+// que los bits de relleno del último byte nunca se interpretan como símbolos.
+#define HUFF_MAGIC "HUFZ"
+#define HUFF_MAGIC_LEN 4
+#define HUFF_FORMAT_VERSION 1
+
+// Las longitudes se guardan como pares (símbolo, longitud) en lugar de 256 bytes.
+#define HUFF_FLAG_SPARSE_LENGTHS 0x01
+
+// Los códigos son los de un diccionario compartido (huff_dict.h): el encabezado guarda solo su id.
+#define HUFF_FLAG_DICT 0x02
+
+// Tamaño máximo del encabezado.
+#define HUFF_HEADER_MAX_SIZE (HUFF_MAGIC_LEN + 1 + 1 + 8 + 2 + 2 * HUFF_MAX_SYMBOLS)
+
+// Encabezado de un archivo comprimido.
+struct huff_header {
+	unsigned int  version;                     // Versión del formato.
+	unsigned int  flags;                       // Combinación de HUFF_FLAG_*.
+	uint64_t      orig_len;                    // Longitud del archivo original.
+	uint32_t      dict_id;                     // Diccionario de los códigos (solo con HUFF_FLAG_DICT).
+	unsigned char lengths[HUFF_MAX_SYMBOLS];   // Longitud del código de cada símbolo (0 = no aparece).
+};
+
+// Nombre corto para el encabezado.
+typedef struct huff_header HHeader;
+
+// Formato por bloques (HUFF_STREAM_VERSION), para entradas cuya longitud no se conoce de antemano
+// (tuberías, sockets, datos que se siguen produciendo). Cada bloque tiene sus propios códigos:
+//
+//   magic       4 bytes  "HUFZ"
+//   version     1 byte   HUFF_STREAM_VERSION
+//   flags       1 byte   HUFF_STREAM_FLAG_*
+//   block_size  4 bytes  longitud máxima de un bloque sin comprimir
+//   n_streams   1 byte   solo con HUFF_STREAM_FLAG_INTERLEAVED: flujos de bits por bloque (2..HUFF_MAX_STREAMS)
+//   bloques     raw_len      4 bytes  bytes originales del bloque (0 = fin del flujo, sin más campos)
+//               payload_len  4 bytes  bytes de los flujos de bits del bloque
+//               n_symbols    2 bytes  símbolos con longitud de código distinta de cero
+//               longitudes   n_symbols pares (símbolo, longitud) si 2 * n_symbols < 256, si no 256 bytes
+//               saltos       (n_streams - 1) * 4 bytes: bytes de cada flujo salvo el último
+//               payload      los flujos de bits, uno detrás de otro, cada uno rellenado con ceros hasta el byte
+//   índice      solo con HUFF_STREAM_FLAG_INDEX, después de la marca de fin (huff_index.h)
+//
+// Cada bloque empieza en un byte y se decodifica sin los anteriores. Con n_streams flujos, el flujo k
+// codifica el k-ésimo trozo del bloque (huff_split_streams), de modo que el decodificador puede
+// avanzar todos los flujos en el mismo ciclo y solapar la latencia de cada búsqueda en la tabla.
+#define HUFF_STREAM_VERSION 2
+
+// Formato de un solo bloque codificado con rANS en lugar de Huffman (huff_ans.h).
+#define HUFF_ANS_VERSION 3
+
+// Formato de un solo bloque con códigos de Huffman de orden 1 (huff_order1.h).
+#define HUFF_O1_VERSION 4
+
+// El encabezado lleva n_streams y cada bloque una tabla de saltos.
+#define HUFF_STREAM_FLAG_INTERLEAVED 0x01
+
+// Después de la marca de fin hay un índice de bloques para el acceso aleatorio.
+#define HUFF_STREAM_FLAG_INDEX 0x02
+
+// Cantidad máxima de flujos de bits por bloque.
+#define HUFF_MAX_STREAMS 16
+
+// Tamaño máximo del encabezado del formato por bloques.
+#define HUFF_STREAM_HEADER_MAX_SIZE (HUFF_MAGIC_LEN + 1 + 1 + 4 + 1)
+
+// Tamaño máximo del encabezado de un bloque.
+#define HUFF_BLOCK_HEADER_MAX_SIZE (4 + 4 + 2 + 2 * HUFF_MAX_SYMBOLS + 4 * (HUFF_MAX_STREAMS - 1))
+
+// Longitud máxima de un bloque que acepta el decodificador (limita la memoria de un flujo dañado).
+#ifndef HUFF_STREAM_MAX_BLOCK
+#define HUFF_STREAM_MAX_BLOCK (64 * 1024 * 1024)
+#endif // !HUFF_STREAM_MAX_BLOCK
+
+// Encabezado del formato por bloques.
+struct huff_stream_header {
+	unsigned int flags;      // Combinación de HUFF_STREAM_FLAG_*.
+	uint32_t     block_size; // Longitud máxima de un bloque sin comprimir.
+	int          n_streams;  // Flujos de bits por bloque (1 sin HUFF_STREAM_FLAG_INTERLEAVED).
+};
+
+// Nombre corto para el encabezado del formato por bloques.
+typedef struct huff_stream_header HStreamHeader;
+
+// Encabezado de un bloque del formato por bloques.
+struct huff_block_header {
+	uint32_t      raw_len;                     // Bytes originales del bloque (0 = fin del flujo).
+	uint32_t      payload_len;                 // Bytes de todos los flujos de bits.
+	uint32_t      stream_len[HUFF_MAX_STREAMS]; // Bytes de cada flujo de bits.
+	unsigned char lengths[HUFF_MAX_SYMBOLS];   // Longitud del código de cada símbolo.
+};
+
+// Nombre corto para el encabezado de bloque.
+typedef struct huff_block_header HBlockHeader;
+
+// Función para escribir value como un entero de n bytes en little-endian.
+void huff_put_le(unsigned char* dst, uint64_t value, int n);
+
+// Función para leer un entero de n bytes en little-endian.
+uint64_t huff_get_le(const unsigned char* src, int n);
+
+// Función para verificar si un buffer empieza con el magic del formato.
+int huff_is_container(const unsigned char* src, size_t len);
+
+// Función para escribir el encabezado en dst (al menos HUFF_HEADER_MAX_SIZE bytes).
+// Elige la representación de longitudes más pequeña (o solo dict_id si flags tiene HUFF_FLAG_DICT)
+// y devuelve los bytes escritos.
+size_t huff_write_header(HHeader* header, unsigned char* dst);
+
+// Función para leer el encabezado. Devuelve los bytes consumidos o -1 si no es válido.
+// Con HUFF_FLAG_DICT las longitudes quedan en cero y hay que tomarlas del diccionario dict_id.
+long huff_read_header(const unsigned char* src, size_t len, HHeader* header);
+
+// Función para leer la versión de un archivo comprimido (0 si no es un contenedor).
+unsigned int huff_container_version(const unsigned char* src, size_t len);
+
+// Función para escribir el encabezado del formato por bloques. Con n_streams > 1 se activa
+// HUFF_STREAM_FLAG_INTERLEAVED. Devuelve los bytes escritos.
+size_t huff_write_stream_header(HStreamHeader* header, unsigned char* dst);
+
+// Función para leer el encabezado del formato por bloques. Devuelve los bytes consumidos,
+// 0 si todavía faltan bytes (en *need queda cuántos hacen falta en total) o -1 si no es válido.
+long huff_read_stream_header(const unsigned char* src, size_t len, HStreamHeader* header, size_t* need);
+
+// Función para escribir el encabezado de un bloque con n_streams flujos (al menos
+// HUFF_BLOCK_HEADER_MAX_SIZE bytes). Con raw_len == 0 escribe la marca de fin del flujo.
+// Devuelve los bytes escritos.
+size_t huff_write_block_header(const HBlockHeader* block, int n_streams, unsigned char* dst);
+
+// Función para leer el encabezado de un bloque con n_streams flujos. Devuelve los bytes
+// consumidos, 0 si todavía faltan bytes (en *need queda cuántos hacen falta en total) o -1
+// si no es válido. Con un solo flujo stream_len[0] es payload_len.
+long huff_read_block_header(const unsigned char* src, size_t len, int n_streams, HBlockHeader* block, size_t* need);
+
+// Función para repartir raw_len bytes en n_streams trozos consecutivos: los primeros
+// raw_len % n_streams trozos tienen un byte más.
+void huff_split_streams(uint32_t raw_len, int n_streams, uint32_t* seg_len);
+
+// Función para asignar códigos canónicos a partir de las longitudes.
+// Los símbolos se ordenan por (longitud, símbolo) y reciben códigos consecutivos.
+// Devuelve 0, o -1 si las longitudes no forman un código prefijo válido.
+int huff_canonical_codes(const unsigned char* lengths, uint64_t* codes);
+
+#endif // !HUFF_FORMAT_H
@@ -0,0 +1,51 @@
+#include <string.h>
+#include "huff_histogram.h"
+
+// Cuenta los bytes de data en HUFF_HISTOGRAM_BANKS bancos y los suma en counts.
+// Se leen 16 bytes por iteración y cada byte va al banco que le toca según su posición.
+void huff_histogram(const unsigned char* data, size_t n, uint64_t* counts) {
+    uint64_t banks[HUFF_HISTOGRAM_BANKS][HUFF_MAX_SYMBOLS];
+    memset(banks, 0, sizeof(banks));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint64_t w0, w1;
+        memcpy(&w0, data + i, sizeof(w0));
+        memcpy(&w1, data + i + 8, sizeof(w1));
+        // Desenrollado a mano: dos palabras de 8 bytes repartidas en los bancos por posición.
+        banks[0][w0 & 0xFF]++;
+        banks[1 % HUFF_HISTOGRAM_BANKS][(w0 >> 8) & 0xFF]++;
+        banks[2 % HUFF_HISTOGRAM_BANKS][(w0 >> 16) & 0xFF]++;
+        banks[3 % HUFF_HISTOGRAM_BANKS][(w0 >> 24) & 0xFF]++;
+        banks[4 % HUFF_HISTOGRAM_BANKS][(w0 >> 32) & 0xFF]++;
+        banks[5 % HUFF_HISTOGRAM_BANKS][(w0 >> 40) & 0xFF]++;
+        banks[6 % HUFF_HISTOGRAM_BANKS][(w0 >> 48) & 0xFF]++;
+        banks[7 % HUFF_HISTOGRAM_BANKS][w0 >> 56]++;
+        banks[0][w1 & 0xFF]++;
+        banks[1 % HUFF_HISTOGRAM_BANKS][(w1 >> 8) & 0xFF]++;
+        banks[2 % HUFF_HISTOGRAM_BANKS][(w1 >> 16) & 0xFF]++;
+        banks[3 % HUFF_HISTOGRAM_BANKS][(w1 >> 24) & 0xFF]++;
+        banks[4 % HUFF_HISTOGRAM_BANKS][(w1 >> 32) & 0xFF]++;
+        banks[5 % HUFF_HISTOGRAM_BANKS][(w1 >> 40) & 0xFF]++;
+        banks[6 % HUFF_HISTOGRAM_BANKS][(w1 >> 48) & 0xFF]++;
+        banks[7 % HUFF_HISTOGRAM_BANKS][w1 >> 56]++;
+    }
+    for (; i < n; i++) {
+        banks[i % HUFF_HISTOGRAM_BANKS][data[i]]++;
+    }
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        uint64_t total = 0;
+        for (int b = 0; b < HUFF_HISTOGRAM_BANKS; b++) {
+            total += banks[b][s];
+        }
+        counts[s] += total;
+    }
+}
+
+// Devuelve la suma de los contadores.
+uint64_t huff_histogram_total(const uint64_t* counts) {
+    uint64_t total = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        total += counts[s];
+    }
+    return total;
+}
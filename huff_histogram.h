@@ -0,0 +1,21 @@
+#ifndef HUFF_HISTOGRAM_H
+#define HUFF_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "huff_const.h"
+
+// Número de sub-histogramas intercalados. Bytes consecutivos se cuentan en bancos distintos,
+// así una racha del mismo byte no encadena cada incremento con el anterior (store-to-load).
+#ifndef HUFF_HISTOGRAM_BANKS
+#define HUFF_HISTOGRAM_BANKS 4
+#endif // !HUFF_HISTOGRAM_BANKS
+
+// Función para sumar a counts (HUFF_MAX_SYMBOLS contadores) las apariciones de cada byte de data.
+// counts no se pone en cero, de modo que se puede llamar por bloques sobre una entrada larga.
+void huff_histogram(const unsigned char* data, size_t n, uint64_t* counts);
+
+// Función que devuelve la suma de los contadores.
+uint64_t huff_histogram_total(const uint64_t* counts);
+
+#endif // !HUFF_HISTOGRAM_H
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "huff_index.h"
+#include "huff_format.h"
+#include "huff_decode.h"
+#include "huff_io.h"
+#include "huff_ans.h"
+#include "huff_order1.h"
+
+// Inicia un índice vacío.
+void huff_index_init(HIndex* index, uint32_t interval) {
+    memset(index, 0, sizeof(*index));
+    index->interval = interval;
+}
+
+// Libera el índice.
+void huff_index_free(HIndex* index) {
+    free(index->raw_offset);
+    free(index->bit_offset);
+    free(index->first_point);
+    free(index->points);
+    huff_index_init(index, 0);
+}
+
+// Agrega un bloque al índice.
+int huff_index_add_block(HIndex* index, uint64_t raw_offset, uint64_t bit_offset) {
+    if (index->n_blocks + 1 >= index->cap_blocks) {
+        size_t cap = index->cap_blocks ? index->cap_blocks * 2 : 64;
+        uint64_t* raw = (uint64_t*)realloc(index->raw_offset, cap * sizeof(uint64_t));
+        if (raw != NULL) index->raw_offset = raw;
+        uint64_t* bits = (uint64_t*)realloc(index->bit_offset, cap * sizeof(uint64_t));
+        if (bits != NULL) index->bit_offset = bits;
+        size_t* first = (size_t*)realloc(index->first_point, (cap + 1) * sizeof(size_t));
+        if (first != NULL) index->first_point = first;
+        if (raw == NULL || bits == NULL || first == NULL) return -1;
+        index->cap_blocks = cap;
+    }
+    index->raw_offset[index->n_blocks] = raw_offset;
+    index->bit_offset[index->n_blocks] = bit_offset;
+    index->first_point[index->n_blocks] = index->n_points;
+    index->n_blocks++;
+    index->first_point[index->n_blocks] = index->n_points;
+    return 0;
+}
+
+// Agrega un punto de control al último bloque.
+int huff_index_add_point(HIndex* index, uint32_t bit) {
+    if (index->n_blocks == 0) return -1;
+    if (index->n_points == index->cap_points) {
+        size_t cap = index->cap_points ? index->cap_points * 2 : 256;
+        uint32_t* points = (uint32_t*)realloc(index->points, cap * sizeof(uint32_t));
+        if (points == NULL) return -1;
+        index->points = points;
+        index->cap_points = cap;
+    }
+    index->points[index->n_points++] = bit;
+    index->first_point[index->n_blocks] = index->n_points;
+    return 0;
+}
+
+// Bytes del índice serializado.
+size_t huff_index_size(const HIndex* index) {
+    return 4 + 4 + index->n_blocks * (8 + 8 + 4) + index->n_points * 4 + HUFF_INDEX_FOOTER_SIZE;
+}
+
+// Serializa el índice.
+void huff_write_index(const HIndex* index, uint64_t index_offset, unsigned char* dst) {
+    size_t pos = 0;
+    huff_put_le(dst + pos, index->interval, 4);
+    pos += 4;
+    huff_put_le(dst + pos, index->n_blocks, 4);
+    pos += 4;
+    for (size_t b = 0; b < index->n_blocks; b++) {
+        size_t n_points = index->first_point[b + 1] - index->first_point[b];
+        huff_put_le(dst + pos, index->raw_offset[b], 8);
+        huff_put_le(dst + pos + 8, index->bit_offset[b], 8);
+        huff_put_le(dst + pos + 16, n_points, 4);
+        pos += 20;
+        for (size_t i = 0; i < n_points; i++) {
+            huff_put_le(dst + pos, index->points[index->first_point[b] + i], 4);
+            pos += 4;
+        }
+    }
+    huff_put_le(dst + pos, index_offset, 8);
+    memcpy(dst + pos + 8, HUFF_INDEX_MAGIC, HUFF_INDEX_MAGIC_LEN);
+}
+
+// Lee el índice del final del archivo.
+int huff_read_index(const unsigned char* src, size_t len, HIndex* index) {
+    huff_index_init(index, 0);
+    if (len < HUFF_INDEX_FOOTER_SIZE) return -1;
+    const unsigned char* footer = src + len - HUFF_INDEX_FOOTER_SIZE;
+    if (memcmp(footer + 8, HUFF_INDEX_MAGIC, HUFF_INDEX_MAGIC_LEN) != 0) return -1;
+    uint64_t index_offset = huff_get_le(footer, 8);
+    if (index_offset + 8 > len - HUFF_INDEX_FOOTER_SIZE) return -1;
+    const unsigned char* p = src + index_offset;
+    const unsigned char* end = footer;
+    index->interval = (uint32_t)huff_get_le(p, 4);
+    size_t n_blocks = (size_t)huff_get_le(p + 4, 4);
+    p += 8;
+    for (size_t b = 0; b < n_blocks; b++) {
+        if (end - p < 20) break;
+        size_t n_points = (size_t)huff_get_le(p + 16, 4);
+        if (huff_index_add_block(index, huff_get_le(p, 8), huff_get_le(p + 8, 8)) != 0) break;
+        p += 20;
+        if ((size_t)(end - p) / 4 < n_points) break;
+        for (size_t i = 0; i < n_points; i++, p += 4) {
+            if (huff_index_add_point(index, (uint32_t)huff_get_le(p, 4)) != 0) break;
+        }
+    }
+    if (index->n_blocks != n_blocks || p != end) {
+        huff_index_free(index);
+        return -1;
+    }
+    return 0;
+}
+
+// Construye el índice recorriendo los encabezados de bloque.
+int huff_index_scan(const unsigned char* src, size_t len, HIndex* index) {
+    huff_index_init(index, 0);
+    HStreamHeader header;
+    size_t need = 0;
+    long pos = huff_read_stream_header(src, len, &header, &need);
+    if (pos <= 0) return -1;
+    uint64_t raw_offset = 0;
+    for (;;) {
+        HBlockHeader block;
+        long header_len = huff_read_block_header(src + pos, len - (size_t)pos, header.n_streams, &block, &need);
+        if (header_len <= 0) break;
+        if (block.raw_len == 0) return 0; // Marca de fin.
+        if (block.payload_len > len - (size_t)pos - (size_t)header_len) break;
+        if (huff_index_add_block(index, raw_offset, (uint64_t)pos * 8) != 0) break;
+        raw_offset += block.raw_len;
+        pos += header_len + (long)block.payload_len;
+    }
+    huff_index_free(index);
+    return -1;
+}
+
+// Busca el bloque que contiene el byte original offset (búsqueda binaria).
+long huff_index_find(const HIndex* index, uint64_t offset) {
+    if (index->n_blocks == 0 || offset < index->raw_offset[0]) return -1;
+    size_t lo = 0, hi = index->n_blocks;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->raw_offset[mid] <= offset) lo = mid;
+        else hi = mid;
+    }
+    return (long)lo;
+}
+
+// Decodifica count símbolos desde el bit bit_pos de in y escribe los últimos count - skip.
+static int huff_range_decode(const HDecodeTable* table, const unsigned char* in, uint64_t bit_pos, uint64_t bit_end,
+                             size_t skip, size_t count, unsigned char* out, FILE* f_out, HFileResult* res) {
+    if (huff_decode_bits(table, in, &bit_pos, bit_end, out, count) != count) {
+        snprintf(res->msg, sizeof(res->msg), "corrupt block");
+        return -1;
+    }
+    if (fwrite(out + skip, 1, count - skip, f_out) != count - skip) {
+        snprintf(res->msg, sizeof(res->msg), "cannot write output");
+        return -1;
+    }
+    res->bytes_out += count - skip;
+    return 0;
+}
+
+// Decodifica la parte [from, to) de un bloque del formato por bloques.
+// Con un solo flujo arranca en el punto de control anterior a from; con varios flujos decodifica
+// solo los flujos cuyos trozos se solapan con el rango.
+static int huff_range_block(const unsigned char* in, size_t in_len, const HStreamHeader* header, const HIndex* index,
+                            size_t b, uint64_t from, uint64_t to, unsigned char* out, FILE* f_out, HFileResult* res) {
+    uint64_t pos = index->bit_offset[b] / 8;
+    HBlockHeader block;
+    size_t need = 0;
+    long header_len = pos < in_len ? huff_read_block_header(in + pos, in_len - pos, header->n_streams, &block, &need) : -1;
+    if (header_len <= 0 || block.raw_len == 0 || block.raw_len > header->block_size ||
+        block.payload_len > in_len - pos - (size_t)header_len) {
+        snprintf(res->msg, sizeof(res->msg), "invalid block header");
+        return -1;
+    }
+    if (from > block.raw_len) {
+        snprintf(res->msg, sizeof(res->msg), "offset beyond end of file");
+        return -1;
+    }
+    if (to > block.raw_len) to = block.raw_len;
+    if (from == to) return 0;
+    const unsigned char* payload = in + pos + (size_t)header_len;
+    HDecodeNode* root_decode = create_huff_decode_node();
+    HDecodeTable* table = NULL;
+    if (root_decode != NULL && build_huff_decode_tree_from_lengths(block.lengths, root_decode) == 0) {
+        table = build_huff_decode_table(root_decode);
+    }
+    int ret = -1;
+    if (table == NULL) {
+        snprintf(res->msg, sizeof(res->msg), "invalid code lengths");
+    } else if (header->n_streams == 1) {
+        // Punto de control k: el byte original k * interval del bloque empieza en points[k - 1].
+        size_t n_points = index->first_point[b + 1] - index->first_point[b];
+        uint64_t k = index->interval > 0 ? from / index->interval : 0;
+        if (k > n_points) k = n_points;
+        uint64_t start = k * index->interval;
+        uint64_t bit_pos = k > 0 ? index->points[index->first_point[b] + k - 1] : 0;
+        ret = huff_range_decode(table, payload, bit_pos, (uint64_t)block.payload_len * 8,
+                                (size_t)(from - start), (size_t)(to - start), out, f_out, res);
+    } else {
+        uint32_t seg_len[HUFF_MAX_STREAMS];
+        huff_split_streams(block.raw_len, header->n_streams, seg_len);
+        uint64_t seg_start = 0, stream_pos = 0;
+        ret = 0;
+        for (int k = 0; k < header->n_streams && ret == 0; k++) {
+            uint64_t seg_end = seg_start + seg_len[k];
+            if (seg_end > from && seg_start < to) {
+                uint64_t a = from > seg_start ? from : seg_start;
+                uint64_t e = to < seg_end ? to : seg_end;
+                ret = huff_range_decode(table, payload + stream_pos, 0, (uint64_t)block.stream_len[k] * 8,
+                                        (size_t)(a - seg_start), (size_t)(e - seg_start), out, f_out, res);
+            }
+            seg_start = seg_end;
+            stream_pos += block.stream_len[k];
+        }
+    }
+    free_huff_decode_table(table);
+    free_huff_decode_tree(root_decode);
+    return ret;
+}
+
+// Decodifica un rango de un archivo en el formato de un solo bloque, desde el principio.
+static int huff_range_single(const unsigned char* in, size_t in_len, uint64_t offset, uint64_t length,
+                             FILE* f_out, HFileResult* res) {
+    HHeader header;
+    long header_len = huff_read_header(in, in_len, &header);
+    if (header_len < 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid header");
+        return -1;
+    }
+    if (header.flags & HUFF_FLAG_DICT) {
+        snprintf(res->msg, sizeof(res->msg), "--range does not support files encoded with a dictionary");
+        return -1;
+    }
+    if (offset > header.orig_len) {
+        snprintf(res->msg, sizeof(res->msg), "offset beyond end of file");
+        return -1;
+    }
+    uint64_t end = header.orig_len - offset < length ? header.orig_len : offset + length;
+    if (end == offset) return 0;
+    HDecodeNode* root_decode = create_huff_decode_node();
+    HDecodeTable* table = NULL;
+    if (root_decode != NULL && build_huff_decode_tree_from_lengths(header.lengths, root_decode) == 0) {
+        table = build_huff_decode_table(root_decode);
+    }
+    unsigned char* out = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    int ret = -1;
+    if (table == NULL || out == NULL) {
+        snprintf(res->msg, sizeof(res->msg), "invalid code lengths");
+    } else {
+        // Sin índice no se sabe dónde empieza cada símbolo: se decodifica desde el principio.
+        uint64_t bit_pos = (uint64_t)header_len * 8, done = 0;
+        ret = 0;
+        while (done < end && ret == 0) {
+            size_t n = end - done < HUFF_IO_BUFFER_SIZE ? (size_t)(end - done) : HUFF_IO_BUFFER_SIZE;
+            if (huff_decode_bits(table, in, &bit_pos, (uint64_t)in_len * 8, out, n) != n) {
+                snprintf(res->msg, sizeof(res->msg), "truncated or corrupt data");
+                ret = -1;
+            } else if (done + n > offset) {
+                size_t skip = done < offset ? (size_t)(offset - done) : 0;
+                if (fwrite(out + skip, 1, n - skip, f_out) != n - skip) {
+                    snprintf(res->msg, sizeof(res->msg), "cannot write output");
+                    ret = -1;
+                } else {
+                    res->bytes_out += n - skip;
+                }
+            }
+            done += n;
+        }
+    }
+    free(out);
+    free_huff_decode_table(table);
+    free_huff_decode_tree(root_decode);
+    return ret;
+}
+
+// Interfaz para decodificar solo un rango del archivo original.
+int huff_decode_range(const char* filename, uint64_t offset, uint64_t length, FILE* f_out, HFileResult* res) {
+    memset(res, 0, sizeof(*res));
+    res->status = -1;
+    HInput input; // Con mmap solo se leen del disco las páginas de los bloques que se usan.
+    if (huff_input_open(filename, &input) != 0) {
+        snprintf(res->msg, sizeof(res->msg), "cannot open %s", filename);
+        return -1;
+    }
+    res->bytes_in = input.len;
+    unsigned int version = huff_container_version(input.data, input.len);
+    int ret = -1;
+    if (version == HUFF_FORMAT_VERSION) {
+        ret = huff_range_single(input.data, input.len, offset, length, f_out, res);
+    } else if (version == HUFF_ANS_VERSION) {
+        ret = huff_ans_decode_file(input.data, input.len, offset, length, f_out, res);
+    } else if (version == HUFF_O1_VERSION) {
+        ret = huff_o1_decode_file(input.data, input.len, offset, length, f_out, res);
+    } else if (version == HUFF_STREAM_VERSION) {
+        HStreamHeader header;
+        HIndex index;
+        size_t need = 0;
+        int have_index = -1;
+        if (huff_read_stream_header(input.data, input.len, &header, &need) > 0) {
+            have_index = (header.flags & HUFF_STREAM_FLAG_INDEX) ? huff_read_index(input.data, input.len, &index)
+                                                                  : huff_index_scan(input.data, input.len, &index);
+        }
+        unsigned char* out = have_index == 0 ? (unsigned char*)malloc(header.block_size) : NULL;
+        if (out == NULL) {
+            snprintf(res->msg, sizeof(res->msg), have_index == 0 ? "out of memory" : "invalid block stream or index");
+        } else {
+            long b = huff_index_find(&index, offset);
+            if (b < 0 && offset == 0) {
+                ret = 0; // Archivo vacío.
+            } else if (b < 0) {
+                snprintf(res->msg, sizeof(res->msg), "offset beyond end of file");
+            } else {
+                ret = 0;
+                uint64_t end = UINT64_MAX - offset < length ? UINT64_MAX : offset + length;
+                for (size_t i = (size_t)b; i < index.n_blocks && offset < end && ret == 0; i++) {
+                    uint64_t base = index.raw_offset[i];
+                    ret = huff_range_block(input.data, input.len, &header, &index, i, offset - base, end - base,
+                                           out, f_out, res);
+                    offset = i + 1 < index.n_blocks ? index.raw_offset[i + 1] : end;
+                }
+            }
+        }
+        free(out);
+        if (have_index == 0) huff_index_free(&index);
+    } else {
+        snprintf(res->msg, sizeof(res->msg), "%s is not a compressed container", filename);
+    }
+    huff_input_close(&input);
+    if (ret == 0) res->status = 0;
+    return ret;
+}
@@ -0,0 +1,82 @@
+#ifndef HUFF_INDEX_H
+#define HUFF_INDEX_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "huff_result.h"
+
+// Índice de un archivo en el formato por bloques (HUFF_STREAM_FLAG_INDEX), escrito después de la
+// marca de fin. Todos los enteros en little-endian:
+//
+//   interval     4 bytes  bytes originales entre puntos de control dentro de un bloque (0 = ninguno)
+//   n_blocks     4 bytes  bloques del archivo
+//   por bloque   raw_offset   8 bytes  posición del primer byte del bloque en el archivo original
+//                bit_offset   8 bytes  posición en bits del encabezado del bloque en el archivo comprimido
+//                n_points     4 bytes  puntos de control del bloque
+//                puntos       n_points * 4 bytes: el punto i es el bit del payload donde empieza el
+//                             byte original raw_offset + (i + 1) * interval (solo bloques de un flujo)
+//   index_offset 8 bytes  posición del índice en el archivo
+//   magic        4 bytes  "HUFX"
+//
+// El final fijo permite encontrar el índice leyendo los últimos bytes del archivo, sin recorrerlo.
+#define HUFF_INDEX_MAGIC "HUFX"
+#define HUFF_INDEX_MAGIC_LEN 4
+
+// Bytes del final fijo del índice (index_offset y magic).
+#define HUFF_INDEX_FOOTER_SIZE (8 + HUFF_INDEX_MAGIC_LEN)
+
+// Índice de bloques en memoria.
+struct huff_index {
+	uint32_t  interval;    // Bytes originales entre puntos de control (0 = solo inicios de bloque).
+	size_t    n_blocks;    // Bloques.
+	size_t    cap_blocks;  // Capacidad de los arreglos por bloque.
+	uint64_t* raw_offset;  // Posición de cada bloque en el archivo original.
+	uint64_t* bit_offset;  // Posición en bits del encabezado de cada bloque en el archivo comprimido.
+	size_t*   first_point; // Primer punto de control de cada bloque (n_blocks + 1 valores).
+	uint32_t* points;      // Puntos de control de todos los bloques, en bits desde el inicio del payload.
+	size_t    n_points;    // Puntos de control.
+	size_t    cap_points;  // Capacidad de points.
+};
+
+// Nombre corto para el índice.
+typedef struct huff_index HIndex;
+
+// Función para iniciar un índice vacío.
+void huff_index_init(HIndex* index, uint32_t interval);
+
+// Función para liberar el índice.
+void huff_index_free(HIndex* index);
+
+// Función para agregar un bloque al índice. Devuelve 0 o -1 si no hay memoria.
+int huff_index_add_block(HIndex* index, uint64_t raw_offset, uint64_t bit_offset);
+
+// Función para agregar un punto de control al último bloque. Devuelve 0 o -1 si no hay memoria.
+int huff_index_add_point(HIndex* index, uint32_t bit);
+
+// Función para obtener los bytes que ocupa el índice serializado (incluido el final fijo).
+size_t huff_index_size(const HIndex* index);
+
+// Función para serializar el índice en dst (huff_index_size bytes). index_offset es la posición
+// del índice en el archivo comprimido.
+void huff_write_index(const HIndex* index, uint64_t index_offset, unsigned char* dst);
+
+// Función para leer el índice del final de un archivo comprimido completo en memoria.
+// Devuelve 0, o -1 si el archivo no termina con un índice válido.
+int huff_read_index(const unsigned char* src, size_t len, HIndex* index);
+
+// Función para construir el índice de un archivo en el formato por bloques recorriendo los
+// encabezados de bloque (sin decodificar). Se usa con archivos escritos sin índice.
+int huff_index_scan(const unsigned char* src, size_t len, HIndex* index);
+
+// Función para buscar el bloque que contiene el byte original offset. Devuelve su posición en el
+// índice o -1 si offset está fuera del archivo.
+long huff_index_find(const HIndex* index, uint64_t offset);
+
+// Interfaz para decodificar solo los bytes [offset, offset + length) del archivo original.
+// Con el formato por bloques salta al bloque (y al punto de control) más cercano y decodifica solo
+// lo necesario; con el formato de un solo bloque decodifica desde el principio hasta offset + length.
+// Si el rango pasa del final del archivo se escribe hasta el final. Deja el resultado en res.
+int huff_decode_range(const char* filename, uint64_t offset, uint64_t length, FILE* f_out, HFileResult* res);
+
+#endif // !HUFF_INDEX_H
@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "huff_io.h"
+#include "huff_const.h"
+
+// Lee todo lo que queda en fd a un buffer que crece al doble. Se usa cuando no se puede mapear.
+static int huff_input_read_all(int fd, size_t size_hint, HInput* in) {
+    size_t cap = size_hint > 0 ? size_hint + 1 : HUFF_IO_BUFFER_SIZE;
+    size_t len = 0;
+    unsigned char* buf = (unsigned char*)malloc(cap);
+    if (buf == NULL) return -1;
+    for (;;) {
+        if (len == cap) {
+            unsigned char* grown = (unsigned char*)realloc(buf, cap * 2);
+            if (grown == NULL) {
+                free(buf);
+                return -1;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, buf + len, cap - len);
+        if (n < 0) {
+            free(buf);
+            return -1;
+        }
+        if (n == 0) break;
+        len += (size_t)n;
+    }
+    in->data = buf;
+    in->len = len;
+    in->mapped = 0;
+    return 0;
+}
+
+// Carga un archivo completo en memoria.
+int huff_input_open(const char* filename, HInput* in) {
+    memset(in, 0, sizeof(*in));
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (S_ISREG(st.st_mode) && st.st_size == 0) { // Archivo vacío: nada que mapear.
+        close(fd);
+        return 0;
+    }
+    if (S_ISREG(st.st_mode)) {
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL); // Se recorre de principio a fin.
+            close(fd);
+            in->data = (const unsigned char*)p;
+            in->len = (size_t)st.st_size;
+            in->mapped = 1;
+            return 0;
+        }
+    }
+    int ret = huff_input_read_all(fd, S_ISREG(st.st_mode) ? (size_t)st.st_size : 0, in);
+    close(fd);
+    return ret;
+}
+
+// Libera la entrada.
+void huff_input_close(HInput* in) {
+    if (in->data != NULL) {
+        if (in->mapped) munmap((void*)in->data, in->len);
+        else free((void*)in->data);
+    }
+    memset(in, 0, sizeof(*in));
+}
@@ -0,0 +1,24 @@
+#ifndef HUFF_IO_H
+#define HUFF_IO_H
+
+#include <stddef.h>
+
+// Contenido completo de un archivo de entrada en memoria.
+// Se mapea con mmap cuando es posible; si no (tuberías, sistemas de archivos sin soporte)
+// se lee con una sola lectura grande a un buffer propio.
+struct huff_input {
+	const unsigned char* data;   // Bytes del archivo (NULL si está vacío).
+	size_t               len;    // Longitud en bytes.
+	int                  mapped; // 1 si data viene de mmap, 0 si es un buffer de malloc.
+};
+
+// Nombre corto para la entrada en memoria.
+typedef struct huff_input HInput;
+
+// Función para cargar un archivo completo en memoria. Devuelve 0 o -1 en caso de error.
+int huff_input_open(const char* filename, HInput* in);
+
+// Función para liberar la entrada (munmap o free según corresponda).
+void huff_input_close(HInput* in);
+
+#endif // !HUFF_IO_H
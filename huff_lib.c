@@ -0,0 +1,344 @@
+#define _GNU_SOURCE // fopencookie
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "huff.h"
+#include "huff_options.h"
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_format.h"
+#include "huff_stream.h"
+#include "huff_ans.h"
+#include "huff_order1.h"
+
+// Contexto: lo que se arma para un archivo y puede servir para el siguiente.
+struct huff_context {
+    HTreeArena     arena;                       // Árbol de codificación.
+    HEncodePlan    plan;                        // Códigos o frecuencias del último buffer comprimido.
+    HDecodeNode*   root;                        // Árbol de decodificación de lengths (NULL = ninguno).
+    HDecodeTable*  table;                       // Tabla de decodificación de root.
+    unsigned char  lengths[HUFF_MAX_SYMBOLS];   // Longitudes de root y table.
+    HAnsDecoder*   ans;                         // Decodificador rANS (su tabla es la de ans_freqs).
+    uint32_t       ans_freqs[HUFF_MAX_SYMBOLS]; // Frecuencias de la tabla de ans.
+    int            ans_ready;                   // 1 si la tabla de ans corresponde a ans_freqs.
+    HO1Decoder*    o1;                          // Decodificador de orden 1 (sus tablas son las de o1_model).
+    HO1Model       o1_model;                    // Modelo de las tablas de o1.
+    int            o1_ready;                    // 1 si las tablas de o1 corresponden a o1_model.
+    unsigned char* scratch;                     // Buffer de rANS cuando dst no tiene la holgura necesaria.
+    size_t         scratch_cap;                 // Capacidad de scratch.
+    HFileResult    result;                      // Error de la última llamada.
+};
+
+// Destino acotado del formato por bloques: el decodificador escribe en un FILE* y este lo vuelca en dst.
+struct huff_lib_sink {
+    unsigned char* dst;
+    size_t         cap;
+    size_t         len;
+    int            overflow; // 1 si el original no cabía en dst.
+};
+
+// Copia lo que escribe el decodificador en dst, o falla si ya no cabe.
+static ssize_t huff_lib_sink_write(void* cookie, const char* buf, size_t size) {
+    struct huff_lib_sink* sink = (struct huff_lib_sink*)cookie;
+    if (size > sink->cap - sink->len) {
+        sink->overflow = 1;
+        return 0;
+    }
+    memcpy(sink->dst + sink->len, buf, size);
+    sink->len += size;
+    return (ssize_t)size;
+}
+
+// Guarda el mensaje de error y devuelve HUFF_ERROR.
+static size_t huff_lib_fail(HContext* ctx, const char* msg) {
+    snprintf(ctx->result.msg, sizeof(ctx->result.msg), "%s", msg);
+    return HUFF_ERROR;
+}
+
+// Cota del archivo comprimido.
+size_t huff_compress_bound(size_t n) {
+    // Los códigos de Huffman (aun con la longitud limitada, si el límite es de al menos 8 bits)
+    // nunca ocupan más que 8 bits por símbolo; rANS, como mucho HUFF_ANS_SCALE_BITS, y los códigos
+    // de orden 1, HUFF_O1_MAX_LEN.
+    size_t huffman = HUFF_HEADER_MAX_SIZE + n + 1;
+    size_t ans = HUFF_ANS_HEADER_MAX_SIZE + HUFF_ANS_BOUND(n);
+    size_t o1 = HUFF_O1_HEADER_MAX_SIZE + (n * HUFF_O1_MAX_LEN + 7) / 8;
+    size_t bound = huffman > ans ? huffman : ans;
+    return bound > o1 ? bound : o1;
+}
+
+// Crea un contexto.
+HContext* huff_context_create(void) {
+    return (HContext*)calloc(1, sizeof(HContext));
+}
+
+// Libera las tablas de decodificación.
+static void huff_lib_drop_table(HContext* ctx) {
+    free_huff_decode_table(ctx->table);
+    free_huff_decode_tree(ctx->root);
+    ctx->table = NULL;
+    ctx->root = NULL;
+}
+
+// Libera el contexto.
+void huff_context_free(HContext* ctx) {
+    if (ctx == NULL) return;
+    huff_lib_drop_table(ctx);
+    free(ctx->ans);
+    free(ctx->o1);
+    free(ctx->scratch);
+    free(ctx);
+}
+
+// Devuelve el último error.
+const char* huff_context_error(const HContext* ctx) {
+    return ctx->result.msg;
+}
+
+// Traduce los parámetros públicos a las opciones internas. Devuelve 0, o -1 si no son válidos.
+static int huff_lib_options(const HParams* params, HOptions* opts) {
+    huff_options_default(opts);
+    if (params == NULL) return 0;
+    switch (params->backend) {
+    case HUFF_CODER_HUFFMAN: opts->backend = HUFF_BACKEND_HUFFMAN; break;
+    case HUFF_CODER_ANS:     opts->backend = HUFF_BACKEND_ANS; break;
+    case HUFF_CODER_ORDER1:  opts->backend = HUFF_BACKEND_ORDER1; break;
+    case HUFF_CODER_AUTO:    opts->backend = HUFF_BACKEND_AUTO; break;
+    default:                 return -1;
+    }
+    if (params->max_code_len < 0) return -1;
+    opts->max_code_len = params->max_code_len;
+    opts->threads = params->threads > 1 ? params->threads : 1;
+    return 0;
+}
+
+// Comprime con rANS: directamente en dst si tiene la holgura de HUFF_ANS_BOUND, si no en scratch.
+static size_t huff_lib_compress_ans(HContext* ctx, const unsigned char* src, size_t n, unsigned char* dst, size_t cap) {
+    unsigned char header[HUFF_ANS_HEADER_MAX_SIZE];
+    size_t header_len = huff_ans_write_header(ctx->plan.freqs, (uint64_t)n, header);
+    if (header_len > cap) return huff_lib_fail(ctx, "destination buffer too small");
+    memcpy(dst, header, header_len);
+    size_t bound = HUFF_ANS_BOUND(n);
+    if (cap - header_len >= bound) return header_len + huff_ans_encode(src, n, ctx->plan.freqs, dst + header_len);
+    if (ctx->scratch_cap < bound) {
+        unsigned char* grown = (unsigned char*)realloc(ctx->scratch, bound);
+        if (grown == NULL) return huff_lib_fail(ctx, "out of memory");
+        ctx->scratch = grown;
+        ctx->scratch_cap = bound;
+    }
+    size_t payload_len = huff_ans_encode(src, n, ctx->plan.freqs, ctx->scratch);
+    if (payload_len > cap - header_len) return huff_lib_fail(ctx, "destination buffer too small");
+    memcpy(dst + header_len, ctx->scratch, payload_len);
+    return header_len + payload_len;
+}
+
+// Comprime un buffer con un contexto.
+size_t huff_compress_ctx(HContext* ctx, const void* src, size_t n, void* dst, size_t cap, const HParams* params) {
+    memset(&ctx->result, 0, sizeof(ctx->result));
+    HOptions opts;
+    if (huff_lib_options(params, &opts) != 0) return huff_lib_fail(ctx, "invalid parameters");
+    const unsigned char* data = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+    HEncodePlan* plan = &ctx->plan;
+    if (huff_encode_plan_r(data, n, &opts, &ctx->arena, plan, &ctx->result) != 0) return HUFF_ERROR; // Mensaje en result.
+    if (plan->use_ans) return huff_lib_compress_ans(ctx, data, n, out, cap);
+    if (plan->use_o1) {
+        unsigned char o1_header[HUFF_O1_HEADER_MAX_SIZE];
+        size_t o1_header_len = huff_o1_write_header(&plan->o1, (uint64_t)n, o1_header);
+        if (o1_header_len > cap) return huff_lib_fail(ctx, "destination buffer too small");
+        memcpy(out, o1_header, o1_header_len);
+        size_t payload_len = huff_o1_encode_to(data, n, &plan->o1, out + o1_header_len, cap - o1_header_len);
+        if (payload_len == (size_t)-1) return huff_lib_fail(ctx, "destination buffer too small");
+        return o1_header_len + payload_len;
+    }
+
+    unsigned char header[HUFF_HEADER_MAX_SIZE];
+    plan->header.orig_len = (uint64_t)n;
+    size_t header_len = huff_write_header(&plan->header, header);
+    if (header_len > cap) return huff_lib_fail(ctx, "destination buffer too small");
+    memcpy(out, header, header_len);
+    uint64_t bits[HUFF_MAX_SYMBOLS];
+    HPackedCode codes[HUFF_MAX_SYMBOLS];
+    huff_canonical_codes(plan->header.lengths, bits);
+    int max_len = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        codes[s].bits = bits[s];
+        codes[s].len = plan->header.lengths[s];
+        if (codes[s].len > max_len) max_len = codes[s].len;
+    }
+    size_t payload_len = huff_encode_symbols_to(data, n, codes, max_len, out + header_len, cap - header_len);
+    if (payload_len == (size_t)-1) return huff_lib_fail(ctx, "destination buffer too small");
+    return header_len + payload_len;
+}
+
+// Descomprime el formato por bloques a través de un FILE* que escribe en dst.
+static size_t huff_lib_decompress_blocks(HContext* ctx, const unsigned char* in, size_t n, unsigned char* dst,
+                                         size_t cap, const HOptions* opts) {
+    struct huff_lib_sink sink = {dst, cap, 0, 0};
+    cookie_io_functions_t io = {NULL, huff_lib_sink_write, NULL, NULL};
+    FILE* f_out = fopencookie(&sink, "w", io);
+    if (f_out == NULL) return huff_lib_fail(ctx, "out of memory");
+    setvbuf(f_out, NULL, _IONBF, 0); // Cada bloque se copia una sola vez, de su buffer a dst.
+    int ret = huff_decode_blocks_parallel(in, n, f_out, opts ? opts->threads : 1, &ctx->result);
+    if (fclose(f_out) != 0) ret = -1;
+    if (sink.overflow) return huff_lib_fail(ctx, "destination buffer too small");
+    if (ret != 0) {
+        if (ctx->result.msg[0] == '\0') huff_lib_fail(ctx, "truncated or corrupt data");
+        return HUFF_ERROR;
+    }
+    return sink.len;
+}
+
+// Descomprime un archivo rANS con la tabla del contexto si las frecuencias no cambiaron.
+static size_t huff_lib_decompress_ans(HContext* ctx, const unsigned char* in, size_t n, unsigned char* dst, size_t cap) {
+    uint32_t freqs[HUFF_MAX_SYMBOLS];
+    uint64_t orig_len = 0;
+    long header_len = huff_ans_read_header(in, n, freqs, &orig_len);
+    if (header_len < 0) return huff_lib_fail(ctx, "invalid header");
+    if (orig_len == 0) return 0;
+    if (huff_ans_length_fits(freqs, orig_len, n - (size_t)header_len) != 0) {
+        return huff_lib_fail(ctx, "invalid symbol frequencies or length");
+    }
+    if (orig_len > cap) return huff_lib_fail(ctx, "destination buffer too small");
+    if (ctx->ans == NULL) {
+        ctx->ans = (HAnsDecoder*)malloc(sizeof(HAnsDecoder));
+        if (ctx->ans == NULL) return huff_lib_fail(ctx, "out of memory");
+    }
+    if (!ctx->ans_ready || memcmp(ctx->ans_freqs, freqs, sizeof(freqs)) != 0) {
+        ctx->ans_ready = 0;
+        if (huff_ans_decoder_table(ctx->ans, freqs) != 0) return huff_lib_fail(ctx, "invalid symbol frequencies");
+        memcpy(ctx->ans_freqs, freqs, sizeof(freqs));
+        ctx->ans_ready = 1;
+    }
+    if (huff_ans_decoder_start(ctx->ans, in + header_len, n - (size_t)header_len) != 0 ||
+        huff_ans_decode(ctx->ans, dst, (size_t)orig_len) != 0 || huff_ans_decoder_finish(ctx->ans) != 0) {
+        return huff_lib_fail(ctx, "truncated or corrupt data");
+    }
+    return (size_t)orig_len;
+}
+
+// Descomprime un archivo de orden 1 con las tablas del contexto si el modelo no cambió.
+static size_t huff_lib_decompress_o1(HContext* ctx, const unsigned char* in, size_t n, unsigned char* dst, size_t cap) {
+    HO1Model model;
+    uint64_t orig_len = 0;
+    long header_len = huff_o1_read_header(in, n, &model, &orig_len);
+    if (header_len < 0) return huff_lib_fail(ctx, "invalid header");
+    if (orig_len == 0) return 0;
+    if (orig_len / 8 > n - (size_t)header_len) return huff_lib_fail(ctx, "invalid length");
+    if (orig_len > cap) return huff_lib_fail(ctx, "destination buffer too small");
+    if (ctx->o1 == NULL) {
+        ctx->o1 = (HO1Decoder*)malloc(sizeof(HO1Decoder));
+        if (ctx->o1 == NULL) return huff_lib_fail(ctx, "out of memory");
+    }
+    if (!ctx->o1_ready || memcmp(&ctx->o1_model, &model, sizeof(model)) != 0) {
+        ctx->o1_ready = 0;
+        if (huff_o1_decoder_table(ctx->o1, &model) != 0) return huff_lib_fail(ctx, "invalid code lengths");
+        ctx->o1_model = model;
+        ctx->o1_ready = 1;
+    }
+    huff_o1_decoder_start(ctx->o1, in + header_len, n - (size_t)header_len);
+    if (huff_o1_decode(ctx->o1, dst, (size_t)orig_len) != 0) return huff_lib_fail(ctx, "truncated or corrupt data");
+    return (size_t)orig_len;
+}
+
+// Descomprime un archivo con códigos de Huffman con el árbol y la tabla del contexto si las
+// longitudes no cambiaron (por ejemplo, archivos con la misma distribución de bytes).
+static size_t huff_lib_decompress_huffman(HContext* ctx, const unsigned char* in, size_t n, unsigned char* dst,
+                                          size_t cap) {
+    HHeader header;
+    long header_len = huff_read_header(in, n, &header);
+    if (header_len < 0) return huff_lib_fail(ctx, "invalid header");
+    if (header.flags & HUFF_FLAG_DICT) {
+        // Los códigos están en un diccionario, que solo usa huffman_processor.
+        snprintf(ctx->result.msg, sizeof(ctx->result.msg), "needs dictionary %08x", (unsigned)header.dict_id);
+        return HUFF_ERROR;
+    }
+    if (header.orig_len == 0) return 0;
+    if (header.orig_len > cap) return huff_lib_fail(ctx, "destination buffer too small");
+    if (ctx->table == NULL || memcmp(ctx->lengths, header.lengths, HUFF_MAX_SYMBOLS) != 0) {
+        huff_lib_drop_table(ctx);
+        ctx->root = create_huff_decode_node();
+        if (ctx->root == NULL || build_huff_decode_tree_from_lengths(header.lengths, ctx->root) != 0) {
+            huff_lib_drop_table(ctx);
+            return huff_lib_fail(ctx, "invalid code lengths");
+        }
+        ctx->table = build_huff_decode_table(ctx->root);
+        if (ctx->table == NULL) {
+            huff_lib_drop_table(ctx);
+            return huff_lib_fail(ctx, "out of memory");
+        }
+        memcpy(ctx->lengths, header.lengths, HUFF_MAX_SYMBOLS);
+    }
+    uint64_t bit_pos = (uint64_t)header_len * 8;
+    size_t written = huff_decode_bits(ctx->table, in, &bit_pos, (uint64_t)n * 8, dst, (size_t)header.orig_len);
+    if (written != header.orig_len) {
+        snprintf(ctx->result.msg, sizeof(ctx->result.msg), "truncated or corrupt data (%llu of %llu bytes)",
+                 (unsigned long long)written, (unsigned long long)header.orig_len);
+        return HUFF_ERROR;
+    }
+    return written;
+}
+
+// Descomprime un archivo con un contexto.
+size_t huff_decompress_ctx(HContext* ctx, const void* src, size_t n, void* dst, size_t cap, const HParams* params) {
+    memset(&ctx->result, 0, sizeof(ctx->result));
+    HOptions opts;
+    if (huff_lib_options(params, &opts) != 0) return huff_lib_fail(ctx, "invalid parameters");
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+    switch (huff_container_version(in, n)) {
+    case HUFF_FORMAT_VERSION:
+        return huff_lib_decompress_huffman(ctx, in, n, out, cap);
+    case HUFF_STREAM_VERSION:
+        return huff_lib_decompress_blocks(ctx, in, n, out, cap, &opts);
+    case HUFF_ANS_VERSION:
+        return huff_lib_decompress_ans(ctx, in, n, out, cap);
+    case HUFF_O1_VERSION:
+        return huff_lib_decompress_o1(ctx, in, n, out, cap);
+    default:
+        return huff_lib_fail(ctx, "not a compressed container");
+    }
+}
+
+// Lee la longitud del original del encabezado.
+size_t huff_decompressed_size(const void* src, size_t n) {
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned int version = huff_container_version(in, n);
+    if (version == HUFF_FORMAT_VERSION) {
+        HHeader header;
+        if (huff_read_header(in, n, &header) < 0) return HUFF_ERROR;
+        return (size_t)header.orig_len;
+    }
+    if (version == HUFF_ANS_VERSION) {
+        uint32_t freqs[HUFF_MAX_SYMBOLS];
+        uint64_t orig_len = 0;
+        if (huff_ans_read_header(in, n, freqs, &orig_len) < 0) return HUFF_ERROR;
+        return (size_t)orig_len;
+    }
+    if (version == HUFF_O1_VERSION) {
+        HO1Model model;
+        uint64_t orig_len = 0;
+        if (huff_o1_read_header(in, n, &model, &orig_len) < 0) return HUFF_ERROR;
+        return (size_t)orig_len;
+    }
+    return HUFF_ERROR;
+}
+
+// Comprime con un contexto de un solo uso.
+size_t huff_compress(const void* src, size_t n, void* dst, size_t cap) {
+    HContext* ctx = huff_context_create();
+    if (ctx == NULL) return HUFF_ERROR;
+    size_t ret = huff_compress_ctx(ctx, src, n, dst, cap, NULL);
+    huff_context_free(ctx);
+    return ret;
+}
+
+// Descomprime con un contexto de un solo uso.
+size_t huff_decompress(const void* src, size_t n, void* dst, size_t cap) {
+    HContext* ctx = huff_context_create();
+    if (ctx == NULL) return HUFF_ERROR;
+    size_t ret = huff_decompress_ctx(ctx, src, n, dst, cap, NULL);
+    huff_context_free(ctx);
+    return ret;
+}
@@ -0,0 +1,428 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "huff_manifest.h"
+#include "huff_format.h"
+#include "huff_dict.h"
+#include "huff_io.h"
+
+// Bytes fijos del encabezado y de una entrada (sin el nombre).
+#define HUFF_MANIFEST_HEADER_SIZE (HUFF_MANIFEST_MAGIC_LEN + 1 + 1 + 2 + 8 + 4)
+#define HUFF_MANIFEST_ENTRY_SIZE (6 * 8 + 2)
+
+// Constantes de XXH64.
+#define HUFF_P1 11400714785074694791ULL
+#define HUFF_P2 14029467366897019727ULL
+#define HUFF_P3 1609587929392839161ULL
+#define HUFF_P4 9650029242287828579ULL
+#define HUFF_P5 2870177450012600261ULL
+
+// Lee 8 bytes en little-endian con una sola carga.
+static inline uint64_t huff_load_le64(const unsigned char* src) {
+    uint64_t value;
+    memcpy(&value, src, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// Rotación a la izquierda de r bits.
+static inline uint64_t huff_rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Mezcla 8 bytes en un acumulador.
+static inline uint64_t huff_hash_round(uint64_t acc, uint64_t input) {
+    acc += input * HUFF_P2;
+    acc = huff_rotl64(acc, 31);
+    return acc * HUFF_P1;
+}
+
+// Suma un acumulador al hash final.
+static inline uint64_t huff_hash_merge(uint64_t h, uint64_t acc) {
+    h ^= huff_hash_round(0, acc);
+    return h * HUFF_P1 + HUFF_P4;
+}
+
+// Hash de 64 bits. Cuatro acumuladores independientes recorren 32 bytes por iteración, así el
+// procesador los avanza en paralelo.
+uint64_t huff_hash64(const void* data, size_t len, uint64_t seed) {
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+        uint64_t v1 = seed + HUFF_P1 + HUFF_P2;
+        uint64_t v2 = seed + HUFF_P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - HUFF_P1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = huff_hash_round(v1, huff_load_le64(p));
+            v2 = huff_hash_round(v2, huff_load_le64(p + 8));
+            v3 = huff_hash_round(v3, huff_load_le64(p + 16));
+            v4 = huff_hash_round(v4, huff_load_le64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = huff_rotl64(v1, 1) + huff_rotl64(v2, 7) + huff_rotl64(v3, 12) + huff_rotl64(v4, 18);
+        h = huff_hash_merge(h, v1);
+        h = huff_hash_merge(h, v2);
+        h = huff_hash_merge(h, v3);
+        h = huff_hash_merge(h, v4);
+    } else {
+        h = seed + HUFF_P5;
+    }
+    h += (uint64_t)len;
+    for (; p + 8 <= end; p += 8) {
+        h ^= huff_hash_round(0, huff_load_le64(p));
+        h = huff_rotl64(h, 27) * HUFF_P1 + HUFF_P4;
+    }
+    if (p + 4 <= end) {
+        h ^= huff_get_le(p, 4) * HUFF_P1;
+        h = huff_rotl64(h, 23) * HUFF_P2 + HUFF_P3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (uint64_t)*p * HUFF_P5;
+        h = huff_rotl64(h, 11) * HUFF_P1;
+    }
+    h ^= h >> 33;
+    h *= HUFF_P2;
+    h ^= h >> 29;
+    h *= HUFF_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Hash de un archivo, mapeado completo.
+int huff_hash_file(const char* path, uint64_t* hash) {
+    HInput input;
+    if (huff_input_open(path, &input) != 0) return -1;
+    *hash = huff_hash64(input.data, input.len, 0);
+    huff_input_close(&input);
+    return 0;
+}
+
+// Hash de las opciones que cambian la salida.
+uint64_t huff_manifest_options_hash(int encode, const HOptions* opts) {
+    HOptions defaults;
+    if (opts == NULL) {
+        huff_options_default(&defaults);
+        opts = &defaults;
+    }
+    int64_t fields[] = {
+        encode,
+        opts->legacy,
+        opts->max_code_len,
+        opts->block_size,
+        opts->streams > 1 ? opts->streams : 1,
+        opts->index_interval,
+        opts->dict ? (int64_t)opts->dict->id : -1,
+        opts->dict ? opts->dict_threshold : 0,
+        opts->backend,
+    };
+    unsigned char buf[sizeof(fields)];
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) huff_put_le(buf + 8 * i, (uint64_t)fields[i], 8);
+    return huff_hash64(buf, sizeof(buf), HUFF_MANIFEST_VERSION);
+}
+
+// Fecha de modificación de un stat en nanosegundos.
+static int64_t huff_manifest_mtime(const struct stat* st) {
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + (int64_t)st->st_mtim.tv_nsec;
+}
+
+// Compara entradas por nombre (bytes sin signo, como strcmp).
+static int huff_manifest_compare(const void* a, const void* b) {
+    return strcmp(((const HManifestEntry*)a)->name, ((const HManifestEntry*)b)->name);
+}
+
+// Busca name entre las primeras n entradas (ordenadas). Devuelve NULL si no está.
+static HManifestEntry* huff_manifest_find(const HManifest* m, size_t n, const char* name) {
+    if (n == 0) return NULL;
+    HManifestEntry key;
+    key.name = (char*)name;
+    return (HManifestEntry*)bsearch(&key, m->entries, n, sizeof(HManifestEntry), huff_manifest_compare);
+}
+
+// Nombre de la entrada de un archivo: la ruta sin el directorio.
+static const char* huff_manifest_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+// Agrega una entrada al final. Devuelve NULL si no hay memoria.
+static HManifestEntry* huff_manifest_append(HManifest* m, const char* name) {
+    if (m->n_entries == m->cap_entries) {
+        size_t cap = m->cap_entries ? m->cap_entries * 2 : 64;
+        HManifestEntry* entries = (HManifestEntry*)realloc(m->entries, cap * sizeof(HManifestEntry));
+        if (entries == NULL) return NULL;
+        m->entries = entries;
+        m->cap_entries = cap;
+    }
+    HManifestEntry* e = &m->entries[m->n_entries];
+    memset(e, 0, sizeof(*e));
+    e->name = strdup(name);
+    if (e->name == NULL) return NULL;
+    m->n_entries++;
+    return e;
+}
+
+// Quita las entradas borradas (name == NULL) y vuelve a ordenar las demás.
+static void huff_manifest_compact(HManifest* m) {
+    size_t kept = 0;
+    for (size_t i = 0; i < m->n_entries; i++) {
+        if (m->entries[i].name != NULL) m->entries[kept++] = m->entries[i];
+    }
+    m->n_entries = kept;
+    if (kept > 1) qsort(m->entries, kept, sizeof(HManifestEntry), huff_manifest_compare);
+}
+
+// Libera las entradas.
+static void huff_manifest_clear(HManifest* m) {
+    for (size_t i = 0; i < m->n_entries; i++) free(m->entries[i].name);
+    free(m->entries);
+    m->entries = NULL;
+    m->n_entries = 0;
+    m->cap_entries = 0;
+}
+
+// Lee las entradas de un manifiesto en memoria. Devuelve 0, o -1 si no es válido.
+static int huff_manifest_parse(HManifest* m, const unsigned char* src, size_t len, uint64_t* opts_hash) {
+    if (len < HUFF_MANIFEST_HEADER_SIZE + 8 || memcmp(src, HUFF_MANIFEST_MAGIC, HUFF_MANIFEST_MAGIC_LEN) != 0 ||
+        src[4] != HUFF_MANIFEST_VERSION || src[5] != 0) return -1;
+    if (huff_hash64(src, len - 8, 0) != huff_get_le(src + len - 8, 8)) return -1;
+    *opts_hash = huff_get_le(src + 8, 8);
+    uint32_t n_entries = (uint32_t)huff_get_le(src + 16, 4);
+    size_t pos = HUFF_MANIFEST_HEADER_SIZE;
+    const size_t body_end = len - 8;
+    for (uint32_t i = 0; i < n_entries; i++) {
+        if (body_end - pos < HUFF_MANIFEST_ENTRY_SIZE) return -1;
+        const unsigned char* p = src + pos;
+        size_t name_len = (size_t)huff_get_le(p + 48, 2);
+        pos += HUFF_MANIFEST_ENTRY_SIZE;
+        if (name_len == 0 || name_len >= HUFF_PATH_MAX || body_end - pos < name_len) return -1;
+        char name[HUFF_PATH_MAX];
+        memcpy(name, src + pos, name_len);
+        name[name_len] = '\0';
+        pos += name_len;
+        // Nombres sin directorio, sin '\0' en medio y estrictamente ordenados.
+        if (strlen(name) != name_len || strchr(name, '/') != NULL) return -1;
+        if (m->n_entries > 0 && strcmp(m->entries[m->n_entries - 1].name, name) >= 0) return -1;
+        HManifestEntry* e = huff_manifest_append(m, name);
+        if (e == NULL) return -1;
+        e->in_size = huff_get_le(p, 8);
+        e->in_mtime = (int64_t)huff_get_le(p + 8, 8);
+        e->in_hash = huff_get_le(p + 16, 8);
+        e->out_size = huff_get_le(p + 24, 8);
+        e->out_mtime = (int64_t)huff_get_le(p + 32, 8);
+        e->out_hash = huff_get_le(p + 40, 8);
+    }
+    return pos == body_end ? 0 : -1;
+}
+
+// Lee el manifiesto del directorio de salida.
+int huff_manifest_load(HManifest* m, const char* output_dir, uint64_t opts_hash) {
+    memset(m, 0, sizeof(*m));
+    m->opts_hash = opts_hash;
+    m->stale = 1;
+    if (snprintf(m->dir, sizeof(m->dir), "%s", output_dir) >= (int)sizeof(m->dir) ||
+        snprintf(m->path, sizeof(m->path), "%s/%s", output_dir, HUFF_MANIFEST_NAME) >= (int)sizeof(m->path)) {
+        m->path[0] = '\0'; // Ruta demasiado larga: se procesa todo y huff_manifest_save falla.
+        return 0;
+    }
+    HInput input;
+    if (huff_input_open(m->path, &input) != 0) return 0;
+    uint64_t old_hash = 0;
+    int ret = huff_manifest_parse(m, input.data, input.len, &old_hash);
+    huff_input_close(&input);
+    if (ret != 0) {
+        huff_manifest_clear(m); // Un manifiesto dañado no sirve ni para limpiar: se procesa todo.
+        return 0;
+    }
+    m->stale = old_hash != opts_hash;
+    return !m->stale;
+}
+
+// Devuelve 1 si un archivo de size bytes modificado en mtime sigue siendo el registrado: misma
+// fecha, o misma longitud y mismo hash (un touch, una copia o una restauración no cambian nada).
+// Si solo cambió la fecha la guarda en *rec_mtime.
+static int huff_manifest_matches(const char* path, uint64_t size, int64_t mtime, uint64_t rec_size,
+                                 int64_t* rec_mtime, uint64_t rec_hash) {
+    if (size != rec_size) return 0;
+    if (mtime == *rec_mtime) return 1;
+    uint64_t hash;
+    if (huff_hash_file(path, &hash) != 0 || hash != rec_hash) return 0;
+    *rec_mtime = mtime;
+    return 1;
+}
+
+// Devuelve 1 si la salida de la entrada e existe y es la registrada.
+static int huff_manifest_output_matches(const char* path, HManifestEntry* e) {
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return 0;
+    return huff_manifest_matches(path, (uint64_t)st.st_size, huff_manifest_mtime(&st), e->out_size, &e->out_mtime,
+                                 e->out_hash);
+}
+
+// Devuelve 1 si path es el manifiesto de m o su temporal: mismo nombre y el directorio de path es
+// el directorio de salida (la entrada y la salida pueden ser el mismo directorio).
+static int huff_manifest_is_own_file(const HManifest* m, const char* path) {
+    const char* name = huff_manifest_name(path);
+    if (strcmp(name, HUFF_MANIFEST_NAME) != 0 && strcmp(name, HUFF_MANIFEST_TMP_NAME) != 0) return 0;
+    char dir[HUFF_PATH_MAX];
+    snprintf(dir, sizeof(dir), "%.*s", name > path ? (int)(name - path - 1) : 1, name > path ? path : ".");
+    struct stat st_dir, st_out;
+    return stat(dir, &st_dir) == 0 && stat(m->dir, &st_out) == 0 && st_dir.st_dev == st_out.st_dev &&
+           st_dir.st_ino == st_out.st_ino;
+}
+
+// Quita del lote los archivos sin cambios y limpia las salidas de los que ya no están.
+int huff_manifest_filter(HManifest* m, HBatch* batch) {
+    unsigned char* seen = (unsigned char*)calloc(m->n_entries ? m->n_entries : 1, 1);
+    if (seen == NULL) return -1;
+    size_t kept = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        HJob* job = &batch->jobs[i];
+        if (huff_manifest_is_own_file(m, job->input_path)) continue;
+        HManifestEntry* e = huff_manifest_find(m, m->n_entries, huff_manifest_name(job->input_path));
+        if (e != NULL) {
+            seen[e - m->entries] = 1;
+            if (!m->stale &&
+                huff_manifest_matches(job->input_path, (uint64_t)job->size, job->mtime, e->in_size, &e->in_mtime, e->in_hash) &&
+                huff_manifest_output_matches(job->output_path, e)) {
+                m->unchanged++;
+                continue;
+            }
+        }
+        if (kept != i) batch->jobs[kept] = *job;
+        kept++;
+    }
+    batch->count = kept;
+    // Las entradas que no aparecieron son archivos borrados del directorio de entrada. Su salida
+    // se borra solo si sigue siendo la que se escribió (no se pisa lo que otro haya dejado ahí).
+    for (size_t i = 0; i < m->n_entries; i++) {
+        if (seen[i]) continue;
+        HManifestEntry* e = &m->entries[i];
+        char path[HUFF_PATH_MAX];
+        int path_ok = snprintf(path, sizeof(path), "%s/%s", m->dir, e->name) < (int)sizeof(path);
+        if (path_ok && huff_manifest_output_matches(path, e) && unlink(path) == 0) m->removed++;
+        free(e->name);
+        e->name = NULL;
+    }
+    free(seen);
+    huff_manifest_compact(m);
+    return 0;
+}
+
+// Registra los trabajos terminados.
+int huff_manifest_update(HManifest* m, const HBatch* batch) {
+    size_t n_sorted = m->n_entries; // Las entradas nuevas se agregan al final, sin ordenar.
+    for (size_t i = 0; i < batch->count; i++) {
+        const HJob* job = &batch->jobs[i];
+        const char* name = huff_manifest_name(job->input_path);
+        HManifestEntry* e = huff_manifest_find(m, n_sorted, name);
+        struct stat st_in, st_out;
+        uint64_t in_hash, out_hash;
+        // Si la entrada cambió mientras se procesaba, la salida puede ser de la versión anterior:
+        // no se registra, y la próxima ejecución la vuelve a procesar.
+        int ok = job->result.status == 0 && stat(job->input_path, &st_in) == 0 &&
+                 (long long)st_in.st_size == job->size && huff_manifest_mtime(&st_in) == job->mtime &&
+                 stat(job->output_path, &st_out) == 0 &&
+                 huff_hash_file(job->input_path, &in_hash) == 0 && huff_hash_file(job->output_path, &out_hash) == 0;
+        if (!ok) {
+            if (e != NULL) {
+                free(e->name);
+                e->name = NULL;
+            }
+            continue;
+        }
+        if (e == NULL) {
+            e = huff_manifest_append(m, name);
+            if (e == NULL) return -1;
+        }
+        e->in_size = (uint64_t)st_in.st_size;
+        e->in_mtime = huff_manifest_mtime(&st_in);
+        e->in_hash = in_hash;
+        e->out_size = (uint64_t)st_out.st_size;
+        e->out_mtime = huff_manifest_mtime(&st_out);
+        e->out_hash = out_hash;
+    }
+    huff_manifest_compact(m);
+    m->stale = 0;
+    return 0;
+}
+
+// Escribe todo buf en un archivo nuevo y lo lleva al disco. Devuelve 0 o -1.
+static int huff_manifest_write_file(const char* path, const unsigned char* buf, size_t len) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, buf + done, len - done);
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    // Sin fsync, rename podría llegar al disco antes que el contenido.
+    int ret = fsync(fd);
+    if (close(fd) != 0) ret = -1;
+    return ret;
+}
+
+// Escribe el manifiesto en un temporal y lo renombra sobre el anterior.
+int huff_manifest_save(const HManifest* m) {
+    if (m->path[0] == '\0') return -1; // La ruta no cupo en huff_manifest_load.
+    size_t len = HUFF_MANIFEST_HEADER_SIZE + 8;
+    for (size_t i = 0; i < m->n_entries; i++) len += HUFF_MANIFEST_ENTRY_SIZE + strlen(m->entries[i].name);
+    unsigned char* buf = (unsigned char*)malloc(len);
+    if (buf == NULL) return -1;
+    memcpy(buf, HUFF_MANIFEST_MAGIC, HUFF_MANIFEST_MAGIC_LEN);
+    buf[4] = HUFF_MANIFEST_VERSION;
+    buf[5] = 0;
+    huff_put_le(buf + 6, 0, 2);
+    huff_put_le(buf + 8, m->opts_hash, 8);
+    huff_put_le(buf + 16, m->n_entries, 4);
+    size_t pos = HUFF_MANIFEST_HEADER_SIZE;
+    for (size_t i = 0; i < m->n_entries; i++) {
+        const HManifestEntry* e = &m->entries[i];
+        size_t name_len = strlen(e->name);
+        unsigned char* p = buf + pos;
+        huff_put_le(p, e->in_size, 8);
+        huff_put_le(p + 8, (uint64_t)e->in_mtime, 8);
+        huff_put_le(p + 16, e->in_hash, 8);
+        huff_put_le(p + 24, e->out_size, 8);
+        huff_put_le(p + 32, (uint64_t)e->out_mtime, 8);
+        huff_put_le(p + 40, e->out_hash, 8);
+        huff_put_le(p + 48, name_len, 2);
+        memcpy(p + HUFF_MANIFEST_ENTRY_SIZE, e->name, name_len);
+        pos += HUFF_MANIFEST_ENTRY_SIZE + name_len;
+    }
+    huff_put_le(buf + pos, huff_hash64(buf, pos, 0), 8);
+
+    char tmp[HUFF_PATH_MAX + sizeof(HUFF_MANIFEST_TMP_NAME)];
+    snprintf(tmp, sizeof(tmp), "%s/%s", m->dir, HUFF_MANIFEST_TMP_NAME);
+    int ret = huff_manifest_write_file(tmp, buf, len);
+    free(buf);
+    if (ret == 0) ret = rename(tmp, m->path);
+    if (ret != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    // El rename queda en el disco cuando se sincroniza el directorio.
+    int dir_fd = open(m->dir, O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return 0;
+}
+
+// Libera el manifiesto.
+void huff_manifest_free(HManifest* m) {
+    huff_manifest_clear(m);
+}
@@ -0,0 +1,96 @@
+#ifndef HUFF_MANIFEST_H
+#define HUFF_MANIFEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "huff_batch.h"
+#include "huff_options.h"
+
+// Manifiesto de un directorio de salida (--incremental): por cada archivo de entrada procesado
+// guarda el tamaño, la fecha de modificación y un hash del contenido de la entrada y de su
+// salida, más un hash de las opciones que cambian la salida. Con él, una nueva ejecución sobre el
+// mismo directorio solo procesa los archivos nuevos o modificados y borra las salidas de los
+// archivos que ya no están. Formato (enteros en little-endian):
+//
+//   magic       4 bytes  "HUFM"
+//   version     1 byte   HUFF_MANIFEST_VERSION
+//   flags       1 byte   0
+//   reservado   2 bytes  0
+//   opts_hash   8 bytes  hash de las opciones (huff_manifest_options_hash)
+//   n_entries   4 bytes
+//   entradas    ordenadas por nombre (bytes sin signo): in_size 8 bytes, in_mtime 8 bytes,
+//               in_hash 8 bytes, out_size 8 bytes, out_mtime 8 bytes, out_hash 8 bytes,
+//               name_len 2 bytes, nombre
+//   checksum    8 bytes  huff_hash64 de todos los bytes anteriores
+//
+// Las fechas están en nanosegundos. El manifiesto se escribe en un archivo temporal que luego
+// reemplaza al anterior con rename, así una ejecución interrumpida deja el manifiesto viejo.
+#define HUFF_MANIFEST_NAME ".huff_manifest"
+#define HUFF_MANIFEST_TMP_NAME HUFF_MANIFEST_NAME ".tmp"
+#define HUFF_MANIFEST_MAGIC "HUFM"
+#define HUFF_MANIFEST_MAGIC_LEN 4
+#define HUFF_MANIFEST_VERSION 1
+
+// Una entrada del manifiesto.
+struct huff_manifest_entry {
+	char*    name;      // Nombre del archivo, sin directorio (NULL = entrada borrada).
+	uint64_t in_size;   // Tamaño de la entrada.
+	int64_t  in_mtime;  // Fecha de modificación de la entrada.
+	uint64_t in_hash;   // Hash del contenido de la entrada.
+	uint64_t out_size;  // Tamaño de la salida.
+	int64_t  out_mtime; // Fecha de modificación de la salida.
+	uint64_t out_hash;  // Hash del contenido de la salida.
+};
+
+// Nombre corto para una entrada del manifiesto.
+typedef struct huff_manifest_entry HManifestEntry;
+
+// Manifiesto en memoria.
+struct huff_manifest {
+	char            dir[HUFF_PATH_MAX];  // Directorio de salida.
+	char            path[HUFF_PATH_MAX]; // Ruta del manifiesto en el directorio de salida.
+	uint64_t        opts_hash;           // Hash de las opciones de esta ejecución.
+	int             stale;               // 1 si el manifiesto leído es de otras opciones (se procesa todo).
+	HManifestEntry* entries;             // Entradas ordenadas por nombre.
+	size_t          n_entries;           // Número de entradas.
+	size_t          cap_entries;         // Capacidad de entries.
+	size_t          unchanged;           // Archivos que huff_manifest_filter quitó del lote.
+	size_t          removed;             // Salidas borradas porque su entrada ya no existe.
+};
+
+// Nombre corto para el manifiesto.
+typedef struct huff_manifest HManifest;
+
+// Función para calcular un hash rápido de 64 bits (XXH64) de len bytes.
+uint64_t huff_hash64(const void* data, size_t len, uint64_t seed);
+
+// Función para calcular el hash del contenido de un archivo. Devuelve 0 o -1 si no se puede leer.
+int huff_hash_file(const char* path, uint64_t* hash);
+
+// Función que devuelve el hash de las opciones que cambian la salida de un archivo (modo, formato,
+// longitud máxima, diccionario, backend...). Los hilos no cuentan: la salida es la misma.
+uint64_t huff_manifest_options_hash(int encode, const HOptions* opts);
+
+// Función para leer el manifiesto de output_dir. Si no existe, no es válido o es de otras opciones
+// se empieza como si todo hubiera cambiado (en el último caso se conservan las entradas para
+// borrar las salidas de los archivos que ya no están). Devuelve 1 si se leyó un manifiesto
+// válido de las mismas opciones, o 0.
+int huff_manifest_load(HManifest* m, const char* output_dir, uint64_t opts_hash);
+
+// Función para quitar del lote los archivos sin cambios (misma entrada y la salida intacta) y
+// borrar las salidas, y las entradas del manifiesto, de los archivos que ya no están. Si la fecha
+// cambió pero el tamaño no, se compara el hash del contenido. Si la entrada es el mismo directorio
+// de salida, también quita el manifiesto y su temporal. Devuelve 0 o -1 si no hay memoria.
+int huff_manifest_filter(HManifest* m, HBatch* batch);
+
+// Función para registrar los trabajos del lote que terminaron bien (y olvidar los que fallaron).
+// Devuelve 0 o -1 si no hay memoria.
+int huff_manifest_update(HManifest* m, const HBatch* batch);
+
+// Función para escribir el manifiesto de forma atómica. Devuelve 0 o -1.
+int huff_manifest_save(const HManifest* m);
+
+// Función para liberar el manifiesto.
+void huff_manifest_free(HManifest* m);
+
+#endif // !HUFF_MANIFEST_H
@@ -0,0 +1,51 @@
+#ifndef HUFF_OPTIONS_H
+#define HUFF_OPTIONS_H
+
+#include <stddef.h>
+#include "huff_const.h"
+
+struct huff_dict;
+
+// Codificador de entropía del formato de un solo bloque.
+enum huff_backend {
+	HUFF_BACKEND_HUFFMAN, // Códigos de Huffman canónicos.
+	HUFF_BACKEND_ANS,     // rANS (huff_ans.h).
+	HUFF_BACKEND_AUTO,    // El que produzca el archivo más pequeño según el histograma.
+	HUFF_BACKEND_ORDER1   // Códigos de Huffman de orden 1 (huff_order1.h).
+};
+
+// Opciones de codificación/decodificación de un archivo.
+// Se pasan por puntero a las interfaces reentrantes; NULL equivale a los valores por defecto.
+struct huff_options {
+	int threads; // Hilos para codificar un único archivo o decodificar uno por bloques (1 = secuencial).
+	int legacy;  // 1 para usar el formato anterior: flujo de bits más codebook de texto.
+	int max_code_len; // Longitud máxima de los códigos (0 = HUFF_MAX_LEN - 1).
+	int verbose; // 1 para escribir en stderr las mezclas del árbol y los códigos de cada archivo.
+	int block_size; // Bytes por bloque del formato por bloques (0 = los archivos usan el formato de un solo bloque).
+	int streams; // Flujos de bits intercalados por bloque en el formato por bloques (0 o 1 = uno solo).
+	int index_interval; // Bytes entre puntos de control del índice (0 = HUFF_INDEX_INTERVAL, < 0 = solo inicios de bloque).
+	const struct huff_dict* dict; // Diccionario compartido para el formato de un solo bloque (NULL = tabla por archivo).
+	int dict_threshold; // Porcentaje que puede crecer la salida con el diccionario (< 0 = siempre).
+	int stats; // 1 para medir las fases y la entropía de cada archivo en su HFileResult.
+	int backend; // Codificador de entropía (HUFF_BACKEND_*); solo el formato de un solo bloque sin diccionario.
+};
+
+// Nombre corto para las opciones.
+typedef struct huff_options HOptions;
+
+// Función para inicializar las opciones con sus valores por defecto.
+static inline void huff_options_default(HOptions* opts) {
+	opts->threads = 1;
+	opts->legacy = 0;
+	opts->max_code_len = 0;
+	opts->verbose = 0;
+	opts->block_size = 0;
+	opts->streams = 0;
+	opts->index_interval = 0;
+	opts->dict = NULL;
+	opts->dict_threshold = HUFF_DICT_THRESHOLD;
+	opts->stats = 0;
+	opts->backend = HUFF_BACKEND_HUFFMAN;
+}
+
+#endif // !HUFF_OPTIONS_H
@@ -0,0 +1,582 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "huff_order1.h"
+#include "huff_format.h"
+#include "huff_encode.h"
+
+// Vueltas de refinamiento de los grupos (cada contexto pasa al grupo donde sus bytes cuestan menos).
+#ifndef HUFF_O1_ITERATIONS
+#define HUFF_O1_ITERATIONS 8
+#endif
+
+// Cuenta los pares (byte anterior, byte).
+void huff_o1_histogram(const unsigned char* data, size_t len, uint64_t* pairs) {
+    if (len == 0) return;
+    pairs[data[0]]++; // El primer byte tiene el contexto 0.
+    for (size_t i = 1; i < len; i++) {
+        pairs[((size_t)data[i - 1] << 8) | data[i]]++;
+    }
+}
+
+// Bytes de la tabla de un grupo con n_symbols símbolos en el encabezado.
+static size_t huff_o1_table_bytes(int n_symbols) {
+    return 1 + (2 * n_symbols < HUFF_MAX_SYMBOLS / 2 ? 2 * (size_t)n_symbols : HUFF_MAX_SYMBOLS / 2);
+}
+
+// Bits de un grupo con el histograma counts: la entropía de sus bytes más su tabla en el encabezado.
+static double huff_o1_cluster_bits(const uint64_t* counts) {
+    uint64_t total = 0;
+    double sum = 0.0;
+    int n_symbols = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (counts[s] == 0) continue;
+        total += counts[s];
+        sum += (double)counts[s] * log2((double)counts[s]);
+        n_symbols++;
+    }
+    if (total == 0) return 0.0;
+    return (double)total * log2((double)total) - sum + 8.0 * (double)huff_o1_table_bytes(n_symbols);
+}
+
+// Bits del grupo que resulta de unir a y b.
+static double huff_o1_merged_bits(const uint64_t* a, const uint64_t* b) {
+    uint64_t merged[HUFF_MAX_SYMBOLS];
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) merged[s] = a[s] + b[s];
+    return huff_o1_cluster_bits(merged);
+}
+
+// Suma al histograma de cada grupo los pares de sus contextos.
+static void huff_o1_cluster_counts(const uint64_t* pairs, const int* assign, uint64_t (*counts)[HUFF_MAX_SYMBOLS]) {
+    memset(counts, 0, sizeof(uint64_t) * HUFF_O1_CLUSTERS * HUFF_MAX_SYMBOLS);
+    for (int c = 0; c < HUFF_MAX_SYMBOLS; c++) {
+        if (assign[c] < 0) continue;
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) counts[assign[c]][s] += pairs[(size_t)c * HUFF_MAX_SYMBOLS + s];
+    }
+}
+
+// Agrupa los contextos y calcula las longitudes de cada grupo.
+void huff_o1_build(const uint64_t* pairs, int max_clusters, HO1Model* model) {
+    static uint64_t zero[HUFF_MAX_SYMBOLS];
+    memset(model, 0, sizeof(*model));
+    if (max_clusters > HUFF_O1_CLUSTERS) max_clusters = HUFF_O1_CLUSTERS;
+    if (max_clusters < 1) max_clusters = 1;
+
+    // Contextos que aparecen, del más frecuente al menos frecuente.
+    uint64_t ctx_total[HUFF_MAX_SYMBOLS];
+    int order[HUFF_MAX_SYMBOLS];
+    int n_active = 0;
+    for (int c = 0; c < HUFF_MAX_SYMBOLS; c++) {
+        ctx_total[c] = 0;
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) ctx_total[c] += pairs[(size_t)c * HUFF_MAX_SYMBOLS + s];
+        if (ctx_total[c] == 0) continue;
+        int k = n_active++;
+        while (k > 0 && ctx_total[order[k - 1]] < ctx_total[c]) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = c;
+    }
+    if (n_active == 0) return; // Entrada vacía: sin grupos.
+    int k = n_active < max_clusters ? n_active : max_clusters;
+
+    // Semillas: el contexto más frecuente y luego, uno a uno, el contexto cuyos bytes más bits
+    // perderían en el grupo de la semilla más parecida (así los grupos empiezan bien separados).
+    int assign[HUFF_MAX_SYMBOLS];
+    uint64_t counts[HUFF_O1_CLUSTERS][HUFF_MAX_SYMBOLS];
+    double far[HUFF_MAX_SYMBOLS];
+    for (int c = 0; c < HUFF_MAX_SYMBOLS; c++) {
+        assign[c] = -1;
+        far[c] = 1e300;
+    }
+    int seed = order[0];
+    for (int j = 0; j < k; j++) {
+        assign[seed] = j;
+        const uint64_t* srow = pairs + (size_t)seed * HUFF_MAX_SYMBOLS;
+        double denom = log2((double)ctx_total[seed] + 0.5 * HUFF_MAX_SYMBOLS);
+        int next = -1;
+        for (int i = 0; i < n_active; i++) {
+            int c = order[i];
+            if (assign[c] >= 0) continue;
+            const uint64_t* row = pairs + (size_t)c * HUFF_MAX_SYMBOLS;
+            double own = log2((double)ctx_total[c]), d = 0.0;
+            for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+                if (row[s]) d += (double)row[s] * (denom - log2((double)srow[s] + 0.5) - own + log2((double)row[s]));
+            }
+            if (d < far[c]) far[c] = d;
+            if (next < 0 || far[c] > far[next]) next = c;
+        }
+        if (next < 0) break;
+        seed = next;
+    }
+    if (k == 1) {
+        for (int i = 0; i < n_active; i++) assign[order[i]] = 0;
+    }
+    huff_o1_cluster_counts(pairs, assign, counts);
+    for (int iter = 0; iter < HUFF_O1_ITERATIONS && k > 1; iter++) {
+        // Costo de cada byte en cada grupo, suavizado para que un byte que el grupo todavía no
+        // tiene cueste mucho pero no infinito.
+        double cost[HUFF_O1_CLUSTERS][HUFF_MAX_SYMBOLS];
+        for (int j = 0; j < k; j++) {
+            uint64_t total = 0;
+            for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) total += counts[j][s];
+            double denom = log2((double)total + 0.5 * HUFF_MAX_SYMBOLS);
+            for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) cost[j][s] = denom - log2((double)counts[j][s] + 0.5);
+        }
+        int changed = 0;
+        for (int i = 0; i < n_active; i++) {
+            int c = order[i];
+            const uint64_t* row = pairs + (size_t)c * HUFF_MAX_SYMBOLS;
+            int best = assign[c];
+            double best_bits = 0.0;
+            for (int j = 0; j < k; j++) {
+                double bits = 0.0;
+                for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+                    if (row[s]) bits += (double)row[s] * cost[j][s];
+                }
+                if (j == 0 || bits < best_bits) {
+                    best = j;
+                    best_bits = bits;
+                }
+            }
+            if (best != assign[c]) changed = 1;
+            assign[c] = best;
+        }
+        huff_o1_cluster_counts(pairs, assign, counts);
+        if (!changed) break;
+    }
+
+    // Une los dos grupos que menos pierden mientras la unión ahorre bits (una tabla, y el mapa de
+    // grupos al quedar uno solo). merge[a][b] guarda la diferencia de bits de unir a y b.
+    double bits[HUFF_O1_CLUSTERS];
+    double merge[HUFF_O1_CLUSTERS][HUFF_O1_CLUSTERS];
+    int live[HUFF_O1_CLUSTERS];
+    int n_live = 0;
+    for (int j = 0; j < k; j++) {
+        bits[j] = huff_o1_cluster_bits(counts[j]);
+        live[j] = memcmp(counts[j], zero, sizeof(zero)) != 0;
+        n_live += live[j];
+    }
+    for (int a = 0; a < k; a++) {
+        for (int b = a + 1; b < k; b++) {
+            if (live[a] && live[b]) merge[a][b] = huff_o1_merged_bits(counts[a], counts[b]) - bits[a] - bits[b];
+        }
+    }
+    while (n_live > 1) {
+        int best_a = -1, best_b = -1;
+        double best = 0.0;
+        for (int a = 0; a < k; a++) {
+            for (int b = a + 1; b < k; b++) {
+                if (!live[a] || !live[b]) continue;
+                double delta = merge[a][b] - (n_live == 2 ? 8.0 * HUFF_MAX_SYMBOLS / 2 : 0.0);
+                if (best_a < 0 || delta < best) {
+                    best_a = a;
+                    best_b = b;
+                    best = delta;
+                }
+            }
+        }
+        if (best >= 0.0) break;
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) counts[best_a][s] += counts[best_b][s];
+        for (int c = 0; c < HUFF_MAX_SYMBOLS; c++) {
+            if (assign[c] == best_b) assign[c] = best_a;
+        }
+        bits[best_a] = huff_o1_cluster_bits(counts[best_a]);
+        live[best_b] = 0;
+        n_live--;
+        for (int j = 0; j < k; j++) {
+            if (j == best_a || !live[j]) continue;
+            int a = j < best_a ? j : best_a, b = j < best_a ? best_a : j;
+            merge[a][b] = huff_o1_merged_bits(counts[a], counts[b]) - bits[a] - bits[b];
+        }
+    }
+
+    // Numera los grupos que quedan y arma sus códigos. Los contextos que no aparecen van al grupo 0.
+    int renum[HUFF_O1_CLUSTERS];
+    for (int j = 0; j < k; j++) renum[j] = live[j] ? model->n_clusters++ : -1;
+    for (int c = 0; c < HUFF_MAX_SYMBOLS; c++) model->cluster[c] = assign[c] < 0 ? 0 : (unsigned char)renum[assign[c]];
+    HTreeArena arena;
+    for (int j = 0; j < k; j++) {
+        if (live[j]) huff_build_code_lengths(counts[j], HUFF_O1_MAX_LEN, &arena, model->lengths[renum[j]], NULL);
+    }
+}
+
+// Bits del payload con el modelo.
+double huff_o1_cost(const uint64_t* pairs, const HO1Model* model) {
+    double bits = 0.0;
+    for (int c = 0; c < HUFF_MAX_SYMBOLS; c++) {
+        const unsigned char* lengths = model->lengths[model->cluster[c]];
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) bits += (double)pairs[(size_t)c * HUFF_MAX_SYMBOLS + s] * lengths[s];
+    }
+    return bits;
+}
+
+// Escribe el encabezado.
+size_t huff_o1_write_header(const HO1Model* model, uint64_t orig_len, unsigned char* dst) {
+    size_t pos = 0;
+    memcpy(dst, HUFF_MAGIC, HUFF_MAGIC_LEN);
+    pos += HUFF_MAGIC_LEN;
+    dst[pos++] = HUFF_O1_VERSION;
+    dst[pos++] = 0;
+    huff_put_le(dst + pos, orig_len, 8);
+    pos += 8;
+    dst[pos++] = (unsigned char)model->n_clusters;
+    if (model->n_clusters > 1) {
+        for (int c = 0; c < HUFF_MAX_SYMBOLS; c += 2) {
+            dst[pos++] = (unsigned char)(model->cluster[c] | (model->cluster[c + 1] << 4));
+        }
+    }
+    for (int j = 0; j < model->n_clusters; j++) {
+        const unsigned char* lengths = model->lengths[j];
+        int n_symbols = 0;
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) n_symbols += lengths[s] != 0;
+        dst[pos++] = (unsigned char)(n_symbols - 1);
+        if (2 * n_symbols < HUFF_MAX_SYMBOLS / 2) {
+            for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+                if (lengths[s] == 0) continue;
+                dst[pos++] = (unsigned char)s;
+                dst[pos++] = lengths[s];
+            }
+        } else {
+            for (int s = 0; s < HUFF_MAX_SYMBOLS; s += 2) dst[pos++] = (unsigned char)(lengths[s] | (lengths[s + 1] << 4));
+        }
+    }
+    return pos;
+}
+
+// Lee el encabezado.
+long huff_o1_read_header(const unsigned char* src, size_t len, HO1Model* model, uint64_t* orig_len) {
+    memset(model, 0, sizeof(*model));
+    size_t pos = HUFF_MAGIC_LEN + 2;
+    if (huff_container_version(src, len) != HUFF_O1_VERSION || len < pos + 8 + 1) return -1;
+    *orig_len = huff_get_le(src + pos, 8);
+    pos += 8;
+    model->n_clusters = src[pos++];
+    if (model->n_clusters > HUFF_O1_CLUSTERS || (model->n_clusters == 0 && *orig_len != 0)) return -1;
+    if (model->n_clusters > 1) {
+        if (len - pos < HUFF_MAX_SYMBOLS / 2) return -1;
+        for (int c = 0; c < HUFF_MAX_SYMBOLS; c += 2) {
+            model->cluster[c] = src[pos] & 15;
+            model->cluster[c + 1] = src[pos] >> 4;
+            if (model->cluster[c] >= model->n_clusters || model->cluster[c + 1] >= model->n_clusters) return -1;
+            pos++;
+        }
+    }
+    for (int j = 0; j < model->n_clusters; j++) {
+        unsigned char* lengths = model->lengths[j];
+        if (len - pos < 1) return -1;
+        int n_symbols = src[pos++] + 1;
+        int found = 0;
+        if (2 * n_symbols < HUFF_MAX_SYMBOLS / 2) {
+            if (len - pos < 2 * (size_t)n_symbols) return -1;
+            for (int i = 0; i < n_symbols; i++) {
+                found += lengths[src[pos]] == 0;
+                lengths[src[pos]] = src[pos + 1];
+                if (src[pos + 1] == 0 || src[pos + 1] > HUFF_O1_MAX_LEN) return -1;
+                pos += 2;
+            }
+        } else {
+            if (len - pos < HUFF_MAX_SYMBOLS / 2) return -1;
+            for (int s = 0; s < HUFF_MAX_SYMBOLS; s += 2) {
+                lengths[s] = src[pos] & 15;
+                lengths[s + 1] = src[pos] >> 4;
+                if (lengths[s] > HUFF_O1_MAX_LEN || lengths[s + 1] > HUFF_O1_MAX_LEN) return -1;
+                found += (lengths[s] != 0) + (lengths[s + 1] != 0);
+                pos++;
+            }
+        }
+        if (found != n_symbols) return -1;
+    }
+    return (long)pos;
+}
+
+// Escribe los 8 bytes del acumulador en big-endian (el primer bit emitido queda primero).
+static inline void huff_o1_store_be64(unsigned char* dst, uint64_t value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+    memcpy(dst, &value, sizeof(value));
+#else
+    for (int i = 0; i < 8; i++) dst[i] = (unsigned char)(value >> (56 - 8 * i));
+#endif
+}
+
+// Lee 8 bytes en big-endian.
+static inline uint64_t huff_o1_load_be64(const unsigned char* src) {
+    uint64_t value;
+    memcpy(&value, src, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// Arma el código canónico de cada símbolo en cada grupo: (bits << 4) | longitud.
+static void huff_o1_pack_codes(const HO1Model* model, uint32_t* codes) {
+    memset(codes, 0, sizeof(uint32_t) * HUFF_O1_CLUSTERS * HUFF_MAX_SYMBOLS);
+    for (int j = 0; j < model->n_clusters; j++) {
+        uint64_t bits[HUFF_MAX_SYMBOLS];
+        huff_canonical_codes(model->lengths[j], bits);
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+            codes[j * HUFF_MAX_SYMBOLS + s] = (uint32_t)(bits[s] << 4) | model->lengths[j][s];
+        }
+    }
+}
+
+// Agrega al acumulador el código de data[i] con el contexto prev.
+#define HUFF_O1_PUT(prev, i)                                                              \
+    do {                                                                                  \
+        uint32_t c_ = codes[((uint32_t)cluster[prev] << 8) | data[i]];                    \
+        acc |= (uint64_t)(c_ >> 4) << (64 - bits - (int)(c_ & 15));                       \
+        bits += (int)(c_ & 15);                                                           \
+    } while (0)
+
+// Codifica los bytes [start, start + n) de data (el contexto de data[start] es data[start - 1]).
+// El buffer del escritor necesita HUFF_ENCODE_BOUND(n, HUFF_O1_MAX_LEN) bytes libres. El acumulador
+// vive en variables locales: las escrituras en out podrían pisar w y obligarían a releerlo.
+static void huff_o1_encode_symbols(HBitWriter* w, const unsigned char* data, size_t start, size_t n,
+                                   const uint32_t* codes, const unsigned char* cluster) {
+    uint64_t acc = w->acc;
+    int bits = w->bits;
+    unsigned char* out = w->out;
+    size_t pos = w->pos;
+    size_t i = start, end = start + n;
+    if (i == 0 && i < end) {
+        HUFF_O1_PUT(0, 0);
+        i++;
+    }
+    // Tras vaciar quedan como mucho 7 bits, así que caben 4 códigos de HUFF_O1_MAX_LEN bits.
+    for (; i + 4 <= end; i += 4) {
+        HUFF_O1_PUT(data[i - 1], i);
+        HUFF_O1_PUT(data[i], i + 1);
+        HUFF_O1_PUT(data[i + 1], i + 2);
+        HUFF_O1_PUT(data[i + 2], i + 3);
+        huff_o1_store_be64(out + pos, acc);
+        pos += (size_t)(bits >> 3);
+        acc <<= bits & ~7;
+        bits &= 7;
+    }
+    for (; i < end; i++) {
+        HUFF_O1_PUT(data[i - 1], i);
+        huff_o1_store_be64(out + pos, acc);
+        pos += (size_t)(bits >> 3);
+        acc <<= bits & ~7;
+        bits &= 7;
+    }
+    w->acc = acc;
+    w->bits = bits;
+    w->pos = pos;
+}
+
+// Codifica en un buffer acotado, como huff_encode_symbols_to: directamente en dst mientras sobra
+// lugar y los últimos símbolos a través de un buffer pequeño que se copia solo si cabe.
+size_t huff_o1_encode_to(const unsigned char* data, size_t len, const HO1Model* model, unsigned char* dst, size_t cap) {
+    uint32_t codes[HUFF_O1_CLUSTERS * HUFF_MAX_SYMBOLS];
+    unsigned char tail[64];
+    huff_o1_pack_codes(model, codes);
+    HBitWriter w = {0, 0, dst, 0};
+    size_t pos = 0, i = 0;
+    while (i < len) {
+        size_t room = cap - pos;
+        size_t n = room > 16 ? (room - 16) * 8 / HUFF_O1_MAX_LEN : 0;
+        if (n > 0) {
+            if (n > len - i) n = len - i;
+            w.out = dst + pos;
+            w.pos = 0;
+            huff_o1_encode_symbols(&w, data, i, n, codes, model->cluster);
+        } else {
+            n = (sizeof(tail) - 16) * 8 / HUFF_O1_MAX_LEN;
+            if (n > len - i) n = len - i;
+            w.out = tail;
+            w.pos = 0;
+            huff_o1_encode_symbols(&w, data, i, n, codes, model->cluster);
+            if (w.pos > room) return (size_t)-1;
+            memcpy(dst + pos, tail, w.pos);
+        }
+        pos += w.pos; // Los bits pendientes siguen en el acumulador.
+        i += n;
+    }
+    if (w.bits > 0) {
+        if (pos == cap) return (size_t)-1;
+        w.out = dst + pos;
+        w.pos = 0;
+        huff_bit_writer_finish(&w);
+        pos += w.pos;
+    }
+    return pos;
+}
+
+// Escribe un archivo completo, codificando en trozos de HUFF_IO_BUFFER_SIZE bytes.
+int huff_o1_encode_file(const unsigned char* data, size_t len, const HO1Model* model, FILE* f_out) {
+    unsigned char header[HUFF_O1_HEADER_MAX_SIZE];
+    size_t header_len = huff_o1_write_header(model, (uint64_t)len, header);
+    if (fwrite(header, 1, header_len, f_out) != header_len) return -1;
+    uint32_t codes[HUFF_O1_CLUSTERS * HUFF_MAX_SYMBOLS];
+    huff_o1_pack_codes(model, codes);
+    unsigned char* out = (unsigned char*)malloc(HUFF_ENCODE_BOUND(HUFF_IO_BUFFER_SIZE, HUFF_O1_MAX_LEN));
+    if (out == NULL) return -1;
+    HBitWriter w = {0, 0, out, 0};
+    int ret = 0;
+    for (size_t off = 0; off < len && ret == 0; off += HUFF_IO_BUFFER_SIZE) {
+        size_t n = len - off < HUFF_IO_BUFFER_SIZE ? len - off : HUFF_IO_BUFFER_SIZE;
+        huff_o1_encode_symbols(&w, data, off, n, codes, model->cluster);
+        if (fwrite(out, 1, w.pos, f_out) != w.pos) ret = -1;
+        w.pos = 0; // Los bits pendientes siguen en el acumulador.
+    }
+    huff_bit_writer_finish(&w);
+    if (ret == 0 && fwrite(out, 1, w.pos, f_out) != w.pos) ret = -1;
+    free(out);
+    return ret;
+}
+
+// Arma las tablas del decodificador. Primero cada entrada recibe el símbolo de su prefijo; luego
+// se le encadenan los símbolos siguientes, cada uno buscado en la tabla del grupo del anterior.
+int huff_o1_decoder_table(HO1Decoder* dec, const HO1Model* model) {
+    const int table_bits = HUFF_O1_MAX_LEN;
+    const size_t mask = HUFF_O1_TABLE_SIZE - 1;
+    memcpy(dec->cluster, model->cluster, sizeof(dec->cluster));
+    for (int j = 0; j < model->n_clusters; j++) {
+        uint64_t codes[HUFF_MAX_SYMBOLS];
+        if (huff_canonical_codes(model->lengths[j], codes) != 0) return -1;
+        memset(dec->table[j], 0, sizeof(dec->table[j]));
+        for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+            int len = model->lengths[j][s];
+            if (len == 0) continue;
+            if (len > table_bits) return -1;
+            size_t first = (size_t)codes[s] << (table_bits - len);
+            for (size_t k = 0; k < ((size_t)1 << (table_bits - len)); k++) {
+                dec->table[j][first + k].symbols[0] = (unsigned char)s;
+                dec->table[j][first + k].first_bits = (unsigned char)len;
+            }
+        }
+    }
+    for (int j = 0; j < model->n_clusters; j++) {
+        for (size_t i = 0; i < HUFF_O1_TABLE_SIZE; i++) {
+            struct huff_o1_entry* e = &dec->table[j][i];
+            if (e->first_bits == 0) continue; // Prefijo que no corresponde a ningún código.
+            int used = e->first_bits;
+            int cur = dec->cluster[e->symbols[0]];
+            e->n_symbols = 1;
+            while (e->n_symbols < HUFF_O1_MAX_SYMS && used < table_bits) {
+                const struct huff_o1_entry* next = &dec->table[cur][(i << used) & mask];
+                if (next->first_bits == 0 || used + next->first_bits > table_bits) break;
+                e->symbols[e->n_symbols++] = next->symbols[0];
+                used += next->first_bits;
+                cur = dec->cluster[next->symbols[0]];
+            }
+            e->n_bits = (unsigned char)used;
+            e->next = (unsigned char)cur;
+        }
+    }
+    return 0;
+}
+
+// Empieza a decodificar un payload.
+void huff_o1_decoder_start(HO1Decoder* dec, const unsigned char* payload, size_t len) {
+    dec->in = payload;
+    dec->pos = 0;
+    dec->bit_end = (uint64_t)len * 8;
+    dec->cur = dec->cluster[0];
+}
+
+// Lee los 64 bits siguientes sin pasar del final del payload (completa con ceros).
+static inline uint64_t huff_o1_peek(const unsigned char* in, uint64_t pos, uint64_t bit_end) {
+    size_t byte = (size_t)(pos >> 3), end = (size_t)((bit_end + 7) >> 3);
+    uint64_t value = 0;
+    for (int k = 0; k < 8; k++) value = (value << 8) | (byte + (size_t)k < end ? in[byte + (size_t)k] : 0);
+    return value << (pos & 7);
+}
+
+// Decodifica los n símbolos siguientes. Cada consulta emite hasta HUFF_O1_MAX_SYMS símbolos y deja
+// el grupo siguiente en la propia entrada, así la tabla que se usa después no espera a buscar el
+// grupo del último símbolo. El estado vive en variables locales (out puede apuntar a cualquier cosa).
+int huff_o1_decode(HO1Decoder* dec, unsigned char* out, size_t n) {
+    const unsigned char* in = dec->in;
+    uint64_t pos = dec->pos;
+    const uint64_t bit_end = dec->bit_end;
+    int cur = dec->cur;
+    size_t i = 0;
+    int ret = 0;
+    // Con 64 bits por delante la lectura de 8 bytes no sale del payload y deja al menos 57 bits válidos.
+    while (i + HUFF_O1_MAX_SYMS <= n && bit_end - pos >= 64) {
+        uint64_t bits = huff_o1_load_be64(in + (pos >> 3)) << (pos & 7);
+        const struct huff_o1_entry* e = &dec->table[cur][bits >> (64 - HUFF_O1_MAX_LEN)];
+        if (e->n_symbols == 0) {
+            ret = -1;
+            break;
+        }
+        memcpy(out + i, e->symbols, HUFF_O1_MAX_SYMS);
+        i += e->n_symbols;
+        pos += e->n_bits;
+        cur = e->next;
+    }
+    // Final: un símbolo por consulta, sin leer fuera del payload.
+    while (i < n && ret == 0) {
+        uint64_t bits = huff_o1_peek(in, pos, bit_end);
+        const struct huff_o1_entry* e = &dec->table[cur][bits >> (64 - HUFF_O1_MAX_LEN)];
+        if (e->first_bits == 0 || e->first_bits > bit_end - pos) {
+            ret = -1;
+            break;
+        }
+        out[i++] = e->symbols[0];
+        pos += e->first_bits;
+        cur = dec->cluster[e->symbols[0]];
+    }
+    dec->pos = pos;
+    dec->cur = cur;
+    return ret;
+}
+
+// Decodifica un rango de un archivo en memoria, en trozos de HUFF_IO_BUFFER_SIZE bytes.
+int huff_o1_decode_file(const unsigned char* in, size_t in_len, uint64_t offset, uint64_t length,
+                        FILE* f_out, HFileResult* res) {
+    HO1Model model;
+    uint64_t orig_len = 0;
+    long header_len = huff_o1_read_header(in, in_len, &model, &orig_len);
+    if (header_len < 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid header");
+        return -1;
+    }
+    if (offset > orig_len) {
+        snprintf(res->msg, sizeof(res->msg), "offset beyond end of file");
+        return -1;
+    }
+    uint64_t end = orig_len - offset < length ? orig_len : offset + length;
+    if (orig_len == 0) return 0;
+    // Cada símbolo ocupa al menos un bit: un orig_len mayor es un encabezado dañado.
+    if (orig_len / 8 > in_len - (size_t)header_len) {
+        snprintf(res->msg, sizeof(res->msg), "invalid length");
+        return -1;
+    }
+    HO1Decoder* dec = (HO1Decoder*)malloc(sizeof(HO1Decoder));
+    unsigned char* out = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    int ret = -1;
+    if (dec == NULL || out == NULL) {
+        snprintf(res->msg, sizeof(res->msg), "out of memory");
+    } else if (huff_o1_decoder_table(dec, &model) != 0) {
+        snprintf(res->msg, sizeof(res->msg), "invalid code lengths");
+    } else {
+        // Sin puntos de control: un rango se decodifica desde el principio.
+        huff_o1_decoder_start(dec, in + header_len, in_len - (size_t)header_len);
+        uint64_t done = 0;
+        ret = 0;
+        while (done < end && ret == 0) {
+            size_t n = end - done < HUFF_IO_BUFFER_SIZE ? (size_t)(end - done) : HUFF_IO_BUFFER_SIZE;
+            if (huff_o1_decode(dec, out, n) != 0) {
+                snprintf(res->msg, sizeof(res->msg), "truncated or corrupt data");
+                ret = -1;
+            } else if (done + n > offset) {
+                size_t skip = done < offset ? (size_t)(offset - done) : 0;
+                if (fwrite(out + skip, 1, n - skip, f_out) != n - skip) {
+                    snprintf(res->msg, sizeof(res->msg), "cannot write output");
+                    ret = -1;
+                } else {
+                    res->bytes_out += n - skip;
+                }
+            }
+            done += n;
+        }
+    }
+    free(out);
+    free(dec);
+    return ret;
+}
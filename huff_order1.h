@@ -0,0 +1,114 @@
+#ifndef HUFF_ORDER1_H
+#define HUFF_ORDER1_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_const.h"
+#include "huff_result.h"
+
+// Códigos de Huffman de orden 1: el código de cada byte depende del byte anterior. En texto la
+// letra siguiente depende mucho de la anterior (después de 'q' casi siempre viene 'u'), y una sola
+// tabla para los 256 contextos desperdicia esa información. Guardar una tabla por contexto ocuparía
+// demasiado en el encabezado, así que los contextos con distribuciones parecidas se agrupan en
+// como mucho HUFF_O1_CLUSTERS grupos, con una tabla por grupo armada con el histograma de pares.
+// Los códigos se limitan a HUFF_O1_MAX_LEN bits: cada grupo se decodifica con una sola tabla de
+// 2^HUFF_O1_MAX_LEN entradas que emite varios símbolos por consulta y ya indica el grupo siguiente.
+//
+// Formato del archivo (versión HUFF_O1_VERSION del contenedor de huff_format.h, little-endian):
+//
+//   magic        4 bytes  "HUFZ"
+//   version      1 byte   HUFF_O1_VERSION
+//   flags        1 byte   0
+//   orig_len     8 bytes  longitud del archivo original
+//   n_clusters   1 byte   grupos de contextos (1..HUFF_O1_CLUSTERS)
+//   grupos       solo con n_clusters > 1: 128 bytes, el grupo de cada byte anterior en 4 bits
+//                (el contexto par en los 4 bits bajos)
+//   tablas       por grupo: n_symbols - 1 (1 byte) y, si 2 * n_symbols < 128, n_symbols pares
+//                (símbolo, longitud); si no, 128 bytes con la longitud de cada símbolo en 4 bits
+//   payload      flujo de bits con los códigos canónicos de cada grupo (el bit más significativo
+//                primero); el primer byte usa el grupo del contexto 0
+#define HUFF_O1_TABLE_SIZE (1 << HUFF_O1_MAX_LEN)
+
+// Tamaño máximo del encabezado.
+#define HUFF_O1_HEADER_MAX_SIZE (4 + 1 + 1 + 8 + 1 + 128 + HUFF_O1_CLUSTERS * (1 + 128))
+
+// Símbolos que puede emitir una consulta a la tabla de un grupo.
+#define HUFF_O1_MAX_SYMS 3
+
+// Modelo de orden 1: el grupo de cada contexto y las longitudes de los códigos de cada grupo.
+struct huff_o1_model {
+	int           n_clusters;                                    // Grupos usados.
+	unsigned char cluster[HUFF_MAX_SYMBOLS];                     // Grupo de cada byte anterior.
+	unsigned char lengths[HUFF_O1_CLUSTERS][HUFF_MAX_SYMBOLS];   // Longitud del código de cada símbolo en cada grupo.
+};
+
+// Nombre corto para el modelo de orden 1.
+typedef struct huff_o1_model HO1Model;
+
+// Entrada de la tabla de un grupo: los símbolos cuyos códigos caben en HUFF_O1_MAX_LEN bits, cada
+// uno decodificado con la tabla del grupo del anterior.
+struct huff_o1_entry {
+	unsigned char symbols[HUFF_O1_MAX_SYMS]; // Símbolos decodificados.
+	unsigned char n_symbols;                 // Cantidad de símbolos (0 = código inválido).
+	unsigned char n_bits;                    // Bits que consumen todos los símbolos.
+	unsigned char first_bits;                // Bits que consume solo el primer símbolo.
+	unsigned char next;                      // Grupo del último símbolo (el contexto siguiente).
+};
+
+// Decodificador de un payload de orden 1.
+struct huff_o1_decoder {
+	const unsigned char* in;      // Payload.
+	uint64_t             pos;     // Bits consumidos.
+	uint64_t             bit_end; // Bits del payload.
+	int                  cur;     // Grupo del símbolo siguiente.
+	unsigned char        cluster[HUFF_MAX_SYMBOLS];                    // Grupo de cada contexto.
+	struct huff_o1_entry table[HUFF_O1_CLUSTERS][HUFF_O1_TABLE_SIZE]; // Tabla de cada grupo.
+};
+
+// Nombre corto para el decodificador de orden 1.
+typedef struct huff_o1_decoder HO1Decoder;
+
+// Función para contar los pares (byte anterior, byte) de len bytes. pairs tiene 256 * 256 contadores
+// (el par de contexto c y símbolo s en pairs[c * 256 + s]); el primer byte cuenta con el contexto 0.
+void huff_o1_histogram(const unsigned char* data, size_t len, uint64_t* pairs);
+
+// Función para agrupar los contextos del histograma de pares en como mucho max_clusters grupos y
+// calcular las longitudes de los códigos de cada grupo. Los grupos se refinan como en k-medias
+// (cada contexto pasa al grupo donde sus bytes cuestan menos) y luego se unen mientras la tabla
+// que se ahorra en el encabezado pese más que los bits que se pierden en el payload.
+void huff_o1_build(const uint64_t* pairs, int max_clusters, HO1Model* model);
+
+// Función que devuelve los bits del payload que produce el modelo con el histograma de pares.
+double huff_o1_cost(const uint64_t* pairs, const HO1Model* model);
+
+// Función para escribir el encabezado en dst (HUFF_O1_HEADER_MAX_SIZE bytes). Devuelve su longitud.
+size_t huff_o1_write_header(const HO1Model* model, uint64_t orig_len, unsigned char* dst);
+
+// Función para leer el encabezado. Devuelve los bytes consumidos o -1 si no es válido.
+long huff_o1_read_header(const unsigned char* src, size_t len, HO1Model* model, uint64_t* orig_len);
+
+// Función para codificar len bytes en dst, que tiene cap bytes, sin escribir fuera de dst (con
+// HUFF_ENCODE_BOUND(len, HUFF_O1_MAX_LEN) bytes siempre alcanza). Devuelve los bytes escritos o
+// (size_t)-1 si no caben.
+size_t huff_o1_encode_to(const unsigned char* data, size_t len, const HO1Model* model, unsigned char* dst, size_t cap);
+
+// Función para armar las tablas del decodificador con el modelo. Devuelve 0, o -1 si las
+// longitudes de algún grupo no forman un código prefijo válido.
+int huff_o1_decoder_table(HO1Decoder* dec, const HO1Model* model);
+
+// Función para empezar a decodificar un payload con las tablas ya armadas.
+void huff_o1_decoder_start(HO1Decoder* dec, const unsigned char* payload, size_t len);
+
+// Función para decodificar los n símbolos siguientes. Devuelve 0, o -1 si el payload se terminó
+// antes o tiene un código inválido.
+int huff_o1_decode(HO1Decoder* dec, unsigned char* out, size_t n);
+
+// Función para escribir en f_out un archivo completo (encabezado y payload). Devuelve 0 o -1.
+int huff_o1_encode_file(const unsigned char* data, size_t len, const HO1Model* model, FILE* f_out);
+
+// Función para decodificar los bytes [offset, offset + length) de un archivo en memoria y
+// escribirlos en f_out. Suma a res->bytes_out los bytes escritos. Devuelve 0 o -1 con res->msg.
+int huff_o1_decode_file(const unsigned char* in, size_t in_len, uint64_t offset, uint64_t length,
+                        FILE* f_out, HFileResult* res);
+
+#endif // !HUFF_ORDER1_H
@@ -0,0 +1,334 @@
+#define _GNU_SOURCE // fopencookie
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "huff_batch.h"
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_uring.h"
+#include "huff_const.h"
+
+// Buffer del pool: crece hasta lo que necesite un archivo y conserva la capacidad al reciclarse.
+struct huff_pipe_buffer {
+    unsigned char* data;
+    size_t         len;
+    size_t         cap;
+};
+
+// Un archivo en curso dentro del pipeline, con su entrada y su salida en memoria.
+struct huff_pipe_slot {
+    HJob*                   job;
+    int                     direct; // 1 si el trabajador lee y escribe el archivo por su cuenta.
+    struct huff_pipe_buffer in;     // Archivo de entrada completo.
+    struct huff_pipe_buffer out;    // Salida codificada o decodificada.
+};
+
+// Cola bloqueante de índices de huecos entre dos etapas.
+struct huff_pipe_queue {
+    int*            items;
+    size_t          head;
+    size_t          count;
+    size_t          cap;
+    int             closed; // 1 cuando la etapa anterior terminó.
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+};
+
+// Estado compartido por las tres etapas.
+struct huff_pipeline {
+    HBatch*                batch;
+    struct huff_pipe_slot* slots;
+    struct huff_pipe_queue free_slots; // Huecos libres (lector).
+    struct huff_pipe_queue ready;      // Entradas leídas (trabajadores).
+    struct huff_pipe_queue done;       // Salidas por escribir (escritor).
+    int                    workers;    // Trabajadores que siguen activos; el último cierra done.
+    int                    use_uring;
+    pthread_mutex_t        lock;       // Protege workers.
+};
+
+// Inicia una cola con capacidad para cap huecos.
+static int huff_pipe_queue_init(struct huff_pipe_queue* q, size_t cap) {
+    memset(q, 0, sizeof(*q));
+    q->items = (int*)malloc(sizeof(int) * cap);
+    q->cap = cap;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    return q->items != NULL ? 0 : -1;
+}
+
+// Libera la cola.
+static void huff_pipe_queue_free(struct huff_pipe_queue* q) {
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q->items);
+}
+
+// Agrega un hueco a la cola (nunca se llena: hay tantos lugares como huecos).
+static void huff_pipe_queue_push(struct huff_pipe_queue* q, int k) {
+    pthread_mutex_lock(&q->lock);
+    q->items[(q->head + q->count) % q->cap] = k;
+    q->count++;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// Saca un hueco de la cola, esperando si está vacía. Devuelve -1 si la cola se cerró y está vacía.
+static int huff_pipe_queue_pop(struct huff_pipe_queue* q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) {
+        pthread_cond_wait(&q->cond, &q->lock);
+    }
+    int k = -1;
+    if (q->count > 0) {
+        k = q->items[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return k;
+}
+
+// Cierra la cola y despierta a todos los que esperan.
+static void huff_pipe_queue_close(struct huff_pipe_queue* q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// Asegura que el buffer tenga al menos need bytes de capacidad.
+static int huff_pipe_reserve(struct huff_pipe_buffer* b, size_t need) {
+    if (need <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : HUFF_IO_BUFFER_SIZE;
+    while (cap < need) cap *= 2;
+    unsigned char* grown = (unsigned char*)realloc(b->data, cap);
+    if (grown == NULL) return -1;
+    b->data = grown;
+    b->cap = cap;
+    return 0;
+}
+
+// Escritura del FILE* de salida: agrega los bytes al buffer del hueco.
+static ssize_t huff_pipe_cookie_write(void* cookie, const char* data, size_t n) {
+    struct huff_pipe_buffer* b = (struct huff_pipe_buffer*)cookie;
+    if (huff_pipe_reserve(b, b->len + n) != 0) return -1;
+    memcpy(b->data + b->len, data, n);
+    b->len += n;
+    return (ssize_t)n;
+}
+
+// Posición del FILE* de salida, solo para ftell: la salida se escribe siempre al final.
+static int huff_pipe_cookie_seek(void* cookie, off64_t* offset, int whence) {
+    struct huff_pipe_buffer* b = (struct huff_pipe_buffer*)cookie;
+    if (*offset != 0 || whence == SEEK_SET) return -1;
+    *offset = (off64_t)b->len;
+    return 0;
+}
+
+// Lee el archivo de entrada completo en el buffer del hueco. Devuelve 0, o -1 si el archivo debe
+// procesarse directamente (no se pudo leer, no es regular o supera HUFF_PIPELINE_MAX_FILE).
+static int huff_pipe_read(struct huff_pipe_slot* slot, HUring* ring) {
+    int fd = open(slot->job->input_path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > HUFF_PIPELINE_MAX_FILE ||
+        huff_pipe_reserve(&slot->in, (size_t)st.st_size) != 0) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    int ret = -1;
+    if (ring != NULL && ring->fd >= 0) {
+        ret = huff_uring_read(ring, fd, slot->in.data, len);
+        if (ret != 0 && errno == EINVAL) huff_uring_free(ring); // El kernel no admite la operación.
+    }
+    if (ret != 0) {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = pread(fd, slot->in.data + done, len - done, (off_t)done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+        ret = done == len ? 0 : -1;
+    }
+    close(fd);
+    slot->in.len = len;
+    return ret;
+}
+
+// Escribe la salida del hueco en su archivo. Devuelve 0 o -1.
+static int huff_pipe_write(const struct huff_pipe_slot* slot, HUring* ring) {
+    int fd = open(slot->job->output_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) return -1;
+    int ret = -1;
+    if (ring != NULL && ring->fd >= 0) {
+        ret = huff_uring_write(ring, fd, slot->out.data, slot->out.len);
+        if (ret != 0 && errno == EINVAL) huff_uring_free(ring);
+    }
+    if (ret != 0) {
+        size_t done = 0;
+        while (done < slot->out.len) {
+            ssize_t n = pwrite(fd, slot->out.data + done, slot->out.len - done, (off_t)done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += (size_t)n;
+        }
+        ret = done == slot->out.len ? 0 : -1;
+    }
+    if (close(fd) != 0) ret = -1;
+    return ret;
+}
+
+// Etapa de lectura: carga los archivos en orden a medida que se liberan huecos.
+static void* huff_pipe_reader(void* arg) {
+    struct huff_pipeline* p = (struct huff_pipeline*)arg;
+    HUring ring;
+    memset(&ring, 0, sizeof(ring));
+    ring.fd = -1;
+    if (p->use_uring) huff_uring_init(&ring, HUFF_URING_DEPTH); // Si falla queda sin anillo.
+    for (size_t i = 0; i < p->batch->count; i++) {
+        int k = huff_pipe_queue_pop(&p->free_slots);
+        struct huff_pipe_slot* slot = &p->slots[k];
+        slot->job = &p->batch->jobs[i];
+        slot->in.len = 0;
+        slot->direct = huff_pipe_read(slot, &ring) != 0;
+        huff_pipe_queue_push(&p->ready, k);
+    }
+    huff_pipe_queue_close(&p->ready);
+    huff_uring_free(&ring);
+    return NULL;
+}
+
+// Etapa de cálculo: codifica o decodifica en memoria las entradas leídas.
+static void* huff_pipe_worker(void* arg) {
+    struct huff_pipeline* p = (struct huff_pipeline*)arg;
+    const HBatch* batch = p->batch;
+    cookie_io_functions_t io = {NULL, huff_pipe_cookie_write, huff_pipe_cookie_seek, NULL};
+    int k;
+    while ((k = huff_pipe_queue_pop(&p->ready)) >= 0) {
+        struct huff_pipe_slot* slot = &p->slots[k];
+        HJob* job = slot->job;
+        slot->out.len = 0;
+        FILE* f_out = slot->direct ? NULL : fopencookie(&slot->out, "w", io);
+        if (f_out == NULL) {
+            // Archivos grandes o que no se pudieron leer: el camino de siempre (mmap y fopen),
+            // que también informa los errores con su mensaje habitual.
+            slot->direct = 1;
+            huff_batch_run_job(batch, job);
+        } else {
+            if (batch->encode) {
+                huff_encode_memory_r(slot->in.data, slot->in.len, job->input_path, f_out, job->output_path,
+                                     batch->codebooks_dir, batch->opts, &job->result);
+            } else {
+                huff_decode_memory_r(slot->in.data, slot->in.len, job->input_path, job->codebook_path, f_out,
+                                     batch->opts, &job->result);
+            }
+            if (fclose(f_out) != 0 && job->result.status == 0) {
+                snprintf(job->result.msg, sizeof(job->result.msg), "out of memory");
+                job->result.status = -1;
+            }
+        }
+        huff_pipe_queue_push(&p->done, k);
+    }
+    pthread_mutex_lock(&p->lock);
+    int last = --p->workers == 0;
+    pthread_mutex_unlock(&p->lock);
+    if (last) huff_pipe_queue_close(&p->done);
+    return NULL;
+}
+
+// Etapa de escritura (en el hilo actual): escribe las salidas, informa y recicla los huecos.
+static void huff_pipe_writer(struct huff_pipeline* p) {
+    HUring ring;
+    memset(&ring, 0, sizeof(ring));
+    ring.fd = -1;
+    if (p->use_uring) huff_uring_init(&ring, HUFF_URING_DEPTH); // Si falla queda sin anillo.
+    int k;
+    while ((k = huff_pipe_queue_pop(&p->done)) >= 0) {
+        struct huff_pipe_slot* slot = &p->slots[k];
+        HJob* job = slot->job;
+        if (!slot->direct && job->result.status == 0 && huff_pipe_write(slot, &ring) != 0) {
+            snprintf(job->result.msg, sizeof(job->result.msg), p->batch->encode ? "Cannot write %s" : "cannot write %s",
+                     job->output_path);
+            job->result.status = -1;
+        }
+        huff_batch_report_job(p->batch, job);
+        huff_pipe_queue_push(&p->free_slots, k);
+    }
+    huff_uring_free(&ring);
+}
+
+// Función para procesar el lote en un pipeline de lectura, cálculo y escritura.
+int huff_batch_run_pipeline(HBatch* batch, int n_workers, int use_uring) {
+    if (n_workers < 1) n_workers = 1;
+    struct huff_pipeline p;
+    memset(&p, 0, sizeof(p));
+    p.batch = batch;
+    p.use_uring = use_uring;
+    p.workers = n_workers;
+    pthread_mutex_init(&p.lock, NULL);
+    // Uno leído por adelantado y otro en cálculo por trabajador, más el que se está escribiendo.
+    int n_slots = n_workers * HUFF_PIPELINE_BUFFERS_PER_WORKER + 1;
+    p.slots = (struct huff_pipe_slot*)calloc((size_t)n_slots, sizeof(struct huff_pipe_slot));
+    int ok = p.slots != NULL;
+    ok = huff_pipe_queue_init(&p.free_slots, (size_t)n_slots) == 0 && ok;
+    ok = huff_pipe_queue_init(&p.ready, (size_t)n_slots) == 0 && ok;
+    ok = huff_pipe_queue_init(&p.done, (size_t)n_slots) == 0 && ok;
+    pthread_t reader;
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)n_workers);
+    int started = 0;
+    if (ok && workers != NULL) {
+        for (int k = 0; k < n_slots; k++) {
+            huff_pipe_queue_push(&p.free_slots, k);
+        }
+        for (; started < n_workers; started++) {
+            if (pthread_create(&workers[started], NULL, huff_pipe_worker, &p) != 0) break;
+        }
+        // Los trabajadores que no se crearon cuentan como terminados.
+        pthread_mutex_lock(&p.lock);
+        p.workers -= n_workers - started;
+        pthread_mutex_unlock(&p.lock);
+    }
+    if (started == 0 || pthread_create(&reader, NULL, huff_pipe_reader, &p) != 0) {
+        // Sin memoria para el pool o sin hilos: el lote se procesa como siempre.
+        huff_pipe_queue_close(&p.ready);
+        for (int t = 0; t < started; t++) {
+            pthread_join(workers[t], NULL);
+        }
+        free(workers);
+        free(p.slots);
+        huff_pipe_queue_free(&p.free_slots);
+        huff_pipe_queue_free(&p.ready);
+        huff_pipe_queue_free(&p.done);
+        pthread_mutex_destroy(&p.lock);
+        return huff_batch_run_threads(batch, n_workers);
+    }
+    huff_pipe_writer(&p);
+    pthread_join(reader, NULL);
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    for (int k = 0; k < n_slots; k++) {
+        free(p.slots[k].in.data);
+        free(p.slots[k].out.data);
+    }
+    free(p.slots);
+    free(workers);
+    huff_pipe_queue_free(&p.free_slots);
+    huff_pipe_queue_free(&p.ready);
+    huff_pipe_queue_free(&p.done);
+    pthread_mutex_destroy(&p.lock);
+
+    int failed = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (batch->jobs[i].result.status != 0) failed++;
+    }
+    return failed;
+}
@@ -0,0 +1,40 @@
+#ifndef HUFF_RESULT_H
+#define HUFF_RESULT_H
+
+#include <stddef.h>
+
+// Longitud máxima del mensaje de error que se guarda por archivo.
+#ifndef HUFF_RESULT_MSG_LEN
+#define HUFF_RESULT_MSG_LEN 256
+#endif // !HUFF_RESULT_MSG_LEN
+
+// Fases que se miden por archivo con opts->stats (huff_stats.h).
+enum huff_phase {
+	HUFF_PHASE_HISTOGRAM, // Conteo de bytes.
+	HUFF_PHASE_TREE,      // Árbol, longitudes y códigos (al decodificar: árbol y tabla).
+	HUFF_PHASE_CODEBOOK,  // Encabezado o codebook de texto.
+	HUFF_PHASE_ENCODE,    // Flujo de bits.
+	HUFF_PHASE_DECODE,    // Decodificación y escritura de la salida.
+	HUFF_PHASE_COUNT
+};
+
+// Resultado de codificar o decodificar un archivo.
+// Las funciones de codificación/decodificación no escriben en stdout; en su lugar
+// llenan esta estructura para que el llamador decida cómo y cuándo reportarla.
+struct huff_file_result {
+	size_t bytes_in;                 // Bytes leídos del archivo de entrada.
+	size_t bytes_out;                // Bytes escritos en el archivo de salida.
+	int    status;                   // 0 si la operación fue exitosa, -1 en caso de error.
+	int    max_code_len;             // Longitud del código más largo (solo al codificar).
+	double cap_cost;                 // Aumento relativo del tamaño por limitar la longitud de los códigos.
+	char   msg[HUFF_RESULT_MSG_LEN]; // Descripción del error (vacío si no hubo error).
+	double entropy;                  // Entropía de Shannon del histograma en bits por símbolo (con opts->stats, al codificar).
+	double code_bits;                // Bits por símbolo de los códigos, sin encabezados (con opts->stats, al codificar).
+	double wall[HUFF_PHASE_COUNT];   // Segundos de reloj de cada fase (con opts->stats).
+	double cpu[HUFF_PHASE_COUNT];    // Segundos de CPU del hilo en cada fase (con opts->stats).
+};
+
+// Nombre corto para el resultado por archivo.
+typedef struct huff_file_result HFileResult;
+
+#endif // !HUFF_RESULT_H
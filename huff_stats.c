@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/resource.h>
+#include "huff_stats.h"
+#include "huff_const.h"
+
+// Nombres de las fases en la salida JSON.
+static const char* const huff_phase_names[HUFF_PHASE_COUNT] = {
+    "histogram", "tree", "codebook", "encode", "decode"
+};
+
+// Calcula la entropía del histograma.
+double huff_stats_entropy(const uint64_t* counts) {
+    uint64_t total = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        total += counts[s];
+    }
+    if (total == 0) return 0.0;
+    double entropy = 0.0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        if (counts[s] == 0) continue;
+        double p = (double)counts[s] / (double)total;
+        entropy -= p * log2(p);
+    }
+    return entropy;
+}
+
+// Calcula los bits por símbolo de los códigos.
+double huff_stats_code_bits(const uint64_t* counts, const unsigned char* lengths) {
+    uint64_t total = 0, bits = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        total += counts[s];
+        bits += counts[s] * lengths[s];
+    }
+    return total ? (double)bits / (double)total : 0.0;
+}
+
+// Escribe s como cadena JSON.
+static void huff_stats_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20) fprintf(f, "\\u%04x", c);
+        else fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+// Escribe los campos comunes a un archivo y a una ejecución (sin llaves).
+static void huff_stats_json_fields(FILE* f, const HFileResult* res, double entropy, double code_bits) {
+    double ratio = res->bytes_in ? (double)res->bytes_out / (double)res->bytes_in : 0.0;
+    fprintf(f, "\"bytes_in\":%zu,\"bytes_out\":%zu,\"ratio\":%.6f", res->bytes_in, res->bytes_out, ratio);
+    if (code_bits > 0.0) {
+        // Bits por símbolo de la salida completa y solo de los códigos, frente a la entropía.
+        double bps = res->bytes_in ? 8.0 * (double)res->bytes_out / (double)res->bytes_in : 0.0;
+        fprintf(f, ",\"bits_per_symbol\":%.4f,\"code_bits_per_symbol\":%.4f,\"entropy\":%.4f", bps, code_bits, entropy);
+    }
+    if (res->max_code_len > 0) fprintf(f, ",\"max_code_len\":%d", res->max_code_len);
+    fputs(",\"phases\":{", f);
+    int first = 1;
+    for (int p = 0; p < HUFF_PHASE_COUNT; p++) {
+        if (res->wall[p] == 0.0 && res->cpu[p] == 0.0) continue; // Fase que no se ejecutó.
+        fprintf(f, "%s\"%s\":{\"wall_s\":%.6f,\"cpu_s\":%.6f}", first ? "" : ",", huff_phase_names[p], res->wall[p], res->cpu[p]);
+        first = 0;
+    }
+    fputc('}', f);
+}
+
+// Escribe la línea de un archivo. La línea se arma en memoria y se escribe de una vez, así las
+// líneas de distintos hilos no se mezclan.
+void huff_stats_write_file(FILE* f, const char* path, int encode, const HFileResult* res) {
+    char line[4096];
+    FILE* mem = fmemopen(line, sizeof(line), "w");
+    if (mem == NULL) return;
+    fprintf(mem, "{\"type\":\"file\",\"op\":\"%s\",\"path\":", encode ? "encode" : "decode");
+    huff_stats_json_string(mem, path);
+    fprintf(mem, ",\"status\":\"%s\",", res->status == 0 ? "ok" : "error");
+    if (res->status != 0) {
+        fputs("\"error\":", mem);
+        huff_stats_json_string(mem, res->msg);
+        fputc(',', mem);
+    }
+    huff_stats_json_fields(mem, res, res->entropy, res->code_bits);
+    fputs("}\n", mem);
+    long n = ftell(mem);
+    fclose(mem);
+    if (n > 0 && (size_t)n < sizeof(line)) fwrite(line, 1, (size_t)n, f);
+}
+
+// Suma un archivo al total.
+void huff_stats_add(HFileResult* total, const HFileResult* res) {
+    total->bytes_in += res->bytes_in;
+    total->bytes_out += res->bytes_out;
+    if (res->max_code_len > total->max_code_len) total->max_code_len = res->max_code_len;
+    total->entropy += res->entropy * (double)res->bytes_in;
+    total->code_bits += res->code_bits * (double)res->bytes_in;
+    for (int p = 0; p < HUFF_PHASE_COUNT; p++) {
+        total->wall[p] += res->wall[p];
+        total->cpu[p] += res->cpu[p];
+    }
+}
+
+// Escribe la línea del total de la ejecución.
+void huff_stats_write_run(FILE* f, int encode, const HFileResult* total, size_t files, int failed,
+                          const char* mode, int workers, double wall) {
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    double cpu = (double)(self.ru_utime.tv_sec + self.ru_stime.tv_sec + children.ru_utime.tv_sec + children.ru_stime.tv_sec)
+               + (double)(self.ru_utime.tv_usec + self.ru_stime.tv_usec + children.ru_utime.tv_usec + children.ru_stime.tv_usec) * 1e-6;
+    double weight = total->bytes_in ? (double)total->bytes_in : 1.0;
+    fprintf(f, "{\"type\":\"run\",\"op\":\"%s\",\"mode\":\"%s\",\"workers\":%d,\"files\":%zu,\"failed\":%d,\"wall_s\":%.6f,\"cpu_s\":%.6f,",
+            encode ? "encode" : "decode", mode, workers, files, failed, wall, cpu);
+    huff_stats_json_fields(f, total, total->entropy / weight, total->code_bits / weight);
+    fputs("}\n", f);
+}
@@ -0,0 +1,60 @@
+#ifndef HUFF_STATS_H
+#define HUFF_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "huff_result.h"
+
+// Estadísticas por archivo y por ejecución (--stats). Las fases se miden solo si la opción está
+// activa: sin ella cada límite de fase cuesta una comparación, y nada por símbolo.
+
+// Inicio de una fase.
+struct huff_phase_clock {
+	double wall; // Reloj monotónico al empezar.
+	double cpu;  // CPU del hilo al empezar.
+};
+
+// Nombre corto para el reloj de una fase.
+typedef struct huff_phase_clock HPhaseClock;
+
+// Función que devuelve los segundos de un reloj de clock_gettime.
+static inline double huff_clock_seconds(clockid_t id) {
+	struct timespec ts;
+	clock_gettime(id, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Función para empezar a medir una fase (no hace nada si enabled es 0).
+static inline void huff_phase_start(HPhaseClock* clock, int enabled) {
+	if (!enabled) return;
+	clock->wall = huff_clock_seconds(CLOCK_MONOTONIC);
+	clock->cpu = huff_clock_seconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// Función para sumar a res el tiempo de la fase desde huff_phase_start.
+static inline void huff_phase_stop(const HPhaseClock* clock, int enabled, HFileResult* res, int phase) {
+	if (!enabled) return;
+	res->wall[phase] += huff_clock_seconds(CLOCK_MONOTONIC) - clock->wall;
+	res->cpu[phase] += huff_clock_seconds(CLOCK_THREAD_CPUTIME_ID) - clock->cpu;
+}
+
+// Función que devuelve la entropía de Shannon del histograma en bits por símbolo.
+double huff_stats_entropy(const uint64_t* counts);
+
+// Función que devuelve los bits por símbolo que producen las longitudes de código con el histograma.
+double huff_stats_code_bits(const uint64_t* counts, const unsigned char* lengths);
+
+// Función para escribir una línea JSON con el resultado de un archivo.
+void huff_stats_write_file(FILE* f, const char* path, int encode, const HFileResult* res);
+
+// Función para sumar el resultado de un archivo al total de la ejecución. La entropía y los bits
+// por símbolo del total quedan ponderados por bytes_in hasta huff_stats_write_run.
+void huff_stats_add(HFileResult* total, const HFileResult* res);
+
+// Función para escribir una línea JSON con el total de una ejecución (huff_stats_add), el tiempo de
+// reloj y la CPU del proceso (hilos e hijos incluidos).
+void huff_stats_write_run(FILE* f, int encode, const HFileResult* total, size_t files, int failed,
+                          const char* mode, int workers, double wall);
+
+#endif // !HUFF_STATS_H
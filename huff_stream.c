@@ -0,0 +1,541 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "huff_stream.h"
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_format.h"
+#include "huff_stats.h"
+#include "huff_batch.h"
+
+// Estados del decodificador incremental.
+enum {
+    HUFF_DEC_HEADER, // Esperando el encabezado del flujo.
+    HUFF_DEC_BLOCKS, // Leyendo bloques.
+    HUFF_DEC_DONE,   // Se leyó la marca de fin.
+    HUFF_DEC_ERROR   // El flujo no es válido; se ignora el resto.
+};
+
+// Escribe n bytes en f_out y los suma a la salida del resultado.
+static int huff_stream_write(FILE* f_out, const unsigned char* data, size_t n, HFileResult* res) {
+    if (n > 0 && fwrite(data, 1, n, f_out) != n) {
+        snprintf(res->msg, sizeof(res->msg), "cannot write output");
+        return -1;
+    }
+    res->bytes_out += n;
+    return 0;
+}
+
+// Inicia el codificador y escribe el encabezado del flujo.
+int huff_encoder_init(HEncoder* enc, FILE* f_out, const HOptions* opts) {
+    memset(enc, 0, sizeof(*enc));
+    enc->f_out = f_out;
+    enc->block_size = opts && opts->block_size > 0 ? (size_t)opts->block_size : HUFF_STREAM_BLOCK_SIZE;
+    if (enc->block_size > HUFF_STREAM_MAX_BLOCK) enc->block_size = HUFF_STREAM_MAX_BLOCK;
+    enc->max_code_len = opts && opts->max_code_len > 0 ? opts->max_code_len : HUFF_MAX_LEN - 1;
+    if (enc->max_code_len > HUFF_MAX_LEN - 1) enc->max_code_len = HUFF_MAX_LEN - 1;
+    enc->n_streams = opts && opts->streams > 1 ? opts->streams : 1;
+    if (enc->n_streams > HUFF_MAX_STREAMS) enc->n_streams = HUFF_MAX_STREAMS;
+    enc->trace = opts && opts->verbose ? stderr : NULL;
+    enc->stats = opts ? opts->stats : 0;
+    int interval = opts && opts->index_interval != 0 ? opts->index_interval : HUFF_INDEX_INTERVAL;
+    huff_index_init(&enc->index, interval > 0 ? (uint32_t)interval : 0);
+    enc->block = (unsigned char*)malloc(enc->block_size);
+    // Con max_code_len bits por byte como mucho, más el encabezado del bloque y un byte de
+    // relleno por flujo.
+    enc->out = (unsigned char*)malloc(HUFF_BLOCK_HEADER_MAX_SIZE + HUFF_ENCODE_BOUND(enc->block_size, HUFF_MAX_LEN) + HUFF_MAX_STREAMS);
+    if (enc->block == NULL || enc->out == NULL) {
+        snprintf(enc->result.msg, sizeof(enc->result.msg), "out of memory");
+        free(enc->block);
+        free(enc->out);
+        enc->block = enc->out = NULL;
+        return -1;
+    }
+    HStreamHeader stream_header;
+    memset(&stream_header, 0, sizeof(stream_header));
+    stream_header.flags = HUFF_STREAM_FLAG_INDEX;
+    stream_header.block_size = (uint32_t)enc->block_size;
+    stream_header.n_streams = enc->n_streams;
+    unsigned char header[HUFF_STREAM_HEADER_MAX_SIZE];
+    size_t header_len = huff_write_stream_header(&stream_header, header);
+    return huff_stream_write(f_out, header, header_len, &enc->result);
+}
+
+// Codifica un bloque completo con los códigos de su propio histograma y lo escribe.
+static int huff_encoder_block(HEncoder* enc, const unsigned char* data, size_t len) {
+    HPhaseClock clock = {0, 0};
+    huff_phase_start(&clock, enc->stats);
+    uint64_t counts[HUFF_MAX_SYMBOLS];
+    memset(counts, 0, sizeof(counts));
+    huff_histogram(data, len, counts);
+    huff_phase_stop(&clock, enc->stats, &enc->result, HUFF_PHASE_HISTOGRAM);
+    huff_phase_start(&clock, enc->stats);
+    HBlockHeader block;
+    HTreeArena arena;
+    double cap_cost = huff_build_code_lengths(counts, enc->max_code_len, &arena, block.lengths, enc->trace);
+    enc->cap_weight += cap_cost * (double)len;
+
+    uint64_t codes[HUFF_MAX_SYMBOLS];
+    huff_canonical_codes(block.lengths, codes);
+    HPackedCode packed[HUFF_MAX_SYMBOLS];
+    int max_len = 0;
+    for (int s = 0; s < HUFF_MAX_SYMBOLS; s++) {
+        packed[s].bits = codes[s];
+        packed[s].len = block.lengths[s];
+        if (packed[s].len > max_len) max_len = packed[s].len;
+    }
+    if (max_len > enc->result.max_code_len) enc->result.max_code_len = max_len;
+    huff_phase_stop(&clock, enc->stats, &enc->result, HUFF_PHASE_TREE);
+    if (enc->stats) {
+        // Ponderadas por len; huff_encoder_finish las divide por el total.
+        enc->result.entropy += huff_stats_entropy(counts) * (double)len;
+        enc->result.code_bits += huff_stats_code_bits(counts, block.lengths) * (double)len;
+    }
+    huff_phase_start(&clock, enc->stats);
+
+    // El encabezado ocupa lo mismo con cualquier payload_len y tabla de saltos: se escriben los
+    // flujos detrás y se completa el encabezado al final.
+    block.raw_len = (uint32_t)len;
+    block.payload_len = 0;
+    memset(block.stream_len, 0, sizeof(block.stream_len));
+    size_t header_len = huff_write_block_header(&block, enc->n_streams, enc->out);
+    uint32_t seg_len[HUFF_MAX_STREAMS];
+    huff_split_streams(block.raw_len, enc->n_streams, seg_len);
+    if (huff_index_add_block(&enc->index, enc->result.bytes_in, enc->result.bytes_out * 8) != 0) {
+        snprintf(enc->result.msg, sizeof(enc->result.msg), "out of memory");
+        return -1;
+    }
+    HBitWriter w = {0, 0, enc->out + header_len, 0};
+    for (int k = 0; k < enc->n_streams; k++) {
+        // Cada flujo termina en un byte para que el decodificador sepa dónde empieza el siguiente.
+        size_t start = w.pos;
+        if (enc->n_streams == 1 && enc->index.interval > 0) {
+            // Con un solo flujo se anota el bit donde empieza cada intervalo del índice.
+            for (size_t done = 0; done < len; done += enc->index.interval) {
+                if (done > 0 && huff_index_add_point(&enc->index, (uint32_t)(w.pos * 8 + (size_t)w.bits)) != 0) {
+                    snprintf(enc->result.msg, sizeof(enc->result.msg), "out of memory");
+                    return -1;
+                }
+                size_t n = len - done < enc->index.interval ? len - done : enc->index.interval;
+                huff_encode_symbols(&w, data + done, n, packed, max_len);
+            }
+        } else {
+            huff_encode_symbols(&w, data, seg_len[k], packed, max_len);
+        }
+        huff_bit_writer_finish(&w);
+        block.stream_len[k] = (uint32_t)(w.pos - start);
+        data += seg_len[k];
+    }
+    block.payload_len = (uint32_t)w.pos;
+    huff_write_block_header(&block, enc->n_streams, enc->out);
+    enc->result.bytes_in += len;
+    int ret = huff_stream_write(enc->f_out, enc->out, header_len + w.pos, &enc->result);
+    huff_phase_stop(&clock, enc->stats, &enc->result, HUFF_PHASE_ENCODE);
+    return ret;
+}
+
+// Agrega bytes a la entrada del codificador.
+int huff_encoder_push(HEncoder* enc, const unsigned char* data, size_t len) {
+    while (len > 0) {
+        if (enc->fill == 0 && len >= enc->block_size) {
+            // Bloque completo en el buffer del llamador: se codifica sin copiarlo.
+            if (huff_encoder_block(enc, data, enc->block_size) != 0) return -1;
+            data += enc->block_size;
+            len -= enc->block_size;
+            continue;
+        }
+        size_t n = enc->block_size - enc->fill;
+        if (n > len) n = len;
+        memcpy(enc->block + enc->fill, data, n);
+        enc->fill += n;
+        data += n;
+        len -= n;
+        if (enc->fill == enc->block_size) {
+            if (huff_encoder_block(enc, enc->block, enc->fill) != 0) return -1;
+            enc->fill = 0;
+        }
+    }
+    return 0;
+}
+
+// Codifica el último bloque y escribe la marca de fin.
+int huff_encoder_finish(HEncoder* enc) {
+    int ret = 0;
+    if (enc->fill > 0) ret = huff_encoder_block(enc, enc->block, enc->fill);
+    enc->fill = 0;
+    if (ret == 0) {
+        HBlockHeader end;
+        memset(&end, 0, sizeof(end));
+        unsigned char buf[HUFF_BLOCK_HEADER_MAX_SIZE];
+        size_t n = huff_write_block_header(&end, enc->n_streams, buf);
+        ret = huff_stream_write(enc->f_out, buf, n, &enc->result);
+    }
+    if (ret == 0) {
+        size_t n = huff_index_size(&enc->index);
+        unsigned char* buf = (unsigned char*)malloc(n);
+        if (buf == NULL) {
+            snprintf(enc->result.msg, sizeof(enc->result.msg), "out of memory");
+            ret = -1;
+        } else {
+            huff_write_index(&enc->index, enc->result.bytes_out, buf);
+            ret = huff_stream_write(enc->f_out, buf, n, &enc->result);
+            free(buf);
+        }
+    }
+    huff_index_free(&enc->index);
+    if (enc->result.bytes_in > 0) {
+        enc->result.cap_cost = enc->cap_weight / (double)enc->result.bytes_in;
+        enc->result.entropy /= (double)enc->result.bytes_in;
+        enc->result.code_bits /= (double)enc->result.bytes_in;
+    }
+    enc->result.status = ret;
+    free(enc->block);
+    free(enc->out);
+    enc->block = enc->out = NULL;
+    return ret;
+}
+
+// Inicia el decodificador.
+int huff_decoder_init(HDecoder* dec, FILE* f_out) {
+    memset(dec, 0, sizeof(*dec));
+    dec->f_out = f_out;
+    dec->state = HUFF_DEC_HEADER;
+    return 0;
+}
+
+// Marca el flujo como inválido con el mensaje indicado.
+static long huff_decoder_fail(HDecoder* dec, const char* msg) {
+    snprintf(dec->result.msg, sizeof(dec->result.msg), "%s", msg);
+    dec->state = HUFF_DEC_ERROR;
+    return -1;
+}
+
+// Decodifica el payload de un bloque en out (block->raw_len bytes). Devuelve NULL o el mensaje de error.
+static const char* huff_block_decode(const HBlockHeader* block, int n_streams, const unsigned char* payload, unsigned char* out) {
+    HDecodeNode* root_decode = create_huff_decode_node();
+    if (root_decode == NULL || build_huff_decode_tree_from_lengths(block->lengths, root_decode) != 0) {
+        free_huff_decode_tree(root_decode);
+        return "invalid code lengths";
+    }
+    HDecodeTable* table = build_huff_decode_table(root_decode);
+    int ret = -1;
+    if (table != NULL && n_streams > 1) {
+        uint32_t seg_len[HUFF_MAX_STREAMS];
+        huff_split_streams(block->raw_len, n_streams, seg_len);
+        ret = huff_decode_interleaved(table, payload, block->stream_len, n_streams, out, seg_len);
+    } else if (table != NULL) {
+        uint64_t bit_pos = 0;
+        size_t produced = huff_decode_bits(table, payload, &bit_pos, (uint64_t)block->payload_len * 8, out, block->raw_len);
+        ret = produced == block->raw_len ? 0 : -1;
+    }
+    free_huff_decode_table(table);
+    free_huff_decode_tree(root_decode);
+    return ret == 0 ? NULL : "corrupt block";
+}
+
+// Decodifica el payload de un bloque y escribe sus bytes.
+static long huff_decoder_block(HDecoder* dec, const HBlockHeader* block, const unsigned char* payload) {
+    const char* err = huff_block_decode(block, dec->header.n_streams, payload, dec->out);
+    if (err != NULL) return huff_decoder_fail(dec, err);
+    // Un error de escritura también termina el flujo, así huff_decoder_finish conserva el mensaje.
+    if (huff_stream_write(dec->f_out, dec->out, block->raw_len, &dec->result) != 0) {
+        return huff_decoder_fail(dec, "cannot write output");
+    }
+    return 0;
+}
+
+// Procesa la siguiente unidad del flujo (el encabezado o un bloque) si está completa en src.
+// Devuelve los bytes consumidos, 0 si faltan bytes (en *need queda el total necesario hasta
+// ahora) o -1 si el flujo no es válido.
+static long huff_decoder_unit(HDecoder* dec, const unsigned char* src, size_t len, size_t* need) {
+    if (dec->state == HUFF_DEC_HEADER) {
+        long n = huff_read_stream_header(src, len, &dec->header, need);
+        if (n < 0) return huff_decoder_fail(dec, "not a block stream");
+        if (n == 0) return 0;
+        dec->out = (unsigned char*)malloc(dec->header.block_size);
+        if (dec->out == NULL) return huff_decoder_fail(dec, "out of memory");
+        dec->state = HUFF_DEC_BLOCKS;
+        return n;
+    }
+    if (dec->state == HUFF_DEC_DONE) {
+        // El índice de bloques no hace falta para decodificar todo el flujo.
+        if (dec->header.flags & HUFF_STREAM_FLAG_INDEX) return (long)len;
+        return huff_decoder_fail(dec, "trailing data after end of stream");
+    }
+    HBlockHeader block;
+    long header_len = huff_read_block_header(src, len, dec->header.n_streams, &block, need);
+    if (header_len < 0) return huff_decoder_fail(dec, "invalid block header");
+    if (header_len == 0) return 0;
+    if (block.raw_len == 0) {
+        dec->state = HUFF_DEC_DONE;
+        return header_len;
+    }
+    if (block.raw_len > dec->header.block_size || block.payload_len > HUFF_ENCODE_BOUND(block.raw_len, 64) + HUFF_MAX_STREAMS) {
+        return huff_decoder_fail(dec, "invalid block header");
+    }
+    *need = (size_t)header_len + block.payload_len;
+    if (len < *need) return 0;
+    if (huff_decoder_block(dec, &block, src + header_len) != 0) return -1;
+    return (long)*need;
+}
+
+// Entrega bytes del flujo comprimido al decodificador.
+int huff_decoder_push(HDecoder* dec, const unsigned char* data, size_t len) {
+    if (dec->state == HUFF_DEC_ERROR) return -1;
+    dec->result.bytes_in += len;
+    while (len > 0) {
+        size_t need = 0;
+        if (dec->pending_len == 0) {
+            // Las unidades completas se decodifican directamente del buffer del llamador.
+            long n = huff_decoder_unit(dec, data, len, &need);
+            if (n < 0) return -1;
+            if (n > 0) {
+                data += n;
+                len -= (size_t)n;
+                continue;
+            }
+        } else {
+            // Completa la unidad pendiente solo con los bytes que le faltan.
+            long n = huff_decoder_unit(dec, dec->pending, dec->pending_len, &need);
+            if (n < 0) return -1;
+            if (n > 0) {
+                memmove(dec->pending, dec->pending + n, dec->pending_len - (size_t)n);
+                dec->pending_len -= (size_t)n;
+                continue;
+            }
+        }
+        // Unidad incompleta: se guardan en pending los bytes que faltan (o todos los que hay).
+        size_t take = need > dec->pending_len ? need - dec->pending_len : 0;
+        if (take == 0 || take > len) take = len;
+        if (dec->pending_len + take > dec->pending_cap) {
+            size_t cap = dec->pending_cap ? dec->pending_cap : 4096;
+            while (cap < dec->pending_len + take) cap *= 2;
+            unsigned char* grown = (unsigned char*)realloc(dec->pending, cap);
+            if (grown == NULL) return (int)huff_decoder_fail(dec, "out of memory");
+            dec->pending = grown;
+            dec->pending_cap = cap;
+        }
+        memcpy(dec->pending + dec->pending_len, data, take);
+        dec->pending_len += take;
+        data += take;
+        len -= take;
+    }
+    // Una unidad completada con el último trozo se procesa ya, sin esperar más datos.
+    while (dec->pending_len > 0) {
+        size_t need = 0;
+        long n = huff_decoder_unit(dec, dec->pending, dec->pending_len, &need);
+        if (n < 0) return -1;
+        if (n == 0) break;
+        memmove(dec->pending, dec->pending + n, dec->pending_len - (size_t)n);
+        dec->pending_len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Comprueba que el flujo terminó y libera los buffers.
+int huff_decoder_finish(HDecoder* dec) {
+    if (dec->state != HUFF_DEC_DONE && dec->state != HUFF_DEC_ERROR) {
+        huff_decoder_fail(dec, "truncated stream");
+    }
+    dec->result.status = dec->state == HUFF_DEC_DONE ? 0 : -1;
+    free(dec->pending);
+    free(dec->out);
+    dec->pending = dec->out = NULL;
+    dec->pending_len = dec->pending_cap = 0;
+    return dec->result.status;
+}
+
+// Ventana de bloques consecutivos que reparten los hilos del decodificador paralelo.
+// El bloque first + k se decodifica en el hueco k de out (block_size bytes cada uno).
+struct huff_block_job {
+    const unsigned char* in;      // Archivo comprimido completo.
+    size_t               in_len;  // Bytes del archivo.
+    const HStreamHeader* header;  // Encabezado del flujo.
+    const HIndex*        index;   // Posición de cada bloque.
+    size_t               first;   // Primer bloque de la ventana.
+    size_t               end;     // Bloque siguiente al último de la ventana.
+    size_t               next;    // Siguiente bloque sin asignar (protegido por lock).
+    pthread_mutex_t      lock;    // Protege next.
+    unsigned char*       out;     // Huecos de salida de la ventana.
+    uint32_t*            raw_len; // Bytes decodificados de cada bloque de la ventana.
+    const char**         err;     // Error de cada bloque de la ventana (NULL = sin error).
+};
+
+// Decodifica el bloque b del índice en out.
+static const char* huff_block_job_decode(const struct huff_block_job* job, size_t b, unsigned char* out, uint32_t* raw_len) {
+    uint64_t pos = job->index->bit_offset[b] / 8;
+    HBlockHeader block;
+    size_t need = 0;
+    long header_len = pos < job->in_len ? huff_read_block_header(job->in + pos, job->in_len - pos, job->header->n_streams, &block, &need) : -1;
+    if (header_len <= 0 || block.raw_len == 0 || block.raw_len > job->header->block_size ||
+        block.payload_len > job->in_len - pos - (size_t)header_len) {
+        return "invalid block header";
+    }
+    *raw_len = block.raw_len;
+    return huff_block_decode(&block, job->header->n_streams, job->in + pos + header_len, out);
+}
+
+// Hilo del decodificador paralelo: toma bloques de la ventana hasta que no queda ninguno.
+static void* huff_block_worker(void* arg) {
+    struct huff_block_job* job = (struct huff_block_job*)arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t b = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (b >= job->end) return NULL;
+        size_t k = b - job->first;
+        job->err[k] = huff_block_job_decode(job, b, job->out + k * job->header->block_size, &job->raw_len[k]);
+    }
+}
+
+// Comprueba que después del último bloque del índice está la marca de fin y, detrás, solo el
+// índice (o nada si el flujo no tiene índice).
+static int huff_index_covers(const unsigned char* in, size_t in_len, const HStreamHeader* header, const HIndex* index) {
+    uint64_t pos = index->bit_offset[index->n_blocks - 1] / 8;
+    HBlockHeader block;
+    size_t need = 0;
+    long header_len = pos < in_len ? huff_read_block_header(in + pos, in_len - pos, header->n_streams, &block, &need) : -1;
+    if (header_len <= 0 || block.payload_len > in_len - pos - (size_t)header_len) return 0;
+    pos += (uint64_t)header_len + block.payload_len;
+    if (huff_read_block_header(in + pos, in_len - pos, header->n_streams, &block, &need) != 4 || block.raw_len != 0) return 0;
+    size_t tail = (header->flags & HUFF_STREAM_FLAG_INDEX) ? huff_index_size(index) : 0;
+    return pos + 4 + tail == in_len;
+}
+
+// Decodifica en paralelo un archivo completo en el formato por bloques.
+int huff_decode_blocks_parallel(const unsigned char* in, size_t in_len, FILE* f_out, int n_threads, HFileResult* res) {
+    HStreamHeader header;
+    HIndex index;
+    size_t need = 0;
+    int have_index = -1;
+    if (n_threads > 1 && huff_read_stream_header(in, in_len, &header, &need) > 0) {
+        have_index = (header.flags & HUFF_STREAM_FLAG_INDEX) ? huff_read_index(in, in_len, &index)
+                                                              : huff_index_scan(in, in_len, &index);
+    }
+    if (have_index != 0 || index.n_blocks < 2 || !huff_index_covers(in, in_len, &header, &index)) {
+        // Un solo bloque, un solo hilo o un flujo sin índice válido: el decodificador incremental
+        // recibe todo el archivo de una vez y reporta los errores con el detalle de siempre.
+        if (have_index == 0) huff_index_free(&index);
+        HDecoder dec;
+        huff_decoder_init(&dec, f_out);
+        huff_decoder_push(&dec, in, in_len);
+        int ret = huff_decoder_finish(&dec);
+        res->bytes_out = dec.result.bytes_out;
+        if (ret != 0) snprintf(res->msg, sizeof(res->msg), "%s", dec.result.msg);
+        return ret;
+    }
+
+    // Más hilos que núcleos o que bloques no aceleran nada y agrandarían la ventana.
+    int max_threads = huff_batch_cpu_count();
+    if (n_threads > max_threads) n_threads = max_threads;
+    if ((size_t)n_threads > index.n_blocks) n_threads = (int)index.n_blocks;
+
+    // Ventanas de unos pocos bloques por hilo (y al menos HUFF_PARALLEL_DECODE_WINDOW bytes, para
+    // no crear hilos por cada bloque pequeño): la memoria no depende de la longitud del archivo.
+    // Con bloques grandes la ventana se limita a HUFF_PARALLEL_DECODE_WINDOW_MAX bytes, pero
+    // nunca a menos de un bloque por hilo.
+    size_t window = (size_t)n_threads * 4;
+    if (window * header.block_size < HUFF_PARALLEL_DECODE_WINDOW) window = HUFF_PARALLEL_DECODE_WINDOW / header.block_size;
+    if (window * header.block_size > HUFF_PARALLEL_DECODE_WINDOW_MAX) window = HUFF_PARALLEL_DECODE_WINDOW_MAX / header.block_size;
+    if (window < (size_t)n_threads) window = (size_t)n_threads;
+    if (window > index.n_blocks) window = index.n_blocks;
+    struct huff_block_job job;
+    memset(&job, 0, sizeof(job));
+    job.in = in;
+    job.in_len = in_len;
+    job.header = &header;
+    job.index = &index;
+    job.out = (unsigned char*)malloc(window * header.block_size);
+    job.raw_len = (uint32_t*)malloc(window * sizeof(uint32_t));
+    job.err = (const char**)malloc(window * sizeof(const char*));
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)n_threads);
+    int* started = (int*)calloc((size_t)n_threads, sizeof(int));
+    pthread_mutex_init(&job.lock, NULL);
+    int ret = job.out != NULL && job.raw_len != NULL && job.err != NULL && threads != NULL && started != NULL ? 0 : -1;
+    if (ret != 0) snprintf(res->msg, sizeof(res->msg), "out of memory");
+    for (size_t first = 0; ret == 0 && first < index.n_blocks; first += window) {
+        job.first = job.next = first;
+        job.end = first + window < index.n_blocks ? first + window : index.n_blocks;
+        for (int t = 1; t < n_threads; t++) {
+            started[t] = pthread_create(&threads[t], NULL, huff_block_worker, &job) == 0;
+        }
+        huff_block_worker(&job);
+        for (int t = 1; t < n_threads; t++) {
+            if (started[t]) pthread_join(threads[t], NULL);
+        }
+        // Los huecos se escriben en orden, así que la salida es la misma que la del decodificador serie.
+        for (size_t b = first; ret == 0 && b < job.end; b++) {
+            size_t k = b - first;
+            const char* err = job.err[k];
+            if (err == NULL && ((b == 0 && index.raw_offset[0] != 0) ||
+                                (b + 1 < index.n_blocks && index.raw_offset[b + 1] - index.raw_offset[b] != job.raw_len[k]))) {
+                err = "invalid block index";
+            }
+            if (err != NULL) {
+                snprintf(res->msg, sizeof(res->msg), "%s", err);
+                ret = -1;
+            } else if (huff_stream_write(f_out, job.out + k * header.block_size, job.raw_len[k], res) != 0) {
+                ret = -1;
+            }
+        }
+    }
+    pthread_mutex_destroy(&job.lock);
+    free(threads);
+    free(started);
+    free(job.out);
+    free(job.raw_len);
+    free(job.err);
+    huff_index_free(&index);
+    return ret;
+}
+
+// Codifica todo f_in en f_out con el formato por bloques.
+int huff_encode_stream_r(FILE* f_in, FILE* f_out, const HOptions* opts, HFileResult* res) {
+    HEncoder enc;
+    unsigned char* buf = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    int ret = buf != NULL ? huff_encoder_init(&enc, f_out, opts) : -1;
+    size_t n;
+    while (ret == 0 && (n = fread(buf, 1, HUFF_IO_BUFFER_SIZE, f_in)) > 0) {
+        ret = huff_encoder_push(&enc, buf, n);
+    }
+    if (ret == 0 && ferror(f_in)) {
+        snprintf(enc.result.msg, sizeof(enc.result.msg), "cannot read input");
+        ret = -1;
+    }
+    if (buf != NULL) {
+        if (huff_encoder_finish(&enc) != 0) ret = -1;
+        *res = enc.result;
+    } else {
+        memset(res, 0, sizeof(*res));
+        snprintf(res->msg, sizeof(res->msg), "out of memory");
+    }
+    free(buf);
+    res->status = ret;
+    return ret;
+}
+
+// Decodifica un flujo por bloques leído de f_in.
+int huff_decode_stream_r(FILE* f_in, FILE* f_out, const HOptions* opts, HFileResult* res) {
+    int stats = opts ? opts->stats : 0;
+    HPhaseClock clock = {0, 0};
+    huff_phase_start(&clock, stats);
+    HDecoder dec;
+    huff_decoder_init(&dec, f_out);
+    unsigned char* buf = (unsigned char*)malloc(HUFF_IO_BUFFER_SIZE);
+    int ret = buf != NULL ? 0 : -1;
+    size_t n;
+    while (ret == 0 && (n = fread(buf, 1, HUFF_IO_BUFFER_SIZE, f_in)) > 0) {
+        ret = huff_decoder_push(&dec, buf, n);
+    }
+    if (ret == 0 && ferror(f_in)) {
+        snprintf(dec.result.msg, sizeof(dec.result.msg), "cannot read input");
+        dec.state = HUFF_DEC_ERROR;
+    }
+    if (buf == NULL) huff_decoder_fail(&dec, "out of memory");
+    ret = huff_decoder_finish(&dec);
+    *res = dec.result;
+    free(buf);
+    huff_phase_stop(&clock, stats, res, HUFF_PHASE_DECODE); // Los bloques se decodifican a medida que llegan.
+    return ret;
+}
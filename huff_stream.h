@@ -0,0 +1,87 @@
+#ifndef HUFF_STREAM_H
+#define HUFF_STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_const.h"
+#include "huff_result.h"
+#include "huff_options.h"
+#include "huff_format.h"
+#include "huff_index.h"
+
+// Codificador incremental del formato por bloques (huff_format.h).
+// Los datos se entregan en trozos de cualquier tamaño con huff_encoder_push; cada vez que se
+// completa un bloque se codifica con los códigos de su propio histograma y se escribe en f_out.
+// La memoria usada depende solo del tamaño de bloque, no de la longitud de la entrada.
+struct huff_encoder {
+	FILE*          f_out;        // Destino del flujo comprimido.
+	unsigned char* block;        // Bytes pendientes del bloque actual.
+	size_t         block_size;   // Bytes por bloque.
+	size_t         fill;         // Bytes pendientes en block.
+	int            n_streams;    // Flujos de bits por bloque.
+	unsigned char* out;          // Buffer del bloque codificado (encabezado y payload).
+	int            max_code_len; // Longitud máxima de los códigos.
+	FILE*          trace;        // Trazas del árbol (NULL = sin trazas).
+	double         cap_weight;   // Suma de cap_cost * raw_len de cada bloque.
+	HIndex         index;        // Índice de bloques y puntos de control que se escribe al final.
+	int            stats;        // 1 para medir las fases y la entropía (opts->stats).
+	HFileResult    result;       // Bytes leídos/escritos, código más largo y error.
+};
+
+// Nombre corto para el codificador incremental.
+typedef struct huff_encoder HEncoder;
+
+// Decodificador incremental del formato por bloques.
+// Acepta el flujo comprimido en trozos de cualquier tamaño; solo guarda el bloque incompleto.
+struct huff_decoder {
+	FILE*          f_out;       // Destino de los datos decodificados.
+	int            state;       // Encabezado, bloques, fin del flujo o error.
+	HStreamHeader  header;      // Encabezado del flujo (tamaño de bloque y flujos por bloque).
+	unsigned char* pending;     // Bytes de un encabezado o bloque incompleto.
+	size_t         pending_len; // Bytes en pending.
+	size_t         pending_cap; // Capacidad de pending.
+	unsigned char* out;         // Buffer de salida de un bloque.
+	HFileResult    result;      // Bytes leídos/escritos y error.
+};
+
+// Nombre corto para el decodificador incremental.
+typedef struct huff_decoder HDecoder;
+
+// Función para iniciar el codificador y escribir el encabezado del flujo en f_out.
+// opts->block_size indica los bytes por bloque (0 = HUFF_STREAM_BLOCK_SIZE) y opts->streams
+// los flujos de bits intercalados de cada bloque (huff_format.h). opts->index_interval indica los
+// bytes entre puntos de control del índice (huff_index.h). Devuelve 0 o -1.
+int huff_encoder_init(HEncoder* enc, FILE* f_out, const HOptions* opts);
+
+// Función para agregar len bytes a la entrada. Devuelve 0 o -1 si no se pudo escribir.
+int huff_encoder_push(HEncoder* enc, const unsigned char* data, size_t len);
+
+// Función para codificar el último bloque, escribir la marca de fin y el índice y liberar los buffers.
+// No cierra f_out. Devuelve 0 o -1.
+int huff_encoder_finish(HEncoder* enc);
+
+// Función para iniciar el decodificador. Devuelve 0 o -1 si no hay memoria.
+int huff_decoder_init(HDecoder* dec, FILE* f_out);
+
+// Función para entregar len bytes del flujo comprimido. Cada bloque completo se decodifica y
+// se escribe en f_out. Devuelve 0 o -1 si el flujo no es válido.
+int huff_decoder_push(HDecoder* dec, const unsigned char* data, size_t len);
+
+// Función para comprobar que el flujo terminó con su marca de fin y liberar los buffers.
+// Devuelve 0 o -1 si el flujo está truncado o tuvo errores.
+int huff_decoder_finish(HDecoder* dec);
+
+// Función para decodificar un archivo completo en el formato por bloques (in, in_len) con n_threads
+// hilos. Cada hilo decodifica bloques enteros en huecos de una ventana de salida, que se escriben
+// en orden en f_out: el resultado es idéntico al del decodificador incremental. Los bloques se
+// ubican con el índice del archivo (o recorriendo sus encabezados). Con un solo hilo, un solo
+// bloque o un flujo no válido usa el decodificador incremental. Deja bytes_out y msg en res.
+int huff_decode_blocks_parallel(const unsigned char* in, size_t in_len, FILE* f_out, int n_threads, HFileResult* res);
+
+// Función para codificar todo f_in (por ejemplo stdin) en f_out con el formato por bloques.
+int huff_encode_stream_r(FILE* f_in, FILE* f_out, const HOptions* opts, HFileResult* res);
+
+// Función para decodificar un flujo por bloques leído de f_in (por ejemplo stdin) en f_out.
+int huff_decode_stream_r(FILE* f_in, FILE* f_out, const HOptions* opts, HFileResult* res);
+
+#endif // !HUFF_STREAM_H
@@ -0,0 +1,213 @@
+#include <string.h>
+#include <errno.h>
+#include "huff_uring.h"
+#include "huff_const.h"
+
+#ifdef HUFF_IO_URING
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+// Estados de una operación del anillo.
+enum {
+    HUFF_URING_FREE,   // Sin usar.
+    HUFF_URING_QUEUE,  // Pendiente de enviar (nueva o el resto de una operación corta).
+    HUFF_URING_BUSY    // Enviada al kernel.
+};
+
+// Una operación en vuelo: el trozo [off, off + len) del archivo.
+struct huff_uring_op {
+    int      state;
+    uint64_t off;
+    uint32_t len;
+};
+
+int huff_uring_compiled(void) {
+    return 1;
+}
+
+// Crea el anillo y mapea sus colas.
+int huff_uring_init(HUring* ring, unsigned entries) {
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) return -1;
+    ring->fd = fd;
+    ring->entries = p.sq_entries;
+    ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && ring->cq_ring_size > ring->sq_ring_size) ring->sq_ring_size = ring->cq_ring_size;
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        huff_uring_free(ring);
+        return -1;
+    }
+    if (single) {
+        ring->cq_ring = ring->sq_ring;
+        ring->cq_ring_size = 0;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            huff_uring_free(ring);
+            return -1;
+        }
+    }
+    ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        huff_uring_free(ring);
+        return -1;
+    }
+    char* sq = (char*)ring->sq_ring;
+    char* cq = (char*)ring->cq_ring;
+    ring->sq_head = (unsigned*)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + p.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    ring->cqes = cq + p.cq_off.cqes;
+    return 0;
+}
+
+// Libera las regiones mapeadas y cierra el anillo.
+void huff_uring_free(HUring* ring) {
+    if (ring->sqes != NULL) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != NULL && ring->cq_ring_size > 0) munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring != NULL) munmap(ring->sq_ring, ring->sq_ring_size);
+    if (ring->fd >= 0) close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+// Agrega a la cola de envío la operación k sobre buf.
+static void huff_uring_queue(HUring* ring, int opcode, int fd, unsigned char* buf, const struct huff_uring_op* op, int k) {
+    unsigned tail = *ring->sq_tail;
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &((struct io_uring_sqe*)ring->sqes)[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t)opcode;
+    sqe->fd = fd;
+    sqe->off = op->off;
+    sqe->addr = (uint64_t)(uintptr_t)(buf + op->off);
+    sqe->len = op->len;
+    sqe->user_data = (uint64_t)k;
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE); // El kernel ve la entrada completa.
+}
+
+// Lee o escribe len bytes desde el principio del archivo, con hasta HUFF_URING_DEPTH trozos en
+// vuelo. Las operaciones cortas se vuelven a enviar con el resto del trozo.
+static int huff_uring_rw(HUring* ring, int opcode, int fd, unsigned char* buf, size_t len) {
+    struct huff_uring_op ops[HUFF_URING_DEPTH];
+    int depth = ring->entries < HUFF_URING_DEPTH ? (int)ring->entries : HUFF_URING_DEPTH;
+    memset(ops, 0, sizeof(ops));
+    size_t next = 0;     // Primer byte que todavía no se asignó a ninguna operación.
+    unsigned unsent = 0; // Entradas en la cola de envío que el kernel aún no tomó.
+    int busy = 0;        // Operaciones enviadas sin terminar.
+    int err = 0;
+    for (;;) {
+        for (int k = 0; k < depth; k++) {
+            if (ops[k].state == HUFF_URING_FREE && next < len && err == 0) {
+                size_t n = len - next < HUFF_URING_CHUNK ? len - next : HUFF_URING_CHUNK;
+                ops[k].off = next;
+                ops[k].len = (uint32_t)n;
+                ops[k].state = HUFF_URING_QUEUE;
+                next += n;
+            }
+            if (ops[k].state == HUFF_URING_QUEUE) {
+                huff_uring_queue(ring, opcode, fd, buf, &ops[k], k);
+                ops[k].state = HUFF_URING_BUSY;
+                unsent++;
+                busy++;
+            }
+        }
+        if (busy == 0) break;
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, unsent, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+            return -1; // Solo con argumentos inválidos: no quedó nada en vuelo que espere el buffer.
+        }
+        unsent -= (unsigned)submitted < unsent ? (unsigned)submitted : unsent;
+
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const struct io_uring_cqe* cqe = &((const struct io_uring_cqe*)ring->cqes)[head & *ring->cq_mask];
+            struct huff_uring_op* op = &ops[cqe->user_data];
+            int res = cqe->res;
+            busy--;
+            if (res == -EINTR || res == -EAGAIN) {
+                op->state = HUFF_URING_QUEUE;
+            } else if (res < 0 || res == 0) {
+                // Un error, o el archivo terminó antes de lo esperado.
+                if (err == 0) err = res < 0 ? -res : EIO;
+                op->state = HUFF_URING_FREE;
+            } else if ((uint32_t)res < op->len && err == 0) {
+                op->off += (uint64_t)res;
+                op->len -= (uint32_t)res;
+                op->state = HUFF_URING_QUEUE;
+            } else {
+                op->state = HUFF_URING_FREE;
+            }
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+// Lee el archivo completo.
+int huff_uring_read(HUring* ring, int fd, unsigned char* buf, size_t len) {
+    return huff_uring_rw(ring, IORING_OP_READ, fd, buf, len);
+}
+
+// Escribe el archivo completo.
+int huff_uring_write(HUring* ring, int fd, const unsigned char* buf, size_t len) {
+    return huff_uring_rw(ring, IORING_OP_WRITE, fd, (unsigned char*)buf, len);
+}
+
+#else // !HUFF_IO_URING
+
+int huff_uring_compiled(void) {
+    return 0;
+}
+
+int huff_uring_init(HUring* ring, unsigned entries) {
+    (void)entries;
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    errno = ENOSYS;
+    return -1;
+}
+
+void huff_uring_free(HUring* ring) {
+    (void)ring;
+}
+
+int huff_uring_read(HUring* ring, int fd, unsigned char* buf, size_t len) {
+    (void)ring; (void)fd; (void)buf; (void)len;
+    errno = ENOSYS;
+    return -1;
+}
+
+int huff_uring_write(HUring* ring, int fd, const unsigned char* buf, size_t len) {
+    (void)ring; (void)fd; (void)buf; (void)len;
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif // HUFF_IO_URING
@@ -0,0 +1,50 @@
+#ifndef HUFF_URING_H
+#define HUFF_URING_H
+
+#include <stddef.h>
+
+// Anillo de io_uring para leer o escribir un archivo completo con varias operaciones en vuelo
+// (HUFF_URING_DEPTH trozos de HUFF_URING_CHUNK bytes). Usa las llamadas al sistema directamente,
+// sin liburing. Solo se compila con HUFF_IO_URING (make IO_URING=1); sin él, o si el kernel no lo
+// admite, huff_uring_init devuelve -1 y el llamador usa read/write.
+// Un anillo no se comparte entre hilos: cada etapa del pipeline tiene el suyo.
+struct huff_uring {
+	int       fd;           // Descriptor del anillo (-1 = sin anillo).
+	unsigned  entries;      // Entradas de la cola de envío.
+	unsigned* sq_head;      // Cabeza de la cola de envío (la avanza el kernel).
+	unsigned* sq_tail;      // Cola de la cola de envío (la avanza el proceso).
+	unsigned* sq_mask;      // Máscara de los índices de la cola de envío.
+	unsigned* sq_array;     // Índices de las entradas enviadas.
+	unsigned* cq_head;      // Cabeza de la cola de terminación (la avanza el proceso).
+	unsigned* cq_tail;      // Cola de la cola de terminación (la avanza el kernel).
+	unsigned* cq_mask;      // Máscara de los índices de la cola de terminación.
+	void*     sqes;         // Entradas de envío (struct io_uring_sqe).
+	void*     cqes;         // Terminaciones (struct io_uring_cqe).
+	void*     sq_ring;      // Región mapeada de la cola de envío.
+	size_t    sq_ring_size; // Bytes de sq_ring.
+	void*     cq_ring;      // Región mapeada de la cola de terminación (puede ser sq_ring).
+	size_t    cq_ring_size; // Bytes de cq_ring (0 si comparte la región de sq_ring).
+	size_t    sqes_size;    // Bytes de sqes.
+};
+
+// Nombre corto para el anillo.
+typedef struct huff_uring HUring;
+
+// Función que devuelve 1 si el programa se compiló con io_uring.
+int huff_uring_compiled(void);
+
+// Función para crear un anillo con entries entradas. Devuelve 0, o -1 si io_uring no está
+// disponible (no compilado, kernel antiguo o llamada bloqueada).
+int huff_uring_init(HUring* ring, unsigned entries);
+
+// Función para liberar el anillo.
+void huff_uring_free(HUring* ring);
+
+// Función para leer los primeros len bytes de fd en buf. Devuelve 0, o -1 con errno (EINVAL si el
+// kernel no admite la operación, EIO si el archivo terminó antes).
+int huff_uring_read(HUring* ring, int fd, unsigned char* buf, size_t len);
+
+// Función para escribir len bytes de buf al principio de fd. Devuelve 0 o -1 con errno.
+int huff_uring_write(HUring* ring, int fd, const unsigned char* buf, size_t len);
+
+#endif // !HUFF_URING_H
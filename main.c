@@ -1,84 +1,658 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <dirent.h>
-#include <sys/stat.h>
-#include <errno.h>
-#include "huff_encode.h"
-#include "huff_decode.h" 
-
-void ensure_directory_exists(const char* dir_path) {
-    struct stat st = {0};
-    
-    if (stat(dir_path, &st) == -1) {
-        mkdir(dir_path, 0700);
-    }
-}
-
-int main(int argc, char* argv[]) {
-    if (argc != 5) {
-        printf("Usage: %s -e|-d <input_directory> <output_directory> <codebooks_directory>\n", argv[0]);
-        exit(EXIT_FAILURE);
-    }
-
-    int encode = 0;
-    if (strcmp(argv[1], "-e") == 0) {
-        encode = 1;
-    } else if (strcmp(argv[1], "-d") == 0) {
-        encode = 0;
-    } else {
-        printf("Invalid mode. Use -e for encode or -d for decode.\n");
-        exit(EXIT_FAILURE);
-    }
-
-    const char* input_dir = argv[2];
-    const char* output_dir = argv[3];
-    const char* codebooks_dir = argv[4];
-
-    ensure_directory_exists(output_dir);
-    ensure_directory_exists(codebooks_dir);
-
-    DIR* dir;
-    struct dirent* entry;
-
-    if ((dir = opendir(input_dir)) == NULL) {
-        perror("Failed to open input directory");
-        exit(EXIT_FAILURE);
-    }
-
-    while ((entry = readdir(dir)) != NULL) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-            continue;
-        }
-
-        char input_filepath[1024];
-        snprintf(input_filepath, sizeof(input_filepath), "%s/%s", input_dir, entry->d_name);
-
-        char output_filepath[1024];
-        snprintf(output_filepath, sizeof(output_filepath), "%s/%s", output_dir, entry->d_name);
-
-        if (encode) {
-            if (huff_encode_file(input_filepath, output_filepath, codebooks_dir) != 0) {
-                printf("Failed to encode file: %s\n", input_filepath);
-            }
-        } else {
-            // Decodificación: Se ajusta para asegurar el codebook correcto.
-            printf("Decoding file: %s\n", input_filepath);
-
-            char codebookFilename[1024];
-            // Se asume que los archivos codificados terminan en "_encoded"
-            char* encodedPosition = strstr(entry->d_name, "_encoded");
-            if (encodedPosition != NULL) {
-                *encodedPosition = '\0'; // Corta el nombre para remover "_encoded".
-            }
-            snprintf(codebookFilename, sizeof(codebookFilename), "%s/%s_codebook.txt", codebooks_dir, entry->d_name);
-
-            if (huff_decode_file(input_filepath, codebookFilename, output_filepath) != 0) {
-                printf("Failed to decode file: %s\n", input_filepath);
-            }
-        }
-    }
-
-    closedir(dir);
-    return 0;
-}
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include "huff_encode.h"
+#include "huff_decode.h"
+#include "huff_batch.h"
+#include "huff_stream.h"
+#include "huff_index.h"
+#include "huff_io.h"
+#include "huff_dict.h"
+#include "huff_stats.h"
+#include "huff_uring.h"
+#include "huff_archive.h"
+#include "huff_manifest.h"
+
+void ensure_directory_exists(const char* dir_path) {
+    struct stat st = {0};
+
+    if (stat(dir_path, &st) == -1) {
+        mkdir(dir_path, 0700);
+    }
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s -e|-d [-j N | -p N] [--pipeline [--io-uring]] [--incremental] [-t N] [-b N] [-L] [-v] [--max-len N] [--streams N] [--backend B] [--compare] <input_directory> <output_directory> [<codebooks_directory>]\n", prog);
+    printf("       %s -e|-d [-t N] [-b N] [-v] [--max-len N] [--streams N] [--backend B] [--index-interval N] <input_file> <output_file>\n", prog);
+    printf("       %s -e|-d [-t N] [-b N] [-v] [--max-len N] [--streams N] [--index-interval N] <input_file|-> <output_file|->\n", prog);
+    printf("       %s -d --range OFF:LEN <input_file> <output_file|->\n", prog);
+    printf("       %s -e|-d [-j N] --archive <archive_file> <input_directory|output_directory>\n", prog);
+    printf("       %s -d --archive <archive_file> --entry NAME <output_file|->\n", prog);
+    printf("       %s --list <archive_file>\n", prog);
+    printf("       %s --train <dict_file> [--train-sample N] [--max-len N] <input_directory>\n", prog);
+    printf("  -j N          process N files in parallel with threads (0 = one per core, default 1)\n");
+    printf("  -p N          process N files in parallel with forked worker processes (0 = one per core)\n");
+    printf("  --pipeline    overlap reading, -j N compute threads and writing through a fixed buffer pool\n");
+    printf("  --io-uring    read and write pipeline buffers with io_uring (build with make IO_URING=1)\n");
+    printf("  --incremental skip files unchanged since the last run (manifest in the output directory) and remove outputs of deleted inputs\n");
+    printf("  -t N          encode each large file, or decode each block-format file, with N threads (0 = one per core)\n");
+    printf("  -b N          encode in independent blocks of N bytes, each with its own codes (default for -)\n");
+    printf("  -L, --legacy  use the old layout: raw bitstream plus <name>_codebook.txt in <codebooks_directory>\n");
+    printf("  -v, --verbose print the tree merges and the codes of each file to stderr\n");
+    printf("  --max-len N   limit code lengths to N bits (package-merge), reporting the ratio cost\n");
+    printf("  --streams N   split each block into N interleaved bitstreams (block format, default 4)\n");
+    printf("  --backend B   entropy coder of single-block files: huffman (default), ans (rANS), order1 (codes\n");
+    printf("                conditioned on the previous byte, for text) or auto (smallest)\n");
+    printf("  --index-interval N  add an index checkpoint every N bytes of single-stream blocks (0 = block starts only)\n");
+    printf("  --range OFF:LEN decode only LEN bytes starting at byte OFF of the original file\n");
+    printf("  --train FILE  build a shared codebook from a sample of each file and save it to FILE\n");
+    printf("  --train-sample N  bytes sampled from the start of each file when training (default 1 MiB)\n");
+    printf("  --dict FILE   encode/decode with the shared codebook in FILE (single-block format)\n");
+    printf("  --dict-threshold P  use a per-file table when the shared one is more than P%% worse (default 10, -1 = never)\n");
+    printf("  --archive FILE  pack the input directory into one archive file, or extract it into the output directory\n");
+    printf("  --entry NAME  extract only the entry NAME of the archive\n");
+    printf("  --list FILE   list the entries of an archive without decoding them\n");
+    printf("  --stats FILE  append per-file and per-run statistics as JSON lines to FILE (- = stdout)\n");
+    printf("  --compare     run the batch serially, with processes, with threads and pipelined and report wall times\n");
+    printf("  -             read from stdin / write to stdout (block format, one stream)\n");
+}
+
+// Escribe las líneas JSON de un único archivo: la del archivo y la de la ejecución.
+static void write_single_stats(FILE* stats, int encode, const char* path, const HFileResult* res, double elapsed) {
+    if (stats == NULL) return;
+    HFileResult total;
+    memset(&total, 0, sizeof(total));
+    huff_stats_add(&total, res);
+    huff_stats_write_file(stats, path, encode, res);
+    huff_stats_write_run(stats, encode, &total, 1, res->status != 0, "stream", 1, elapsed);
+}
+
+// Codifica o decodifica un único flujo; "-" indica stdin o stdout.
+// No imprime nada en stdout porque puede ser la salida de datos.
+static int run_stream(int encode, const char* in_path, const char* out_path, const HOptions* opts, FILE* stats) {
+    FILE* f_in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "rb");
+    if (f_in == NULL) {
+        fprintf(stderr, "Cannot open %s\n", in_path);
+        return EXIT_FAILURE;
+    }
+    FILE* f_out = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "wb");
+    if (f_out == NULL) {
+        fprintf(stderr, "Cannot open %s\n", out_path);
+        if (f_in != stdin) fclose(f_in);
+        return EXIT_FAILURE;
+    }
+    HFileResult res;
+    int ret;
+    HInput input;
+    double t0 = huff_batch_now();
+    if (!encode && f_in != stdin && opts->threads > 1 && huff_input_open(in_path, &input) == 0) {
+        // Un archivo completo se puede decodificar por bloques en paralelo.
+        memset(&res, 0, sizeof(res));
+        HPhaseClock clock = {0, 0};
+        huff_phase_start(&clock, opts->stats);
+        ret = huff_decode_blocks_parallel(input.data, input.len, f_out, opts->threads, &res);
+        huff_phase_stop(&clock, opts->stats, &res, HUFF_PHASE_DECODE);
+        res.bytes_in = input.len;
+        huff_input_close(&input);
+    } else {
+        ret = encode ? huff_encode_stream_r(f_in, f_out, opts, &res) : huff_decode_stream_r(f_in, f_out, opts, &res);
+    }
+    if (f_in != stdin) fclose(f_in);
+    if (fflush(f_out) != 0 && ret == 0) {
+        snprintf(res.msg, sizeof(res.msg), "cannot write %s", out_path);
+        ret = -1;
+    }
+    if (f_out != stdout && fclose(f_out) != 0 && ret == 0) {
+        snprintf(res.msg, sizeof(res.msg), "cannot write %s", out_path);
+        ret = -1;
+    }
+    res.status = ret;
+    write_single_stats(stats, encode, in_path, &res, huff_batch_now() - t0);
+    if (ret != 0) {
+        fprintf(stderr, "%s: %s\n", in_path, res.msg);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+// Decodifica solo un rango del archivo original; "-" indica stdout.
+static int run_range(const char* in_path, const char* out_path, uint64_t offset, uint64_t length, FILE* stats) {
+    FILE* f_out = strcmp(out_path, "-") == 0 ? stdout : fopen(out_path, "wb");
+    if (f_out == NULL) {
+        fprintf(stderr, "Cannot open %s\n", out_path);
+        return EXIT_FAILURE;
+    }
+    HFileResult res;
+    HPhaseClock clock = {0, 0};
+    double t0 = huff_batch_now();
+    huff_phase_start(&clock, stats != NULL);
+    int ret = huff_decode_range(in_path, offset, length, f_out, &res);
+    huff_phase_stop(&clock, stats != NULL, &res, HUFF_PHASE_DECODE);
+    if (fflush(f_out) != 0 && ret == 0) {
+        snprintf(res.msg, sizeof(res.msg), "cannot write %s", out_path);
+        ret = -1;
+    }
+    if (f_out != stdout && fclose(f_out) != 0 && ret == 0) {
+        snprintf(res.msg, sizeof(res.msg), "cannot write %s", out_path);
+        ret = -1;
+    }
+    res.status = ret;
+    write_single_stats(stats, 0, in_path, &res, huff_batch_now() - t0);
+    if (ret != 0) {
+        fprintf(stderr, "%s: %s\n", in_path, res.msg);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+// Codifica o decodifica un único archivo regular en otro, igual que un lote de un solo archivo
+// (mismo formato y mismas opciones que por directorio).
+static int run_file(int encode, const char* in_path, const char* out_path, const HOptions* opts, FILE* stats,
+                    int stats_stdout) {
+    HBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.encode = encode;
+    batch.report = stats_stdout ? NULL : stdout;
+    batch.opts = opts; // Sin batch.stats: las líneas JSON las escribe write_single_stats.
+    HJob job;
+    memset(&job, 0, sizeof(job));
+    if (snprintf(job.input_path, sizeof(job.input_path), "%s", in_path) >= (int)sizeof(job.input_path) ||
+        snprintf(job.output_path, sizeof(job.output_path), "%s", out_path) >= (int)sizeof(job.output_path)) {
+        fprintf(stderr, "%s: path too long\n", in_path);
+        return EXIT_FAILURE;
+    }
+    double t0 = huff_batch_now();
+    huff_batch_run_job(&batch, &job);
+    huff_batch_report_job(&batch, &job);
+    write_single_stats(stats, encode, in_path, &job.result, huff_batch_now() - t0);
+    return job.result.status == 0 ? 0 : EXIT_FAILURE;
+}
+
+// Lista las entradas de un archivo único: tamaño original, comprimido y nombre.
+static int run_list(const char* archive_path) {
+    HArchive ar;
+    if (huff_archive_open(archive_path, &ar) != 0) {
+        fprintf(stderr, "%s is not a valid archive\n", archive_path);
+        return EXIT_FAILURE;
+    }
+    uint64_t orig = 0, comp = 0;
+    for (size_t i = 0; i < ar.n_entries; i++) {
+        const HArchiveEntry* e = &ar.entries[i];
+        printf("%12llu %12llu  %s\n", (unsigned long long)e->orig_len, (unsigned long long)e->comp_len, e->name);
+        orig += e->orig_len;
+        comp += e->comp_len;
+    }
+    printf("%12llu %12llu  %zu entries\n", (unsigned long long)orig, (unsigned long long)comp, ar.n_entries);
+    huff_archive_close(&ar);
+    return 0;
+}
+
+// Crea o extrae un archivo único; con entry extrae solo esa entrada en out_path ("-" = stdout).
+static int run_archive(int encode, const char* archive_path, const char* entry, const char* path, int n_threads,
+                       const HOptions* opts, FILE* stats, int stats_stdout) {
+    HBatch batch;
+    double t0 = huff_batch_now();
+    int failed;
+    if (encode) {
+        if (huff_batch_scan(&batch, 1, path, archive_path, NULL) != 0) {
+            perror("Failed to open input directory");
+            return EXIT_FAILURE;
+        }
+        batch.opts = opts;
+        batch.stats = stats;
+        if (stats_stdout) batch.report = NULL;
+        failed = huff_archive_create(&batch, archive_path, n_threads);
+        if (failed < 0) {
+            fprintf(stderr, "Cannot write %s\n", archive_path);
+            huff_batch_free(&batch);
+            return EXIT_FAILURE;
+        }
+    } else {
+        HArchive ar;
+        if (huff_archive_open(archive_path, &ar) != 0) {
+            fprintf(stderr, "%s is not a valid archive\n", archive_path);
+            return EXIT_FAILURE;
+        }
+        if (entry != NULL) {
+            const HArchiveEntry* e = huff_archive_find(&ar, entry);
+            if (e == NULL) {
+                fprintf(stderr, "%s: no entry %s\n", archive_path, entry);
+                huff_archive_close(&ar);
+                return EXIT_FAILURE;
+            }
+            FILE* f_out = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+            if (f_out == NULL) {
+                fprintf(stderr, "Cannot open %s\n", path);
+                huff_archive_close(&ar);
+                return EXIT_FAILURE;
+            }
+            HFileResult res;
+            int ret = huff_archive_extract_entry(&ar, e, f_out, opts, &res);
+            if (fflush(f_out) != 0 && ret == 0) {
+                snprintf(res.msg, sizeof(res.msg), "cannot write %s", path);
+                ret = -1;
+            }
+            if (f_out != stdout && fclose(f_out) != 0 && ret == 0) {
+                snprintf(res.msg, sizeof(res.msg), "cannot write %s", path);
+                ret = -1;
+            }
+            res.status = ret;
+            huff_archive_close(&ar);
+            write_single_stats(stats, 0, entry, &res, huff_batch_now() - t0);
+            if (ret != 0) {
+                fprintf(stderr, "%s: %s\n", entry, res.msg);
+                return EXIT_FAILURE;
+            }
+            return 0;
+        }
+        ensure_directory_exists(path);
+        memset(&batch, 0, sizeof(batch));
+        batch.report = stats_stdout ? NULL : stdout;
+        batch.opts = opts;
+        batch.stats = stats;
+        failed = huff_archive_extract_all(&batch, &ar, path, n_threads);
+        huff_archive_close(&ar);
+        if (failed < 0) {
+            fprintf(stderr, "out of memory\n");
+            return EXIT_FAILURE;
+        }
+    }
+    double elapsed = huff_batch_now() - t0;
+    if (!stats_stdout) huff_batch_summary(&batch, "archive", n_threads, elapsed);
+    huff_batch_stats(&batch, "archive", n_threads, elapsed);
+    huff_batch_free(&batch);
+    return failed ? EXIT_FAILURE : 0;
+}
+
+int main(int argc, char* argv[]) {
+    int encode = -1;
+    int n_threads = 1;
+    int n_procs = 0;
+    int compare = 0;
+    int pipeline = 0;
+    int use_uring = 0;
+    int incremental = 0;
+    const char* range = NULL;
+    const char* train_path = NULL;
+    const char* dict_path = NULL;
+    const char* stats_path = NULL;
+    const char* archive_path = NULL;
+    const char* entry = NULL;
+    const char* list_path = NULL;
+    long long train_sample = 0;
+    HDict dict;
+    HOptions opts;
+    huff_options_default(&opts);
+
+    static const struct option long_opts[] = {
+        {"compare", no_argument, NULL, 'C'},
+        {"legacy", no_argument, NULL, 'L'},
+        {"max-len", required_argument, NULL, 'M'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"block-size", required_argument, NULL, 'b'},
+        {"streams", required_argument, NULL, 'S'},
+        {"index-interval", required_argument, NULL, 'I'},
+        {"range", required_argument, NULL, 'R'},
+        {"train", required_argument, NULL, 'T'},
+        {"train-sample", required_argument, NULL, 'A'},
+        {"dict", required_argument, NULL, 'D'},
+        {"dict-threshold", required_argument, NULL, 'H'},
+        {"stats", required_argument, NULL, 'J'},
+        {"pipeline", no_argument, NULL, 'P'},
+        {"io-uring", no_argument, NULL, 'U'},
+        {"backend", required_argument, NULL, 'E'},
+        {"archive", required_argument, NULL, 'X'},
+        {"entry", required_argument, NULL, 'N'},
+        {"list", required_argument, NULL, 'K'},
+        {"incremental", no_argument, NULL, 'G'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "edj:p:t:b:Lv", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'e':
+            encode = 1;
+            break;
+        case 'd':
+            encode = 0;
+            break;
+        case 'j':
+            n_threads = atoi(optarg);
+            if (n_threads <= 0) n_threads = huff_batch_cpu_count();
+            break;
+        case 'p':
+            n_procs = atoi(optarg);
+            if (n_procs <= 0) n_procs = huff_batch_cpu_count();
+            break;
+        case 't':
+            opts.threads = atoi(optarg);
+            if (opts.threads <= 0) opts.threads = huff_batch_cpu_count();
+            break;
+        case 'b':
+            opts.block_size = atoi(optarg);
+            if (opts.block_size <= 0) opts.block_size = HUFF_STREAM_BLOCK_SIZE;
+            break;
+        case 'S':
+            opts.streams = atoi(optarg);
+            if (opts.streams <= 0) opts.streams = HUFF_DEFAULT_STREAMS;
+            break;
+        case 'I':
+            // 0 en la línea de comandos desactiva los puntos de control (en HOptions 0 es el valor por defecto).
+            opts.index_interval = atoi(optarg);
+            if (opts.index_interval <= 0) opts.index_interval = -1;
+            break;
+        case 'R':
+            range = optarg;
+            break;
+        case 'T':
+            train_path = optarg;
+            break;
+        case 'A':
+            train_sample = atoll(optarg);
+            break;
+        case 'D':
+            dict_path = optarg;
+            break;
+        case 'H': {
+            char extra;
+            if (sscanf(optarg, "%d%c", &opts.dict_threshold, &extra) != 1 || opts.dict_threshold < -1) {
+                fprintf(stderr, "Invalid --dict-threshold %s (a percentage, or -1)\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        }
+        case 'J':
+            stats_path = optarg;
+            break;
+        case 'P':
+            pipeline = 1;
+            break;
+        case 'U':
+            use_uring = 1;
+            break;
+        case 'E':
+            if (strcmp(optarg, "huffman") == 0) {
+                opts.backend = HUFF_BACKEND_HUFFMAN;
+            } else if (strcmp(optarg, "ans") == 0) {
+                opts.backend = HUFF_BACKEND_ANS;
+            } else if (strcmp(optarg, "auto") == 0) {
+                opts.backend = HUFF_BACKEND_AUTO;
+            } else if (strcmp(optarg, "order1") == 0) {
+                opts.backend = HUFF_BACKEND_ORDER1;
+            } else {
+                fprintf(stderr, "Unknown backend %s (huffman, ans, order1 or auto)\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'X':
+            archive_path = optarg;
+            break;
+        case 'N':
+            entry = optarg;
+            break;
+        case 'K':
+            list_path = optarg;
+            break;
+        case 'G':
+            incremental = 1;
+            break;
+        case 'L':
+            opts.legacy = 1;
+            break;
+        case 'v':
+            opts.verbose = 1;
+            break;
+        case 'M':
+            opts.max_code_len = atoi(optarg);
+            break;
+        case 'C':
+            compare = 1;
+            break;
+        default:
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (train_path != NULL) {
+        if (argc - optind != 1) {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        uint64_t sampled;
+        size_t n_files;
+        if (huff_dict_train(argv[optind], train_sample > 0 ? (size_t)train_sample : 0, opts.max_code_len, &dict, &sampled, &n_files) != 0) {
+            perror("Failed to open input directory");
+            exit(EXIT_FAILURE);
+        }
+        if (huff_dict_save(&dict, train_path) != 0) {
+            fprintf(stderr, "Cannot write %s\n", train_path);
+            exit(EXIT_FAILURE);
+        }
+        printf("dictionary %08x: %llu bytes sampled from %zu files -> %s\n", (unsigned)dict.id,
+               (unsigned long long)sampled, n_files, train_path);
+        return 0;
+    }
+    if (list_path != NULL) {
+        if (argc - optind != 0) {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        return run_list(list_path);
+    }
+    if (dict_path != NULL) {
+        if (huff_dict_load(dict_path, &dict) != 0) {
+            fprintf(stderr, "%s is not a valid dictionary\n", dict_path);
+            exit(EXIT_FAILURE);
+        }
+        opts.dict = &dict;
+    }
+    if (encode < 0) {
+        printf("Invalid mode. Use -e for encode or -d for decode.\n");
+        exit(EXIT_FAILURE);
+    }
+    // rANS y el orden 1 solo existen en el formato de un solo bloque con una tabla por archivo.
+    static const char* backend_names[] = {"huffman", "ans", "auto", "order1"};
+    if (opts.backend != HUFF_BACKEND_HUFFMAN && (opts.legacy || opts.block_size > 0 || opts.streams > 1)) {
+        fprintf(stderr, "--backend %s only applies to the single-block format (no -b, --streams or --legacy)\n",
+                backend_names[opts.backend]);
+        exit(EXIT_FAILURE);
+    }
+    if ((opts.backend == HUFF_BACKEND_ANS || opts.backend == HUFF_BACKEND_ORDER1) && opts.dict != NULL) {
+        fprintf(stderr, "--backend %s cannot be used with --dict\n", backend_names[opts.backend]);
+        exit(EXIT_FAILURE);
+    }
+    // Con "-" las líneas JSON reemplazan a la salida habitual en stdout.
+    int stats_stdout = stats_path != NULL && strcmp(stats_path, "-") == 0;
+    FILE* stats = NULL;
+    if (stats_path != NULL) {
+        stats = stats_stdout ? stdout : fopen(stats_path, "a");
+        if (stats == NULL) {
+            fprintf(stderr, "Cannot open %s\n", stats_path);
+            exit(EXIT_FAILURE);
+        }
+        opts.stats = 1;
+    }
+    // El manifiesto describe un directorio de salida con un archivo por entrada.
+    if (incremental && (archive_path != NULL || range != NULL || compare || opts.legacy)) {
+        fprintf(stderr, "--incremental applies to directory batches in the binary format (no --archive, --range, --compare or --legacy)\n");
+        exit(EXIT_FAILURE);
+    }
+    if (entry != NULL && archive_path == NULL) {
+        fprintf(stderr, "--entry needs --archive\n");
+        exit(EXIT_FAILURE);
+    }
+    if (archive_path != NULL) {
+        // Un solo argumento: el directorio de entrada o de salida, o el archivo de salida con --entry.
+        if (argc - optind != 1 || (entry != NULL && encode) || range != NULL) {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        if (opts.legacy || n_procs > 0 || pipeline) {
+            fprintf(stderr, "--archive uses threads (-j) and the binary format (no -p, --pipeline or --legacy)\n");
+            exit(EXIT_FAILURE);
+        }
+        if (stats_stdout && entry != NULL && strcmp(argv[optind], "-") == 0) {
+            fprintf(stderr, "--stats - cannot be used when the output is stdout\n");
+            exit(EXIT_FAILURE);
+        }
+        return run_archive(encode, archive_path, entry, argv[optind], n_threads, &opts, stats, stats_stdout);
+    }
+    if (range != NULL) {
+        unsigned long long offset, length;
+        char extra;
+        if (encode || argc - optind != 2 || sscanf(range, "%llu:%llu%c", &offset, &length, &extra) != 2) {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        if (stats_stdout && strcmp(argv[optind + 1], "-") == 0) {
+            fprintf(stderr, "--stats - cannot be used when the output is stdout\n");
+            exit(EXIT_FAILURE);
+        }
+        return run_range(argv[optind], argv[optind + 1], offset, length, stats);
+    }
+    // Un único flujo cuando la entrada o la salida es "-" (stdin/stdout).
+    if (argc - optind == 2 && (strcmp(argv[optind], "-") == 0 || strcmp(argv[optind + 1], "-") == 0)) {
+        if (opts.legacy) {
+            fprintf(stderr, "--legacy cannot be used with stdin/stdout\n");
+            exit(EXIT_FAILURE);
+        }
+        if (stats_stdout && strcmp(argv[optind + 1], "-") == 0) {
+            fprintf(stderr, "--stats - cannot be used when the output is stdout\n");
+            exit(EXIT_FAILURE);
+        }
+        if (opts.backend != HUFF_BACKEND_HUFFMAN) {
+            fprintf(stderr, "--backend cannot be used with stdin/stdout (block format)\n");
+            exit(EXIT_FAILURE);
+        }
+        if (incremental) {
+            fprintf(stderr, "--incremental cannot be used with stdin/stdout\n");
+            exit(EXIT_FAILURE);
+        }
+        return run_stream(encode, argv[optind], argv[optind + 1], &opts, stats);
+    }
+    // Un archivo regular se codifica o decodifica directamente en el archivo de salida.
+    struct stat in_st;
+    if (argc - optind == 2 && !opts.legacy && stat(argv[optind], &in_st) == 0 && S_ISREG(in_st.st_mode)) {
+        if (incremental || compare || pipeline || n_procs > 0) {
+            fprintf(stderr, "--incremental, --compare, --pipeline and -p apply to directory batches\n");
+            exit(EXIT_FAILURE);
+        }
+        return run_file(encode, argv[optind], argv[optind + 1], &opts, stats, stats_stdout);
+    }
+    // El directorio de codebooks solo es necesario con el formato anterior.
+    if (argc - optind != 3 && (opts.legacy || argc - optind != 2)) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (pipeline && n_procs > 0) {
+        fprintf(stderr, "--pipeline uses threads (-j), not processes (-p)\n");
+        exit(EXIT_FAILURE);
+    }
+    if (use_uring && !huff_uring_compiled()) {
+        fprintf(stderr, "--io-uring is not available in this build (make IO_URING=1)\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const char* input_dir = argv[optind];
+    const char* output_dir = argv[optind + 1];
+    const char* codebooks_dir = argc - optind == 3 ? argv[optind + 2] : NULL;
+
+    // Se comprueba la entrada antes de crear los directorios de salida.
+    if (stat(input_dir, &in_st) != 0) {
+        perror("Failed to open input directory");
+        exit(EXIT_FAILURE);
+    }
+    if (!S_ISDIR(in_st.st_mode)) {
+        errno = ENOTDIR;
+        perror("Failed to open input directory");
+        exit(EXIT_FAILURE);
+    }
+    ensure_directory_exists(output_dir);
+    if (codebooks_dir != NULL) ensure_directory_exists(codebooks_dir);
+
+    HBatch batch;
+    if (huff_batch_scan(&batch, encode, input_dir, output_dir, codebooks_dir) != 0) {
+        if (errno == ENAMETOOLONG) fprintf(stderr, "A file path under %s or %s is too long\n", input_dir, output_dir);
+        else perror("Failed to open input directory");
+        exit(EXIT_FAILURE);
+    }
+    batch.opts = &opts;
+    batch.stats = stats;
+    if (stats_stdout) batch.report = NULL;
+
+    // Con --incremental el lote se reduce a los archivos nuevos o modificados.
+    HManifest manifest;
+    if (incremental) {
+        huff_manifest_load(&manifest, output_dir, huff_manifest_options_hash(encode, &opts));
+        if (huff_manifest_filter(&manifest, &batch) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (compare) {
+        // Ejecuta el mismo lote en los cuatro modos sin imprimir cada archivo.
+        int workers = n_procs > 0 ? n_procs : (n_threads > 1 ? n_threads : huff_batch_cpu_count());
+        batch.report = NULL;
+        double t0 = huff_batch_now();
+        huff_batch_run_threads(&batch, 1);
+        double serial = huff_batch_now() - t0;
+        huff_batch_summary(&batch, "serial", 1, serial);
+        huff_batch_stats(&batch, "serial", 1, serial);
+        t0 = huff_batch_now();
+        huff_batch_run_procs(&batch, workers);
+        double forked = huff_batch_now() - t0;
+        huff_batch_summary(&batch, "fork", workers, forked);
+        huff_batch_stats(&batch, "fork", workers, forked);
+        t0 = huff_batch_now();
+        int failed = huff_batch_run_threads(&batch, workers);
+        double threaded = huff_batch_now() - t0;
+        huff_batch_summary(&batch, "thread", workers, threaded);
+        huff_batch_stats(&batch, "thread", workers, threaded);
+        t0 = huff_batch_now();
+        huff_batch_run_pipeline(&batch, workers, use_uring);
+        double piped = huff_batch_now() - t0;
+        huff_batch_summary(&batch, "pipeline", workers, piped);
+        huff_batch_stats(&batch, "pipeline", workers, piped);
+
+        printf("%-8s %8s %10s %8s\n", "mode", "workers", "wall_s", "speedup");
+        printf("%-8s %8d %10.3f %8.2f\n", "serial", 1, serial, 1.0);
+        printf("%-8s %8d %10.3f %8.2f\n", "fork", workers, forked, forked > 0 ? serial / forked : 0.0);
+        printf("%-8s %8d %10.3f %8.2f\n", "thread", workers, threaded, threaded > 0 ? serial / threaded : 0.0);
+        printf("%-8s %8d %10.3f %8.2f\n", "pipeline", workers, piped, piped > 0 ? serial / piped : 0.0);
+        huff_batch_free(&batch);
+        return failed ? EXIT_FAILURE : 0;
+    }
+
+    double t0 = huff_batch_now();
+    int failed;
+    if (n_procs > 0) {
+        failed = huff_batch_run_procs(&batch, n_procs);
+    } else if (pipeline) {
+        failed = huff_batch_run_pipeline(&batch, n_threads, use_uring);
+    } else {
+        failed = huff_batch_run_threads(&batch, n_threads);
+    }
+    double elapsed = huff_batch_now() - t0;
+
+    const char* mode = n_procs > 0 ? "fork" : (pipeline ? "pipeline" : "thread");
+    int workers = n_procs > 0 ? n_procs : n_threads;
+    if (incremental) {
+        if (huff_manifest_update(&manifest, &batch) != 0 || huff_manifest_save(&manifest) != 0) {
+            fprintf(stderr, "Cannot write %s\n", manifest.path[0] ? manifest.path : "manifest (path too long)");
+            failed++;
+        }
+        if (!stats_stdout) printf("%zu unchanged, %zu removed\n", manifest.unchanged, manifest.removed);
+        huff_manifest_free(&manifest);
+    }
+    if (!stats_stdout) huff_batch_summary(&batch, mode, workers, elapsed);
+    huff_batch_stats(&batch, mode, workers, elapsed);
+    huff_batch_free(&batch);
+    return failed ? EXIT_FAILURE : 0;
+}